@@ -0,0 +1,81 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BENCHMARKHELPER_H
+#define BENCHMARKHELPER_H
+
+/*!
+ * \brief benchmark-helper
+ * <br>
+ * The helpers shared by the memory benchmarks, they create the synthetic
+ * infos without touching the file system and read the resident memory.
+ * </br>
+ */
+
+#include <QFile>
+#include <QString>
+
+#include <file-info.h>
+#include <file-info-job.h>
+
+#include <gio/gio.h>
+#include <unistd.h>
+
+namespace Peony {
+
+class BenchmarkInfoJob : public FileInfoJob
+{
+public:
+    static void fill(const std::shared_ptr<FileInfo> &info, GFileInfo *gInfo) {
+        FileInfoJob::refreshInfoContents(info, gInfo);
+    }
+};
+
+static inline qint64 residentBytes()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    auto fields = statm.readAll().split(' ');
+    if (fields.count() < 2)
+        return 0;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+static inline GFileInfo *createSyntheticInfo(int index)
+{
+    GFileInfo *gInfo = g_file_info_new();
+    QByteArray name = QString("file-%1.o").arg(index).toUtf8();
+    g_file_info_set_file_type(gInfo, G_FILE_TYPE_REGULAR);
+    g_file_info_set_name(gInfo, name.constData());
+    g_file_info_set_display_name(gInfo, name.constData());
+    g_file_info_set_content_type(gInfo, "application/x-object");
+    g_file_info_set_size(gInfo, 4096 + index);
+    g_file_info_set_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED, 1577836800 + index);
+    g_file_info_set_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_TIME_ACCESS, 1577836800 + index);
+    g_file_info_set_attribute_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, TRUE);
+    g_file_info_set_attribute_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, TRUE);
+    g_file_info_set_attribute_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, FALSE);
+    return gInfo;
+}
+
+}
+
+#endif // BENCHMARKHELPER_H
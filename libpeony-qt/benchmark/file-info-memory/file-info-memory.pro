@@ -0,0 +1,19 @@
+QT       += core
+
+TARGET = file-info-memory
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11 console
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt.pri)
+
+INCLUDEPATH += $$PWD/..
+
+HEADERS += \
+        ../benchmark-helper.h
+
+SOURCES += \
+        main.cpp
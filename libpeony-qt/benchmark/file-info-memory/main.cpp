@@ -0,0 +1,77 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \brief file-info-memory
+ * <br>
+ * Creates a large number of hashed FileInfo and fills them with a synthetic
+ * GFileInfo, then prints the resident memory cost per entry. Usage:
+ * file-info-memory [count], the default count is 1000000.
+ * </br>
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <file-info.h>
+#include <file-info-manager.h>
+
+#include "benchmark-helper.h"
+
+using namespace Peony;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int count = 1000000;
+    if (argc > 1)
+        count = QString(argv[1]).toInt();
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    infos.reserve(count);
+
+    qint64 before = residentBytes();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < count; i++) {
+        auto info = FileInfo::fromUri(QString("file:///tmp/peony-benchmark/file-%1.o").arg(i));
+        GFileInfo *gInfo = createSyntheticInfo(i);
+        BenchmarkInfoJob::fill(info, gInfo);
+        g_object_unref(gInfo);
+        infos<<info;
+    }
+
+    qint64 after = residentBytes();
+    qint64 elapsed = timer.elapsed();
+
+    qInfo()<<"entries:"<<count<<"hashed:"<<FileInfoManager::getInstance()->count();
+    qInfo()<<"elapsed:"<<elapsed<<"ms";
+    qInfo()<<"resident delta:"<<(after - before)/1024<<"KiB";
+    if (count > 0)
+        qInfo()<<"bytes per entry:"<<(after - before)/count;
+
+    infos.clear();
+    qInfo()<<"hashed after release:"<<FileInfoManager::getInstance()->count();
+
+    return 0;
+}
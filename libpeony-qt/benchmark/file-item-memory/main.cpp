@@ -0,0 +1,113 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \brief file-item-memory
+ * <br>
+ * Fills a FileItemModel with a large number of rows of synthetic infos, then
+ * prints the resident memory cost per row of the infos and of the items.
+ * Usage: file-item-memory [count] [--legacy], the default count is 100000.
+ * </br>
+ * <br>
+ * With --legacy, every item also gets an idle FileEnumerator like FileItem
+ * used to create in its constructor, so the cost before and after dropping
+ * it can be compared in one build.
+ * </br>
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <file-info.h>
+#include <file-enumerator.h>
+#include <file-item.h>
+#include <file-item-model.h>
+
+#include "benchmark-helper.h"
+
+using namespace Peony;
+
+class BenchmarkRootItem : public FileItem
+{
+public:
+    using FileItem::FileItem;
+
+    void append(FileItem *child) {
+        appendChild(child);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int count = 100000;
+    bool legacy = false;
+    for (int i = 1; i < argc; i++) {
+        if (QString(argv[i]) == "--legacy") {
+            legacy = true;
+        } else {
+            count = QString(argv[i]).toInt();
+        }
+    }
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    infos.reserve(count);
+
+    qint64 start = residentBytes();
+    for (int i = 0; i < count; i++) {
+        auto info = FileInfo::fromUri(QString("file:///tmp/peony-benchmark/file-%1.o").arg(i));
+        GFileInfo *gInfo = createSyntheticInfo(i);
+        BenchmarkInfoJob::fill(info, gInfo);
+        g_object_unref(gInfo);
+        infos<<info;
+    }
+    qint64 infosLoaded = residentBytes();
+
+    auto model = new FileItemModel;
+    auto root = new BenchmarkRootItem(FileInfo::fromUri("file:///tmp/peony-benchmark"), nullptr, model);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (auto info : infos) {
+        auto item = new FileItem(info, root, model);
+        if (legacy)
+            new FileEnumerator(item);
+        root->append(item);
+    }
+    qint64 elapsed = timer.elapsed();
+    qint64 itemsLoaded = residentBytes();
+
+    qInfo()<<"rows:"<<count<<(legacy? "(with per-item enumerators)": "");
+    qInfo()<<"sizeof(FileItem):"<<sizeof(FileItem);
+    qInfo()<<"items created in:"<<elapsed<<"ms";
+    qInfo()<<"infos resident delta:"<<(infosLoaded - start)/1024<<"KiB";
+    qInfo()<<"items resident delta:"<<(itemsLoaded - infosLoaded)/1024<<"KiB";
+    if (count > 0)
+        qInfo()<<"item bytes per row:"<<(itemsLoaded - infosLoaded)/count;
+
+    timer.restart();
+    delete root;
+    qInfo()<<"items deleted in:"<<timer.elapsed()<<"ms";
+
+    delete model;
+    return 0;
+}
@@ -0,0 +1,14 @@
+QT       += core gui widgets
+
+TARGET = local-enumeration
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11 console
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt.pri)
+
+SOURCES += \
+        main.cpp
@@ -0,0 +1,115 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \brief local-enumeration
+ * <br>
+ * Compares the GIO path and the native path of FileEnumerator on local
+ * directories with 10k, 100k and 1M entries. The directories are created
+ * in the temp directory at the first run and reused later. Usage:
+ * local-enumeration [count...], for example local-enumeration 10000 100000.
+ * </br>
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QDebug>
+
+#include <file-enumerator.h>
+#include <file-info.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Peony;
+
+static QString prepareDirectory(int count)
+{
+    QString path = QDir::tempPath() + QString("/peony-local-enumeration-%1").arg(count);
+    QDir dir(path);
+    if (dir.exists() && int(dir.count()) - 2 == count)
+        return path;
+
+    qInfo()<<"creating"<<count<<"files in"<<path;
+    dir.mkpath(path);
+    for (int i = 0; i < count; i++) {
+        QByteArray filePath = QString("%1/file-%2.txt").arg(path).arg(i).toUtf8();
+        int fd = open(filePath.constData(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            if (i % 2)
+                write(fd, "peony", 5);
+            close(fd);
+        }
+    }
+    return path;
+}
+
+static qint64 enumerate(const QString &path, bool native, bool fullInfo, int *childrenCount)
+{
+    FileEnumerator enumerator;
+    enumerator.setEnumerateDirectory("file://" + path);
+    enumerator.setNativeBackendEnabled(native);
+    enumerator.setQueryFullInfo(fullInfo);
+
+    QElapsedTimer timer;
+    timer.start();
+    enumerator.enumerateSync();
+    auto children = enumerator.getChildren();
+    qint64 elapsed = timer.elapsed();
+
+    *childrenCount = children.count();
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    QList<int> counts;
+    for (int i = 1; i < argc; i++) {
+        counts<<QString(argv[i]).toInt();
+    }
+    if (counts.isEmpty())
+        counts<<10000<<100000<<1000000;
+
+    for (int count : counts) {
+        QString path = prepareDirectory(count);
+        int childrenCount = 0;
+
+        //warm the dentry and inode caches, so that both paths start equally.
+        enumerate(path, true, false, &childrenCount);
+
+        for (bool fullInfo : {false, true}) {
+            qint64 gio = enumerate(path, false, fullInfo, &childrenCount);
+            int gioCount = childrenCount;
+            qint64 native = enumerate(path, true, fullInfo, &childrenCount);
+
+            qInfo()<<"entries:"<<count<<(fullInfo? "full info": "names only")
+                   <<"gio:"<<gio<<"ms"<<"native:"<<native<<"ms"
+                   <<"speedup:"<<(native > 0? double(gio)/native: 0.0)
+                   <<"children:"<<gioCount<<childrenCount;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \brief sort-keys
+ * <br>
+ * Sorts 200k generated file names by every column with FileItemSortKey, and
+ * by name with the string comparison FileItemProxyFilterSortModel used before
+ * the keys, which ran the duplicated name regular expressions and lowercased
+ * both names at every comparison.
+ * </br>
+ */
+
+#include <QtTest>
+
+#include <file-item-model.h>
+#include <file-item-sort-key.h>
+#include <file-operation-utils.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace Peony;
+
+#define NAME_COUNT 200000
+
+class SortKeys : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void sortByKey_data();
+    void sortByKey();
+
+    void sortByLegacyName();
+
+private:
+    QStringList m_names;
+    std::vector<FileItemSortKey> m_keys;
+};
+
+void SortKeys::initTestCase()
+{
+    const QStringList types = {"Text", "Image", "Video", "Folder", "Archive", "Document"};
+    m_names.reserve(NAME_COUNT);
+    m_keys.reserve(NAME_COUNT);
+    for (int i = 0; i < NAME_COUNT; i++) {
+        QString name;
+        switch (i % 4) {
+        case 0:
+            name = QString("file-%1.txt").arg(i);
+            break;
+        case 1:
+            name = QString("Report (%1).doc").arg(i % 1000);
+            break;
+        case 2:
+            name = QString::fromUtf8("文件%1").arg(i);
+            break;
+        default:
+            name = QString("IMG_%1.JPG").arg(NAME_COUNT - i);
+            break;
+        }
+        m_names<<name;
+        m_keys.push_back(FileItemSortKey(name, types.at(i % types.count()), quint64(i) * 7919 % 100003, quint64(i) * 104729 % 1000003, i % 10 == 0));
+    }
+}
+
+void SortKeys::sortByKey_data()
+{
+    QTest::addColumn<int>("column");
+    QTest::newRow("name")<<int(FileItemModel::FileName);
+    QTest::newRow("size")<<int(FileItemModel::FileSize);
+    QTest::newRow("type")<<int(FileItemModel::FileType);
+    QTest::newRow("modified date")<<int(FileItemModel::ModifiedDate);
+}
+
+void SortKeys::sortByKey()
+{
+    QFETCH(int, column);
+    QVector<int> rows(NAME_COUNT);
+    QBENCHMARK {
+        std::iota(rows.begin(), rows.end(), 0);
+        std::stable_sort(rows.begin(), rows.end(), [=](int left, int right) {
+            return FileItemSortKey::lessThan(m_keys.at(left), m_keys.at(right), column, Qt::AscendingOrder, true, true);
+        });
+    }
+    QCOMPARE(rows.count(), NAME_COUNT);
+}
+
+void SortKeys::sortByLegacyName()
+{
+    QVector<int> rows(NAME_COUNT);
+    QBENCHMARK_ONCE {
+        std::iota(rows.begin(), rows.end(), 0);
+        std::stable_sort(rows.begin(), rows.end(), [=](int left, int right) {
+            const QString &leftName = m_names.at(left);
+            const QString &rightName = m_names.at(right);
+            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftName, rightName))
+                return FileOperationUtils::leftNameLesserThanRightName(leftName, rightName);
+            return leftName.toLower() < rightName.toLower();
+        });
+    }
+    QCOMPARE(rows.count(), NAME_COUNT);
+}
+
+QTEST_GUILESS_MAIN(SortKeys)
+
+#include "main.moc"
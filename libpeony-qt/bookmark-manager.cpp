@@ -21,8 +21,8 @@
  */
 
 #include "bookmark-manager.h"
+#include "io-executor.h"
 
-#include <QtConcurrent>
 #include <glib.h>
 
 #include <QDebug>
@@ -41,7 +41,7 @@ BookMarkManager *BookMarkManager::getInstance()
 
 BookMarkManager::BookMarkManager(QObject *parent) : QObject(parent)
 {
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         m_book_mark = new QSettings(QSettings::UserScope, "org.ukui", "peony-qt");
         m_uris = m_book_mark->value("uris").toStringList();
         m_is_loaded = true;
@@ -60,7 +60,7 @@ BookMarkManager::~BookMarkManager()
 
 void BookMarkManager::addBookMark(const QString &uri)
 {
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         while (!this->isLoaded()) {
             g_usleep(100);
         }
@@ -85,7 +85,7 @@ void BookMarkManager::addBookMark(const QString &uri)
 
 void BookMarkManager::removeBookMark(const QString &uri)
 {
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         while (!this->isLoaded()) {
             g_usleep(100);
         }
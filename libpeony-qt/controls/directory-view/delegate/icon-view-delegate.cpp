@@ -28,6 +28,7 @@
 
 #include "file-operation-manager.h"
 #include "file-rename-operation.h"
+#include "icon-pixmap-cache.h"
 
 #include <QDebug>
 #include <QLabel>
@@ -47,6 +48,9 @@
 #include "icon-view-index-widget.h"
 
 #include <QPushButton>
+#include <QTextLayout>
+#include <QGlyphRun>
+#include <QCache>
 
 #include "clipboard-utils.h"
 
@@ -130,7 +134,13 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 
     auto text = opt.text;
     opt.text = nullptr;
+    //the decoration is blitted from IconPixmapCache instead of being rasterized by the style.
+    QIcon decoration = opt.icon;
+    opt.icon = QIcon();
     style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+    auto decorationRect = style->subElementRect(QStyle::SE_ItemViewItemDecoration, &opt, opt.widget);
+    IconPixmapCache::getInstance()->paintDecoration(painter, decoration, decorationRect, opt);
+    opt.icon = decoration;
     opt.text = text;
     //auto textSize = IconViewTextHelper::getTextSizeForIndex(opt, index, 2, 2);
     painter->save();
@@ -168,9 +178,8 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 
     //paint symbolic link emblems
     if (info->isSymbolLink()) {
-        QIcon icon = QIcon::fromTheme("emblem-symbolic-link");
         //qDebug()<<info->symbolicIconName();
-        icon.paint(painter, rect.x() + rect.width() - 30, rect.y() + 10, 20, 20, Qt::AlignCenter);
+        IconPixmapCache::getInstance()->paintEmblem(painter, "emblem-symbolic-link", QRect(rect.x() + rect.width() - 30, rect.y() + 10, 20, 20));
     }
 
     //paint access emblems
@@ -178,11 +187,9 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     //NOTE: we can not query the file attribute in smb:///(samba) and network:///.
     if (info->uri().startsWith("file:")) {
         if (!info->canRead()) {
-            QIcon icon = QIcon::fromTheme("emblem-unreadable");
-            icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
+            IconPixmapCache::getInstance()->paintEmblem(painter, "emblem-unreadable", QRect(rect.x() + 10, rect.y() + 10, 20, 20));
         } else if (!info->canWrite() && !info->canExecute()) {
-            QIcon icon = QIcon::fromTheme("emblem-readonly");
-            icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
+            IconPixmapCache::getInstance()->paintEmblem(painter, "emblem-readonly", QRect(rect.x() + 10, rect.y() + 10, 20, 20));
         }
         painter->restore();
         return;
@@ -324,6 +331,34 @@ const QBrush IconViewDelegate::selectedBrush() const
     return m_styled_button->palette().highlight();
 }
 
+/*!
+ * \brief The IconViewTextLayout struct
+ * A laid out label, the glyph runs of every painted line and the position
+ * they should be drawn at.
+ */
+struct IconViewTextLayout
+{
+    QVector<QPair<QPointF, QGlyphRun>> glyph_runs;
+};
+
+static QCache<QString, IconViewTextLayout> *textLayoutCache()
+{
+    static QCache<QString, IconViewTextLayout> cache(PEONY_ICON_VIEW_TEXT_CACHE_MAX_COUNT);
+    return &cache;
+}
+
+static QCache<QString, int> *textLineCountCache()
+{
+    static QCache<QString, int> cache(PEONY_ICON_VIEW_TEXT_CACHE_MAX_COUNT);
+    return &cache;
+}
+
+void IconViewTextHelper::clearCache()
+{
+    textLayoutCache()->clear();
+    textLineCountCache()->clear();
+}
+
 QSize IconViewTextHelper::getTextSizeForIndex(const QStyleOptionViewItem &option, const QModelIndex &index, int horizalMargin, int maxLineCount)
 {
     int fixedWidth = option.rect.width() - horizalMargin*2;
@@ -331,27 +366,36 @@ QSize IconViewTextHelper::getTextSizeForIndex(const QStyleOptionViewItem &option
     QFont font = option.font;
     QFontMetrics fontMetrics = option.fontMetrics;
     int lineSpacing = fontMetrics.lineSpacing();
-    int textHight = 0;
 
-    QTextLayout textLayout(text, font);
+    QString key = QString("%1\n%2\n").arg(font.key()).arg(fixedWidth) + text;
+    int *cachedLineCount = textLineCountCache()->object(key);
+    int lineCount = 0;
+    if (cachedLineCount) {
+        lineCount = *cachedLineCount;
+    } else {
+        QTextLayout textLayout(text, font);
+
+        QTextOption opt;
+        opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        opt.setAlignment(Qt::AlignHCenter);
 
-    QTextOption opt;
-    opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-    opt.setAlignment(Qt::AlignHCenter);
+        textLayout.setTextOption(opt);
+        textLayout.beginLayout();
 
-    textLayout.setTextOption(opt);
-    textLayout.beginLayout();
+        while (true) {
+            QTextLine line = textLayout.createLine();
+            if (!line.isValid())
+                break;
 
-    while (true) {
-        QTextLine line = textLayout.createLine();
-        if (!line.isValid())
-            break;
+            line.setLineWidth(fixedWidth);
+            lineCount++;
+        }
 
-        line.setLineWidth(fixedWidth);
-        textHight += lineSpacing;
+        textLayout.endLayout();
+        textLineCountCache()->insert(key, new int(lineCount));
     }
 
-    textLayout.endLayout();
+    int textHight = lineCount * lineSpacing;
     if (maxLineCount > 0) {
         textHight = qMin(maxLineCount * lineSpacing, textHight);
     }
@@ -371,50 +415,83 @@ void IconViewTextHelper::paintText(QPainter *painter, const QStyleOptionViewItem
             painter->setPen(option.palette.text().color());
     }
 
-    int lineCount = 0;
-
     QString text = option.text;
     QFont font = option.font;
-    QFontMetrics fontMetrics = option.fontMetrics;
-    int lineSpacing = fontMetrics.lineSpacing();
-
-    QTextLayout textLayout(text, font);
-
-    QTextOption opt;
-    opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-    opt.setAlignment(Qt::AlignHCenter);
+    int width = option.rect.width() - 2*horizalMargin;
 
-    textLayout.setTextOption(opt);
-    textLayout.beginLayout();
+    QString key = QString("%1\n%2\n%3\n%4\n%5\n").arg(font.key()).arg(width).arg(textMaxHeight).arg(maxLineCount).arg(horizalMargin) + text;
+    IconViewTextLayout *layout = textLayoutCache()->object(key);
+    if (!layout) {
+        layout = new IconViewTextLayout;
+
+        int lineCount = 0;
+        QFontMetrics fontMetrics = option.fontMetrics;
+        int lineSpacing = fontMetrics.lineSpacing();
+
+        QTextLayout textLayout(text, font);
+
+        QTextOption opt;
+        opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        opt.setAlignment(Qt::AlignHCenter);
+
+        textLayout.setTextOption(opt);
+        textLayout.beginLayout();
+
+        //the lines painted as they are, and their y.
+        QVector<QPair<int, int>> lines;
+        QString elidedLastLine;
+        int elidedLastLineY = -1;
+
+        int y = 0;
+        while (true) {
+            QTextLine line = textLayout.createLine();
+            if (!line.isValid())
+                break;
+
+            line.setLineWidth(width);
+            int nextLineY = y + lineSpacing;
+            lineCount++;
+
+            if (textMaxHeight >= nextLineY + lineSpacing && lineCount != maxLineCount) {
+                lines<<qMakePair(line.lineNumber(), y);
+                y = nextLineY;
+            } else {
+                QString lastLine = text.mid(line.textStart());
+                elidedLastLine = fontMetrics.elidedText(lastLine, Qt::ElideRight, width);
+                elidedLastLineY = y;
+                break;
+            }
+        }
+        textLayout.endLayout();
 
-    int width = option.rect.width() - 2*horizalMargin;
+        for (const auto &line : lines) {
+            for (auto glyphRun : textLayout.lineAt(line.first).glyphRuns()) {
+                layout->glyph_runs<<qMakePair(QPointF(0, line.second), glyphRun);
+            }
+        }
 
-    int y = 0;
-    while (true) {
-        QTextLine line = textLayout.createLine();
-        if (!line.isValid())
-            break;
-
-        line.setLineWidth(width);
-        int nextLineY = y + lineSpacing;
-        lineCount++;
-
-        if (textMaxHeight >= nextLineY + lineSpacing && lineCount != maxLineCount) {
-            line.draw(painter, QPoint(0, y));
-            y = nextLineY;
-        } else {
-            QString lastLine = option.text.mid(line.textStart());
-            QString elidedLastLine = fontMetrics.elidedText(lastLine, Qt::ElideRight, width);
-            auto rect = QRect(horizalMargin, y /*+ fontMetrics.ascent()*/, width, textMaxHeight);
-            //opt.setWrapMode(QTextOption::NoWrap);
+        if (elidedLastLineY >= 0) {
+            QTextLayout elidedLayout(elidedLastLine, font);
             opt.setWrapMode(QTextOption::NoWrap);
-            painter->drawText(rect, elidedLastLine, opt);
-            //painter->drawText(QPoint(0, y + fontMetrics.ascent()), elidedLastLine);
-            line = textLayout.createLine();
-            break;
+            elidedLayout.setTextOption(opt);
+            elidedLayout.beginLayout();
+            QTextLine elidedLine = elidedLayout.createLine();
+            if (elidedLine.isValid())
+                elidedLine.setLineWidth(width);
+            elidedLayout.endLayout();
+            if (elidedLine.isValid()) {
+                for (auto glyphRun : elidedLine.glyphRuns()) {
+                    layout->glyph_runs<<qMakePair(QPointF(horizalMargin, elidedLastLineY), glyphRun);
+                }
+            }
         }
+
+        textLayoutCache()->insert(key, layout);
+    }
+
+    for (const auto &glyphRun : layout->glyph_runs) {
+        painter->drawGlyphRun(glyphRun.first, glyphRun.second);
     }
-    textLayout.endLayout();
 
     painter->restore();
 }
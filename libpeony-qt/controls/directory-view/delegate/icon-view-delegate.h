@@ -25,6 +25,14 @@
 
 #include <QStyledItemDelegate>
 
+/*!
+ * \brief PEONY_ICON_VIEW_TEXT_CACHE_MAX_COUNT
+ * The max count of laid out labels IconViewTextHelper keeps.
+ */
+#ifndef PEONY_ICON_VIEW_TEXT_CACHE_MAX_COUNT
+#define PEONY_ICON_VIEW_TEXT_CACHE_MAX_COUNT 4096
+#endif
+
 class QPushButton;
 
 namespace Peony {
@@ -76,8 +84,25 @@ private:
     QPushButton *m_styled_button;
 };
 
+/*!
+ * \brief The IconViewTextHelper class
+ * <br>
+ * IconViewTextHelper wraps and elides the labels of icon views. The laid out
+ * labels are kept in a bounded cache keyed by the text, the font, the width and
+ * the line limits, so painting a label again only replays its glyph runs.
+ * </br>
+ */
 class IconViewTextHelper
 {
+public:
+    /*!
+     * \brief clearCache
+     * Drop all the laid out labels, it should be called once the views zoomed.
+     * A changed font doesn't need it, as the font is a part of the cache key.
+     */
+    static void clearCache();
+
+private:
     friend class IconViewDelegate;
     friend class IconViewIndexWidget;
     friend class Peony::DesktopIndexWidget;
@@ -38,6 +38,7 @@
 #include "file-info.h"
 #include "file-item-proxy-filter-sort-model.h"
 #include "file-item.h"
+#include "icon-pixmap-cache.h"
 
 #include <QDebug>
 
@@ -196,9 +197,8 @@ void IconViewIndexWidget::paintEvent(QPaintEvent *e)
     auto info = m_info.lock();
     //paint symbolic link emblems
     if (info->isSymbolLink()) {
-        QIcon icon = QIcon::fromTheme("emblem-symbolic-link");
         //qDebug()<< "symbolic:" << info->symbolicIconName();
-        icon.paint(&p, this->width() - 30, 10, 20, 20, Qt::AlignCenter);
+        IconPixmapCache::getInstance()->paintEmblem(&p, "emblem-symbolic-link", QRect(this->width() - 30, 10, 20, 20));
     }
 
     //paint access emblems
@@ -209,11 +209,9 @@ void IconViewIndexWidget::paintEvent(QPaintEvent *e)
 
     auto rect = this->rect();
     if (!info->canRead()) {
-        QIcon icon = QIcon::fromTheme("emblem-unreadable");
-        icon.paint(&p, rect.x() + 10, rect.y() + 10, 20, 20);
+        IconPixmapCache::getInstance()->paintEmblem(&p, "emblem-unreadable", QRect(rect.x() + 10, rect.y() + 10, 20, 20));
     } else if (!info->canWrite() && !info->canExecute()) {
-        QIcon icon = QIcon::fromTheme("emblem-readonly");
-        icon.paint(&p, rect.x() + 10, rect.y() + 10, 20, 20);
+        IconPixmapCache::getInstance()->paintEmblem(&p, "emblem-readonly", QRect(rect.x() + 10, rect.y() + 10, 20, 20));
     }
 }
 
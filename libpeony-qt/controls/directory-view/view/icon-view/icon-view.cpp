@@ -30,6 +30,7 @@
 #include "file-info.h"
 
 #include "global-settings.h"
+#include "icon-pixmap-cache.h"
 
 #include <QMouseEvent>
 
@@ -311,6 +312,7 @@ void IconView::resizeEvent(QResizeEvent *e)
     //but I have to reset the index widget in view's resize.
     QListView::resizeEvent(e);
     setIndexWidget(m_last_index, nullptr);
+    scheduleReportVisibleRange();
 }
 
 void IconView::wheelEvent(QWheelEvent *e)
@@ -358,6 +360,50 @@ void IconView::slotRename()
 
 }
 
+void IconView::scheduleReportVisibleRange()
+{
+    if (!m_visible_range_timer.isActive())
+        m_visible_range_timer.start();
+}
+
+void IconView::reportVisibleRange()
+{
+    if (!m_sort_filter_proxy_model)
+        return;
+
+    int rowCount = m_sort_filter_proxy_model->rowCount();
+    if (rowCount == 0)
+        return;
+
+    //the rows are laid out in order, find the ones in viewport by binary search.
+    int viewportHeight = viewport()->height();
+    int low = 0;
+    int high = rowCount;
+    while (low < high) {
+        int mid = (low + high)/2;
+        if (QListView::visualRect(m_sort_filter_proxy_model->index(mid, 0)).bottom() < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int first = low;
+
+    high = rowCount;
+    while (low < high) {
+        int mid = (low + high)/2;
+        if (QListView::visualRect(m_sort_filter_proxy_model->index(mid, 0)).top() < viewportHeight) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int last = low - 1;
+
+    if (first <= last)
+        m_sort_filter_proxy_model->setVisibleRows(first, last);
+}
+
 bool IconView::getIgnore_mouse_move_event() const
 {
     return m_ignore_mouse_move_event;
@@ -375,6 +421,16 @@ void IconView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
 
     setModel(m_sort_filter_proxy_model);
 
+    //the thumbnails and infos are loaded for the visible window first.
+    m_visible_range_timer.setSingleShot(true);
+    m_visible_range_timer.setInterval(100);
+    connect(&m_visible_range_timer, &QTimer::timeout, this, &IconView::reportVisibleRange, Qt::UniqueConnection);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &IconView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::layoutChanged, this, &IconView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::rowsInserted, this, &IconView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::rowsRemoved, this, &IconView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::modelReset, this, &IconView::scheduleReportVisibleRange, Qt::UniqueConnection);
+
     //edit trigger
     connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection) {
         qDebug()<<"selection changed";
@@ -473,7 +529,7 @@ QRect IconView::visualRect(const QModelIndex &index) const
 
 int IconView::getSortType()
 {
-    int type = m_sort_filter_proxy_model->sortColumn();
+    int type = m_sort_filter_proxy_model->requestedSortColumn();
     return type<0? 0: type;
 }
 
@@ -484,7 +540,7 @@ void IconView::setSortType(int sortType)
 
 int IconView::getSortOrder()
 {
-    return m_sort_filter_proxy_model->sortOrder();
+    return m_sort_filter_proxy_model->requestedSortOrder();
 }
 
 void IconView::setSortOrder(int sortOrder)
@@ -605,6 +661,10 @@ void IconView2::setCurrentZoomLevel(int zoomLevel)
         //FIXME: implement zoom
         int base = 64 - 25; //50
         int adjusted = base + zoomLevel;
+        //the labels are wrapped with new width.
+        IconViewTextHelper::clearCache();
+        //the decorations are rasterized with new size.
+        IconPixmapCache::getInstance()->clear();
         m_view->setIconSize(QSize(adjusted, adjusted));
         m_view->setGridSize(m_view->itemDelegate()->sizeHint(QStyleOptionViewItem(), QModelIndex()) + QSize(20, 20));
     }
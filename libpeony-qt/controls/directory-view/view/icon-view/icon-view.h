@@ -158,8 +158,18 @@ protected:
 private Q_SLOTS:
     void slotRename();
 
+    /*!
+     * \brief scheduleReportVisibleRange
+     * Report the rows in viewport to the proxy model after the view scrolled,
+     * resized or relayouted, at most once in a short interval.
+     * \see FileItemProxyFilterSortModel::setVisibleRows().
+     */
+    void scheduleReportVisibleRange();
+    void reportVisibleRange();
+
 private:
     QTimer m_repaint_timer;
+    QTimer m_visible_range_timer;
 
     bool  m_editValid;
     bool  m_ctrl_key_pressed;
@@ -102,6 +102,16 @@ void ListView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
     //adjust columns layout.
     adjustColumnsSize();
 
+    //the thumbnails and infos are loaded for the visible window first.
+    m_visible_range_timer.setSingleShot(true);
+    m_visible_range_timer.setInterval(100);
+    connect(&m_visible_range_timer, &QTimer::timeout, this, &ListView::reportVisibleRange, Qt::UniqueConnection);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &ListView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_proxy_model, &QAbstractItemModel::layoutChanged, this, &ListView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_proxy_model, &QAbstractItemModel::rowsInserted, this, &ListView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_proxy_model, &QAbstractItemModel::rowsRemoved, this, &ListView::scheduleReportVisibleRange, Qt::UniqueConnection);
+    connect(m_proxy_model, &QAbstractItemModel::modelReset, this, &ListView::scheduleReportVisibleRange, Qt::UniqueConnection);
+
     //fix diffcult to unselect all item issue
     connect(this->selectionModel(), &QItemSelectionModel::currentColumnChanged, [=]
             (const QModelIndex &current, const QModelIndex &previous) {
@@ -336,6 +346,7 @@ void ListView::resizeEvent(QResizeEvent *e)
         m_last_size = size();
         adjustColumnsSize();
     }
+    scheduleReportVisibleRange();
 }
 
 void ListView::updateGeometries()
@@ -378,6 +389,50 @@ void ListView::slotRename()
 
 }
 
+void ListView::scheduleReportVisibleRange()
+{
+    if (!m_visible_range_timer.isActive())
+        m_visible_range_timer.start();
+}
+
+void ListView::reportVisibleRange()
+{
+    if (!m_proxy_model)
+        return;
+
+    int rowCount = m_proxy_model->rowCount();
+    if (rowCount == 0)
+        return;
+
+    //the rows are laid out in order, find the ones in viewport by binary search.
+    int viewportHeight = viewport()->height();
+    int low = 0;
+    int high = rowCount;
+    while (low < high) {
+        int mid = (low + high)/2;
+        if (QTreeView::visualRect(m_proxy_model->index(mid, 0)).bottom() < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int first = low;
+
+    high = rowCount;
+    while (low < high) {
+        int mid = (low + high)/2;
+        if (QTreeView::visualRect(m_proxy_model->index(mid, 0)).top() < viewportHeight) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int last = low - 1;
+
+    if (first <= last)
+        m_proxy_model->setVisibleRows(first, last);
+}
+
 void ListView::setProxy(DirectoryViewProxyIface *proxy)
 {
 
@@ -505,7 +560,7 @@ void ListView::setCutFiles(const QStringList &uris)
 
 int ListView::getSortType()
 {
-    int type = m_proxy_model->sortColumn();
+    int type = m_proxy_model->requestedSortColumn();
     return type<0? 0: type;
 }
 
@@ -516,7 +571,7 @@ void ListView::setSortType(int sortType)
 
 int ListView::getSortOrder()
 {
-    return m_proxy_model->sortOrder();
+    return m_proxy_model->requestedSortOrder();
 }
 
 void ListView::setSortOrder(int sortOrder)
@@ -129,10 +129,22 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+
+    /*!
+     * \brief scheduleReportVisibleRange
+     * Report the rows in viewport to the proxy model after the view scrolled,
+     * resized or relayouted, at most once in a short interval.
+     * \see FileItemProxyFilterSortModel::setVisibleRows().
+     */
+    void scheduleReportVisibleRange();
+    void reportVisibleRange();
+
 private:
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
 
+    QTimer m_visible_range_timer;
+
     QTimer* m_renameTimer;
     bool  m_editValid;
     bool  m_ctrl_key_pressed;
@@ -29,6 +29,7 @@
 
 #include "menu-plugin-manager.h"
 #include "file-info.h"
+#include "file-info-job.h"
 
 #include "directory-view-factory-manager.h"
 #include "view-factory-model.h"
@@ -257,6 +258,10 @@ const QList<QAction *> DirectoryViewMenu::constructOpenOpActions()
                 QStringList files;
                 for (auto uri : m_selections) {
                     auto info = FileInfo::fromUri(uri);
+                    if (!info->isFileTypeResolved()) {
+                        FileInfoJob j(info);
+                        j.querySync();
+                    }
                     if (info->isDir() || info->isVolume()) {
                         dirs<<uri;
                     } else {
@@ -39,8 +39,6 @@
 #include <QLocale>
 #include <QDateTime>
 
-#include <QThreadPool>
-
 #include <QResizeEvent>
 
 #include <QImageReader>
@@ -56,6 +54,7 @@
 #include "file-info-job.h"
 
 #include "file-count-operation.h"
+#include "io-executor.h"
 
 using namespace Peony;
 
@@ -83,9 +82,7 @@ DefaultPreviewPage::DefaultPreviewPage(QWidget *parent) : QStackedWidget (parent
 
 DefaultPreviewPage::~DefaultPreviewPage()
 {
-    if (m_info && m_info.use_count() <= 2) {
-        FileInfoManager::getInstance()->remove(m_info);
-    }
+
 }
 
 bool DefaultPreviewPage::eventFilter(QObject *obj, QEvent *ev)
@@ -282,11 +279,15 @@ void FilePreviewPage::countAsync(const QString &uri)
     QStringList uris;
     uris<<uri;
     auto info = FileInfo::fromUri(uri);
+    if (!info->isFileTypeResolved()) {
+        FileInfoJob j(info);
+        j.querySync();
+    }
     m_count_op = new FileCountOperation(uris, !info->isDir());
     connect(m_count_op, &FileOperation::operationStarted, this, &FilePreviewPage::resetCount, Qt::BlockingQueuedConnection);
     connect(m_count_op, &FileOperation::operationPreparedOne, this, &FilePreviewPage::onPreparedOne, Qt::BlockingQueuedConnection);
     connect(m_count_op, &FileCountOperation::countDone, this, &FilePreviewPage::onCountDone, Qt::BlockingQueuedConnection);
-    QThreadPool::globalInstance()->start(m_count_op);
+    IoExecutor::getInstance()->start(m_count_op, IoExecutor::Background);
 }
 
 void FilePreviewPage::updateCount()
@@ -39,8 +39,8 @@
 #include "file-watcher.h"
 
 #include "file-count-operation.h"
+#include "io-executor.h"
 
-#include <QThreadPool>
 #include <QFileInfo>
 
 using namespace Peony;
@@ -223,7 +223,7 @@ void BasicPropertiesPage::countFilesAsync(const QStringList &uris)
         this->updateCountInfo();
     });
 
-    QThreadPool::globalInstance()->start(m_count_op);
+    IoExecutor::getInstance()->start(m_count_op, IoExecutor::Background);
 }
 
 void BasicPropertiesPage::onFileCountOne(const QString &uri, quint64 size)
@@ -26,6 +26,7 @@
 #include "directory-view-plugin-iface.h"
 #include "directory-view-widget.h"
 #include "file-info.h"
+#include "file-info-job.h"
 #include "file-utils.h"
 
 #include "file-launch-manager.h"
@@ -100,17 +101,24 @@ void TabPage::rebindContainer()
         m_double_click_limiter.start(500);
 
         qDebug()<<"tab page double clicked"<<uri;
-        auto info = Peony::FileInfo::fromUri(uri, false);
+        auto info = Peony::FileInfo::fromUri(uri);
         if (info->uri().startsWith("trash://")) {
             auto w = new PropertiesWindow(QStringList()<<uri);
             w->show();
             return;
         }
-        if (info->isDir() || info->isVolume() || info->isVirtual()) {
-            Q_EMIT this->updateWindowLocationRequest(uri);
-        } else {
-            FileLaunchManager::openAsync(uri, false, false);
-        }
+        //the type is usually known by the view's model, otherwise
+        //resolve it asynchronously.
+        auto job = new FileInfoJob(info);
+        job->setAutoDelete();
+        job->connect(job, &FileInfoJob::queryAsyncFinished, this, [=]() {
+            if (info->isDir() || info->isVolume() || info->isVirtual()) {
+                Q_EMIT this->updateWindowLocationRequest(uri);
+            } else {
+                FileLaunchManager::openAsync(uri, false, false);
+            }
+        });
+        job->queryFileTypeAsync();
     });
 
     container->connect(container, &DirectoryViewContainer::updateWindowLocationRequest,
@@ -0,0 +1,156 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "desktop-entry-cache.h"
+
+#include <QMutexLocker>
+#include <QLocale>
+
+#include <gio/gdesktopappinfo.h>
+#include <sys/stat.h>
+
+using namespace Peony;
+
+static qint64 fileModifiedTime(const QByteArray &path, bool *exists)
+{
+    struct stat st;
+    if (stat(path.constData(), &st) != 0) {
+        *exists = false;
+        return 0;
+    }
+    *exists = true;
+    return qint64(st.st_mtime);
+}
+
+static QString takeString(char *string)
+{
+    QString result = QString::fromUtf8(string);
+    g_free(string);
+    return result;
+}
+
+DesktopEntryCache *DesktopEntryCache::getInstance()
+{
+    //the cache might be used in worker threads at first time.
+    static DesktopEntryCache *global_instance = new DesktopEntryCache;
+    return global_instance;
+}
+
+std::shared_ptr<DesktopEntry> DesktopEntryCache::parse(const QString &path, qint64 modifiedTime)
+{
+    auto entry = std::make_shared<DesktopEntry>();
+    entry->path = path;
+    entry->modified_time = modifiedTime;
+
+    GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(path.toUtf8().constData());
+    if (!desktop_info)
+        return entry;
+
+    entry->is_valid = true;
+#if GLIB_CHECK_VERSION(2, 56, 0)
+    entry->locale_name = takeString(g_desktop_app_info_get_locale_string(desktop_info, "Name"));
+#else
+    //FIXME: should handle locale?
+    //change "Name" to QLocale::system().name(),
+    //try to fix Qt5.6 untranslated desktop file issue
+    auto key = "Name[" +  QLocale::system().name() + "]";
+    entry->locale_name = takeString(g_desktop_app_info_get_string(desktop_info, key.toUtf8().constData()));
+#endif
+    entry->name = takeString(g_desktop_app_info_get_string(desktop_info, "Name"));
+    entry->icon = takeString(g_desktop_app_info_get_string(desktop_info, "Icon"));
+    entry->exec = takeString(g_desktop_app_info_get_string(desktop_info, "Exec"));
+    entry->is_terminal = g_desktop_app_info_get_boolean(desktop_info, "Terminal");
+    entry->is_no_display = g_desktop_app_info_get_nodisplay(desktop_info);
+    entry->is_hidden = g_desktop_app_info_get_is_hidden(desktop_info);
+
+    g_object_unref(desktop_info);
+    return entry;
+}
+
+std::shared_ptr<const DesktopEntry> DesktopEntryCache::entry(const QString &path, qint64 modifiedTime)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        checkLanguage();
+        auto cached = m_entries.object(path);
+        if (cached && (modifiedTime < 0 || (*cached)->modified_time == modifiedTime))
+            return *cached;
+    }
+
+    bool exists = false;
+    qint64 mtime = fileModifiedTime(path.toUtf8(), &exists);
+    if (!exists) {
+        remove(path);
+        return nullptr;
+    }
+
+    //parse outside of the lock, the other threads might be parsing other launchers.
+    std::shared_ptr<const DesktopEntry> parsed = parse(path, mtime);
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(path, new std::shared_ptr<const DesktopEntry>(parsed));
+    return parsed;
+}
+
+void DesktopEntryCache::checkLanguage()
+{
+    //g_desktop_app_info_get_locale_string() looks up the names in the languages of glib.
+    const gchar * const *languages = g_get_language_names();
+    const char *language = languages && languages[0]? languages[0]: "";
+    if (m_language == language)
+        return;
+
+    m_language = language;
+    m_entries.clear();
+}
+
+QString DesktopEntryCache::displayName(const QString &path)
+{
+    auto desktopEntry = entry(path);
+    if (!desktopEntry || !desktopEntry->is_valid)
+        return nullptr;
+
+    if (!desktopEntry->locale_name.isEmpty())
+        return desktopEntry->locale_name;
+
+    QString fileName = path.section('/', -1);
+    QString systemPath = "/usr/share/applications/" + fileName;
+    if (systemPath != path) {
+        auto systemEntry = entry(systemPath);
+        if (systemEntry && !systemEntry->locale_name.isEmpty())
+            return systemEntry->locale_name;
+    }
+
+    if (!desktopEntry->name.isEmpty())
+        return desktopEntry->name;
+    return nullptr;
+}
+
+void DesktopEntryCache::remove(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.remove(path);
+}
+
+void DesktopEntryCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
@@ -0,0 +1,143 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DESKTOPENTRYCACHE_H
+#define DESKTOPENTRYCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+
+#include <memory>
+
+/*!
+ * \brief PEONY_DESKTOP_ENTRY_CACHE_MAX_COUNT
+ * The max count of the cached entries, the least recently used ones are dropped first.
+ */
+#ifndef PEONY_DESKTOP_ENTRY_CACHE_MAX_COUNT
+#define PEONY_DESKTOP_ENTRY_CACHE_MAX_COUNT 4096
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The DesktopEntry struct
+ * <br>
+ * The values of a parsed .desktop launcher. If is_valid is false, gio can
+ * not create a GDesktopAppInfo from the file, such as a hidden launcher
+ * or a broken file, and the other values are empty.
+ * </br>
+ */
+struct DesktopEntry
+{
+    QString path;
+    /*!
+     * \brief modified_time
+     * The modified time of the file in seconds when it was parsed.
+     */
+    qint64 modified_time = 0;
+
+    bool is_valid = false;
+
+    QString locale_name;
+    QString name;
+    QString icon;
+    QString exec;
+
+    bool is_terminal = false;
+    bool is_no_display = false;
+    bool is_hidden = false;
+};
+
+/*!
+ * \brief The DesktopEntryCache class
+ * <br>
+ * DesktopEntryCache parses every .desktop launcher once, and shares the
+ * parsed entry with the info jobs, the thumbnailer and the desktop. A lookup
+ * doesn't touch the file, FileWatcher removes the entries of the launchers
+ * which are changed in the watched directories, and a caller which has just
+ * stated the file can pass its modified time for checking the entry.
+ * </br>
+ * <br>
+ * The localized names depend on the languages of glib, all the entries are
+ * dropped when they change.
+ * </br>
+ * <br>
+ * The cache is thread safe. The listings warm it in their worker threads,
+ * see FileInfoBatchJob::querySync() and LocalDirectoryReader::read(),
+ * so that the gui thread rarely parses a launcher itself.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT DesktopEntryCache
+{
+public:
+    static DesktopEntryCache *getInstance();
+
+    /*!
+     * \brief entry
+     * \param path, the local path of a .desktop file.
+     * \param modifiedTime, the modified time in seconds if the caller knows it, or -1.
+     * \return the parsed entry of the file, or nullptr if the file doesn't exist.
+     * <br>
+     * If the file is not cached or is modified after the cached entry was parsed,
+     * it is parsed in the calling thread.
+     * </br>
+     */
+    std::shared_ptr<const DesktopEntry> entry(const QString &path, qint64 modifiedTime = -1);
+
+    /*!
+     * \brief displayName
+     * \param path
+     * \return the name should be displayed for the launcher, or a null string
+     * if it is not a valid launcher.
+     * <br>
+     * The localized name is preferred, then the localized name of the launcher with
+     * the same file name in /usr/share/applications, then the untranslated name.
+     * </br>
+     */
+    QString displayName(const QString &path);
+
+    void remove(const QString &path);
+    void clear();
+
+    static bool isDesktopFilePath(const QString &path) {
+        return path.endsWith(".desktop");
+    }
+
+private:
+    DesktopEntryCache() : m_entries(PEONY_DESKTOP_ENTRY_CACHE_MAX_COUNT) {}
+    static std::shared_ptr<DesktopEntry> parse(const QString &path, qint64 modifiedTime);
+    void checkLanguage();
+
+    QCache<QString, std::shared_ptr<const DesktopEntry>> m_entries;
+    /*!
+     * \brief m_language
+     * The first language of glib when the cached entries were parsed.
+     */
+    QByteArray m_language;
+    QMutex m_mutex;
+};
+
+}
+
+#endif // DESKTOPENTRYCACHE_H
@@ -23,6 +23,7 @@
 #include "file-enumerator.h"
 #include "file-info.h"
 #include "file-info-manager.h"
+#include "file-info-job.h"
 
 #include "mount-operation.h"
 
@@ -35,12 +36,28 @@
 #include <QMessageBox>
 
 #include <QDebug>
-#include <QTimer>
+#include <QFutureWatcher>
 
+#include <climits>
+
+/*!
+ * \brief PEONY_FIND_NEXT_FILES_BATCH_SIZE
+ * The size of the first batch in async enumeration. It should be small enough
+ * to fill the first screen of a view quickly.
+ */
 #ifndef PEONY_FIND_NEXT_FILES_BATCH_SIZE
 #define PEONY_FIND_NEXT_FILES_BATCH_SIZE 100
 #endif
 
+/*!
+ * \brief PEONY_FIND_NEXT_FILES_MAX_BATCH_SIZE
+ * The batch size is doubled after every batch until it reaches this value,
+ * so that a huge directory doesn't need thousands of round trips.
+ */
+#ifndef PEONY_FIND_NEXT_FILES_MAX_BATCH_SIZE
+#define PEONY_FIND_NEXT_FILES_MAX_BATCH_SIZE 6400
+#endif
+
 using namespace Peony;
 
 FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
@@ -49,6 +66,8 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
     m_cancellable = g_cancellable_new();
 
     m_children_uris = new QList<QString>();
+    m_children_infos = new QList<std::shared_ptr<FileInfo>>();
+    m_children_types = new QList<GFileType>();
 
     connect(this, &FileEnumerator::enumerateFinished, this, [=]() {
         if (m_auto_delete) {
@@ -60,30 +79,48 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
 /*!
  * \brief FileEnumerator::~FileEnumerator
  * \note
- * When a file enumerator instance in deconstructor,
- * we need consider if we need free the data of info.
- * If only global hash hold the shared data, it should.
- * <br>
- * It's just an insurance measure, we usually manage children list in other classes.
- * So, usually there's no data being released here.
- * You can notice that the use count of info should be free is 3. because temporary list,
- * list element and global hash will all hold one shared_ptr here.
- * \see FileInfo::~FileInfo()
- * </br>
+ * The infos held by enumerator will be released with their last holder,
+ * FileInfoManager only holds weak references, so we don't need to free
+ * the data of infos here.
+ * \see FileInfoManager
  */
 FileEnumerator::~FileEnumerator()
 {
     disconnect();
     //qDebug()<<"~FileEnumerator";
+    clearPrepared();
+    //the pending callbacks must not touch a destroyed enumerator.
+    g_cancellable_cancel(m_cancellable);
     g_object_unref(m_root_file);
     g_object_unref(m_cancellable);
 
     delete m_children_uris;
+    delete m_children_infos;
+    delete m_children_types;
+}
+
+void FileEnumerator::setCancellationGroup(IoCancellationGroup *group)
+{
+    if (m_io_group)
+        disconnect(m_io_group, &IoCancellationGroup::cancelled, this, &FileEnumerator::cancel);
+
+    m_io_group = group;
+    if (group)
+        connect(group, &IoCancellationGroup::cancelled, this, &FileEnumerator::cancel);
+}
+
+const IoCancellationToken FileEnumerator::ioToken()
+{
+    if (m_io_group)
+        return m_io_group->token();
+    return IoCancellationToken();
 }
 
 void FileEnumerator::setEnumerateDirectory(QString uri)
 {
     uri.replace("#", "%23");
+    m_local_reader.reset();
+    clearPrepared();
     if (m_cancellable) {
         g_cancellable_cancel(m_cancellable);
         g_object_unref(m_cancellable);
@@ -110,6 +147,8 @@ void FileEnumerator::setEnumerateDirectory(QString uri)
 
 void FileEnumerator::setEnumerateDirectory(GFile *file)
 {
+    m_local_reader.reset();
+    clearPrepared();
     if (m_cancellable) {
         g_cancellable_cancel(m_cancellable);
         g_object_unref(m_cancellable);
@@ -125,9 +164,16 @@ void FileEnumerator::setEnumerateDirectory(GFile *file)
 const QList<std::shared_ptr<FileInfo>> FileEnumerator::getChildren(bool addToHash)
 {
     //qDebug()<<"FileEnumerator::getChildren():";
+    if (m_query_full_info) {
+        //the children infos were filled and added into hash while enumerating.
+        return *m_children_infos;
+    }
+
     QList<std::shared_ptr<FileInfo>> children;
-    for (auto uri : *m_children_uris) {
-        auto file_info = FileInfo::fromUri(uri, addToHash);
+    for (int i = 0; i < m_children_uris->count(); i++) {
+        auto file_info = FileInfo::fromUri(m_children_uris->at(i), addToHash);
+        if (!file_info->isFileTypeResolved())
+            file_info->setFileType(m_children_types->at(i));
         children<<file_info;
     }
     return children;
@@ -135,38 +181,82 @@ const QList<std::shared_ptr<FileInfo>> FileEnumerator::getChildren(bool addToHas
 
 void FileEnumerator::cancel()
 {
+    m_local_reader.reset();
+    clearPrepared();
     g_cancellable_cancel(m_cancellable);
     g_object_unref(m_cancellable);
     m_cancellable = g_cancellable_new();
 
     m_children_uris->clear();
+    m_children_infos->clear();
+    m_children_types->clear();
 
     Q_EMIT enumerateFinished(false);
 }
 
 void FileEnumerator::prepare()
 {
-    GError *err = nullptr;
-    GFileEnumerator *enumerator = g_file_enumerate_children(m_root_file,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                  G_FILE_QUERY_INFO_NONE,
-                                  m_cancellable,
-                                  &err);
+    clearPrepared();
+    m_prepared_query_full_info = m_query_full_info;
 
-    if (err) {
-        //do not send prepared(err) here, wait handle err finished.
-        handleError(err);
-        g_error_free(err);
-    } else {
-        //even though there is no err, we still need to wait a little while
-        //for confirming other object will recieve this signal, you can aslo
-        //connect prepared signal before prepared() method to confirm that.
-        //Q_EMIT prepared(nullptr);
-        g_object_unref(enumerator);
+    if (prepareLocalAsync())
+        return;
+
+    prepareGioAsync();
+}
+
+bool FileEnumerator::prepareLocalAsync()
+{
+    if (!m_native_backend_enabled)
+        return false;
+
+    QByteArray path = LocalDirectoryReader::nativePath(m_root_file);
+    if (path.isEmpty())
+        return false;
+
+    auto reader = std::make_shared<LocalDirectoryReader>(path, m_query_full_info);
+    m_prepared_local_reader = reader;
+
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        watcher->deleteLater();
+        //cancelled or prepared again.
+        if (reader != m_prepared_local_reader || watcher->isCanceled())
+            return;
+
+        if (!watcher->result()) {
+            //let GIO open the directory, it knows how to handle the errors.
+            m_prepared_local_reader.reset();
+            prepareGioAsync();
+            return;
+        }
+
+        Q_EMIT prepared(nullptr);
+    });
 
-        QTimer::singleShot(100, this, [=]() {
-            Q_EMIT prepared(nullptr);
-        });
+    watcher->setFuture(IoExecutor::getInstance()->run<bool>(m_io_priority, [=]() {
+        return reader->open();
+    }, ioToken()));
+    return true;
+}
+
+void FileEnumerator::prepareGioAsync()
+{
+    g_file_enumerate_children_async(m_root_file,
+                                    queryAttributes(),
+                                    G_FILE_QUERY_INFO_NONE,
+                                    IoExecutor::ioPriority(m_io_priority),
+                                    m_cancellable,
+                                    GAsyncReadyCallback(prepare_async_ready_callback),
+                                    this);
+}
+
+void FileEnumerator::clearPrepared()
+{
+    m_prepared_local_reader.reset();
+    if (m_prepared_enumerator) {
+        g_object_unref(m_prepared_enumerator);
+        m_prepared_enumerator = nullptr;
     }
 }
 
@@ -193,12 +283,183 @@ GFile *FileEnumerator::enumerateTargetFile()
     return target;
 }
 
+const char *FileEnumerator::queryAttributes()
+{
+    if (m_query_full_info)
+        return FileInfoJob::listingQueryAttributes(m_root_file);
+    //the type is cheap in enumeration, and FileInfo::fromUri() won't query it.
+    return G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE;
+}
+
+QString FileEnumerator::addChild(GFileEnumerator *enumerator, GFileInfo *info)
+{
+    QString childUri;
+    GFile *child = g_file_enumerator_get_child(enumerator, info);
+    char *uri = g_file_get_uri(child);
+    char *path = g_file_get_path(child);
+    g_object_unref(child);
+    //qDebug()<<uri;
+    if (path) {
+        childUri = QString("file://%1").arg(path);
+        g_free(path);
+    } else {
+        childUri = uri;
+    }
+    g_free(uri);
+
+    *m_children_uris<<childUri;
+    *m_children_types<<g_file_info_get_file_type(info);
+
+    if (m_query_full_info) {
+        auto childInfo = FileInfo::fromUri(childUri);
+        FileInfoJob::refreshInfoContents(childInfo, info);
+        *m_children_infos<<childInfo;
+    }
+
+    return childUri;
+}
+
+QString FileEnumerator::addLocalChild(LocalDirectoryReader *reader, const LocalDirectoryEntry &entry)
+{
+    QString childUri = reader->childUri(entry);
+
+    *m_children_uris<<childUri;
+    *m_children_types<<entry.type;
+
+    if (m_query_full_info) {
+        auto childInfo = FileInfo::fromUri(childUri);
+        FileInfoJob::refreshInfoContents(childInfo, entry);
+        *m_children_infos<<childInfo;
+    }
+
+    return childUri;
+}
+
+bool FileEnumerator::enumerateLocalSync()
+{
+    if (!m_native_backend_enabled)
+        return false;
+
+    QByteArray path = LocalDirectoryReader::nativePath(m_root_file);
+    if (path.isEmpty())
+        return false;
+
+    auto reader = m_prepared_local_reader;
+    m_prepared_local_reader.reset();
+    if (!reader) {
+        reader = std::make_shared<LocalDirectoryReader>(path, m_query_full_info);
+        if (!reader->open())
+            return false;
+    }
+
+    QVector<LocalDirectoryEntry> entries;
+    reader->read(entries, INT_MAX);
+    for (const auto &entry : entries) {
+        addLocalChild(reader.get(), entry);
+    }
+
+    //keep the same behavior with enumerateChildren().
+    Q_EMIT enumerateFinished(!entries.isEmpty());
+    return true;
+}
+
+bool FileEnumerator::enumerateLocalAsync()
+{
+    if (m_prepared_local_reader) {
+        //opened by prepare(), start reading directly.
+        m_local_reader = m_prepared_local_reader;
+        m_prepared_local_reader.reset();
+        m_batch_size = PEONY_FIND_NEXT_FILES_BATCH_SIZE;
+        readLocalChildrenAsync();
+        return true;
+    }
+
+    if (!m_native_backend_enabled)
+        return false;
+
+    QByteArray path = LocalDirectoryReader::nativePath(m_root_file);
+    if (path.isEmpty())
+        return false;
+
+    m_local_reader = std::make_shared<LocalDirectoryReader>(path, m_query_full_info);
+    m_batch_size = PEONY_FIND_NEXT_FILES_BATCH_SIZE;
+    readLocalChildrenAsync(true);
+    return true;
+}
+
+void FileEnumerator::readLocalChildrenAsync(bool open)
+{
+    auto reader = m_local_reader;
+    int batchSize = m_batch_size;
+
+    auto watcher = new QFutureWatcher<QVector<LocalDirectoryEntry>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        watcher->deleteLater();
+        //cancelled or restarted.
+        if (reader != m_local_reader || watcher->isCanceled())
+            return;
+
+        if (open && !reader->isOpened()) {
+            //let GIO handle the directory, it knows how to report the errors.
+            m_local_reader.reset();
+            enumerateGioAsync();
+            return;
+        }
+
+        auto entries = watcher->result();
+        bool atEnd = reader->atEnd();
+        if (!atEnd) {
+            m_batch_size = qMin(m_batch_size*2, PEONY_FIND_NEXT_FILES_MAX_BATCH_SIZE);
+            readLocalChildrenAsync();
+        }
+
+        QStringList uriList;
+        for (const auto &entry : entries) {
+            uriList<<addLocalChild(reader.get(), entry);
+        }
+        if (!uriList.isEmpty())
+            Q_EMIT childrenUpdated(uriList);
+
+        if (atEnd) {
+            m_local_reader.reset();
+            Q_EMIT enumerateFinished(true);
+        }
+    });
+
+    watcher->setFuture(IoExecutor::getInstance()->run<QVector<LocalDirectoryEntry>>(m_io_priority, [=]() {
+        QVector<LocalDirectoryEntry> entries;
+        if (open && !reader->open())
+            return entries;
+        reader->read(entries, batchSize);
+        return entries;
+    }, ioToken()));
+}
+
 void FileEnumerator::enumerateSync()
 {
+    if (m_prepared_query_full_info != m_query_full_info)
+        clearPrepared();
+
+    if (enumerateLocalSync())
+        return;
+
     GFile *target = enumerateTargetFile();
 
+    if (m_prepared_enumerator && g_file_equal(target, m_root_file)) {
+        //opened by prepare().
+        GFileEnumerator *enumerator = m_prepared_enumerator;
+        m_prepared_enumerator = nullptr;
+        enumerateChildren(enumerator);
+
+        g_file_enumerator_close_async(enumerator, 0, nullptr, nullptr, nullptr);
+        g_object_unref(enumerator);
+        g_object_unref(target);
+        return;
+    }
+    clearPrepared();
+
     GFileEnumerator *enumerator = g_file_enumerate_children(target,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                  queryAttributes(),
                                   G_FILE_QUERY_INFO_NONE,
                                   m_cancellable,
                                   nullptr);
@@ -294,43 +555,61 @@ void FileEnumerator::handleError(GError *err)
 }
 
 void FileEnumerator::enumerateAsync()
+{
+    if (m_prepared_query_full_info != m_query_full_info)
+        clearPrepared();
+
+    if (m_prepared_enumerator) {
+        //opened by prepare(), stream the children directly.
+        GFileEnumerator *enumerator = m_prepared_enumerator;
+        m_prepared_enumerator = nullptr;
+        nextFilesAsync(enumerator);
+        g_object_unref(enumerator);
+        return;
+    }
+
+    if (enumerateLocalAsync())
+        return;
+
+    enumerateGioAsync();
+}
+
+void FileEnumerator::enumerateGioAsync()
 {
     //auto uri = g_file_get_uri(m_root_file);
     //auto path = g_file_get_path(m_root_file);
     g_file_enumerate_children_async(m_root_file,
-                                    G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    queryAttributes(),
                                     G_FILE_QUERY_INFO_NONE,
-                                    G_PRIORITY_DEFAULT,
+                                    IoExecutor::ioPriority(m_io_priority),
                                     m_cancellable,
                                     GAsyncReadyCallback(find_children_async_ready_callback),
                                     this);
 
 }
 
+void FileEnumerator::nextFilesAsync(GFileEnumerator *enumerator)
+{
+    //start with a small batch, see enumerator_next_files_async_ready_callback().
+    m_batch_size = PEONY_FIND_NEXT_FILES_BATCH_SIZE;
+    g_file_enumerator_next_files_async(enumerator,
+                                       m_batch_size,
+                                       IoExecutor::ioPriority(m_io_priority),
+                                       m_cancellable,
+                                       GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
+                                       this);
+}
+
 void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
 {
     GFileInfo *info = nullptr;
-    GFile *child = nullptr;
     info = g_file_enumerator_next_file(enumerator, m_cancellable, nullptr);
     if (!info) {
         Q_EMIT enumerateFinished(false);
         return;
     }
     while (info) {
-        child = g_file_enumerator_get_child(enumerator, info);
-        char *uri = g_file_get_uri(child);
-        char *path = g_file_get_path(child);
-        g_object_unref(child);
-        //qDebug()<<uri;
-        if (path) {
-            QString localUri = QString("file://%1").arg(path);
-            *m_children_uris<<localUri;
-            g_free(path);
-        } else {
-            *m_children_uris<<uri;
-        }
-
-        g_free(uri);
+        addChild(enumerator, info);
         g_object_unref(info);
         info = g_file_enumerator_next_file(enumerator, m_cancellable, nullptr);
     }
@@ -343,6 +622,10 @@ GAsyncReadyCallback FileEnumerator::mount_mountable_callback(GFile *file,
 {
     GError *err = nullptr;
     GFile *target = g_file_mount_mountable_finish(file, res, &err);
+    if (err && err->code == G_IO_ERROR_CANCELLED) {
+        g_error_free(err);
+        return nullptr;
+    }
     if (err && err->code != 0) {
         qDebug()<<err->code<<err->message;
         auto err_data = GErrorWrapper::wrapFrom(err);
@@ -373,6 +656,10 @@ GAsyncReadyCallback FileEnumerator::mount_enclosing_volume_callback(GFile *file,
         }
     } else {
         if (err) {
+            if (err->code == G_IO_ERROR_CANCELLED) {
+                g_error_free(err);
+                return nullptr;
+            }
             if (err->code == G_IO_ERROR_ALREADY_MOUNTED) {
                 Q_EMIT p_this->prepared(GErrorWrapper::wrapFrom(err));
                 return nullptr;
@@ -411,6 +698,30 @@ GAsyncReadyCallback FileEnumerator::mount_enclosing_volume_callback(GFile *file,
     return nullptr;
 }
 
+GAsyncReadyCallback FileEnumerator::prepare_async_ready_callback(GFile *file,
+        GAsyncResult *res,
+        FileEnumerator *p_this)
+{
+    GError *err = nullptr;
+    GFileEnumerator *enumerator = g_file_enumerate_children_finish(file, res, &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            //the enumerator might be destroyed.
+            g_error_free(err);
+            return nullptr;
+        }
+        //do not send prepared(err) here, wait handle err finished.
+        p_this->handleError(err);
+        g_error_free(err);
+        return nullptr;
+    }
+
+    //keep the opened directory for enumerating, see enumerateAsync().
+    p_this->m_prepared_enumerator = enumerator;
+    Q_EMIT p_this->prepared(nullptr);
+    return nullptr;
+}
+
 GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *file,
         GAsyncResult *res,
         FileEnumerator *p_this)
@@ -418,6 +729,10 @@ GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *fi
     GError *err = nullptr;
     GFileEnumerator *enumerator = g_file_enumerate_children_finish(file, res, &err);
     if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return nullptr;
+        }
         qDebug()<<"find children async err:"<<err->code<<err->message;
         //NOTE: if the enumerator file has target uri, but target uri is not mounted,
         //it should be handled.
@@ -425,18 +740,15 @@ GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *fi
         if (err->code == G_IO_ERROR_NOT_MOUNTED) {
             g_object_unref(p_this->m_root_file);
             p_this->m_root_file = g_file_dup(file);
+            g_error_free(err);
             p_this->prepare();
             return nullptr;
         }
         g_error_free(err);
+        Q_EMIT p_this->enumerateFinished(false);
+        return nullptr;
     }
-    //
-    g_file_enumerator_next_files_async(enumerator,
-                                       PEONY_FIND_NEXT_FILES_BATCH_SIZE,
-                                       G_PRIORITY_DEFAULT,
-                                       p_this->m_cancellable,
-                                       GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
-                                       p_this);
+    p_this->nextFilesAsync(enumerator);
 
     g_object_unref(enumerator);
     return nullptr;
@@ -472,32 +784,18 @@ GAsyncReadyCallback FileEnumerator::enumerator_next_files_async_ready_callback(G
     int files_count = 0;
     while (l) {
         GFileInfo *info = static_cast<GFileInfo*>(l->data);
-        GFile *file = g_file_enumerator_get_child(enumerator, info);
-        char *uri = g_file_get_uri(file);
-        char *path = g_file_get_path(file);
-        g_object_unref(file);
-        //qDebug()<<uri;
-        if (path) {
-            QString localUri = QString("file://%1").arg(path);
-            uriList<<localUri;
-            *(p_this->m_children_uris)<<localUri;
-            g_free(path);
-        } else {
-            uriList<<uri;
-            *(p_this->m_children_uris)<<uri;
-        }
-
-        g_free(uri);
+        uriList<<p_this->addChild(enumerator, info);
         files_count++;
         l = l->next;
     }
     g_list_free_full(files, g_object_unref);
     Q_EMIT p_this->childrenUpdated(uriList);
-    if (files_count == PEONY_FIND_NEXT_FILES_BATCH_SIZE) {
-        //have next files, countinue.
+    if (files_count == p_this->m_batch_size) {
+        //have next files, countinue with a larger batch.
+        p_this->m_batch_size = qMin(p_this->m_batch_size*2, PEONY_FIND_NEXT_FILES_MAX_BATCH_SIZE);
         g_file_enumerator_next_files_async(enumerator,
-                                           PEONY_FIND_NEXT_FILES_BATCH_SIZE,
-                                           G_PRIORITY_DEFAULT,
+                                           p_this->m_batch_size,
+                                           IoExecutor::ioPriority(p_this->m_io_priority),
                                            p_this->m_cancellable,
                                            GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
                                            p_this);
@@ -25,6 +25,10 @@
 
 #include <QObject>
 #include "peony-core_global.h"
+#include "local-directory-reader.h"
+#include "io-executor.h"
+
+#include <QPointer>
 
 #include <memory>
 #include <gio/gio.h>
@@ -52,6 +56,71 @@ public:
     ~FileEnumerator();
     void setEnumerateDirectory(QString uri);
     void setEnumerateDirectory(GFile *file);
+
+    /*!
+     * \brief setQueryFullInfo
+     * \param queryFullInfo
+     * <br>
+     * By default the enumerator only queries the children's names, and the
+     * holders have to start a FileInfoJob for every child later. That is a
+     * round trip per file, which is very slow in large or remote directories.
+     * If queryFullInfo is true, the enumerator queries all the attributes
+     * a FileInfo needs in the enumeration itself, and fills the children's
+     * shared infos directly. Once enumerateFinished() (or childrenUpdated())
+     * is sent, the children infos are already loaded.
+     * </br>
+     * \see FileInfoJob::refreshInfoContents(), PEONY_FILE_INFO_QUERY_ATTRIBUTES.
+     */
+    void setQueryFullInfo(bool queryFullInfo = true) {
+        m_query_full_info = queryFullInfo;
+    }
+    bool isQueryFullInfo() {
+        return m_query_full_info;
+    }
+
+    /*!
+     * \brief setNativeBackendEnabled
+     * \param enabled
+     * <br>
+     * Local directories (file://) are listed with LocalDirectoryReader by
+     * default, which reads the entries with readdir() and statx() directly
+     * instead of going through GIO. Other schemes, and local directories
+     * which can not be opened natively, always fall back to GIO.
+     * </br>
+     * <br>
+     * The native backend guesses the content types by names only. The metadata
+     * is read in the worker thread with the entries, like GIO's listing query.
+     * </br>
+     * \see LocalDirectoryReader.
+     */
+    void setNativeBackendEnabled(bool enabled = true) {
+        m_native_backend_enabled = enabled;
+    }
+    bool isNativeBackendEnabled() {
+        return m_native_backend_enabled;
+    }
+    /*!
+     * \brief setIoPriority
+     * \param priority
+     * <br>
+     * The priority class of the enumeration in IoExecutor, the native reads
+     * are run by the executor, and the GIO calls use its io_priority.
+     * The default class is IoExecutor::VisibleDirectory.
+     * </br>
+     */
+    void setIoPriority(IoExecutor::Priority priority) {
+        m_io_priority = priority;
+    }
+    /*!
+     * \brief setCancellationGroup
+     * \param group
+     * <br>
+     * The enumerator is cancelled with the group, such as when the view
+     * holding the group navigates away.
+     * </br>
+     */
+    void setCancellationGroup(IoCancellationGroup *group);
+
     /*!
      * \brief prepare
      * <br>
@@ -65,7 +134,17 @@ public:
      * of prepare done, then we can enumerate the file, or get something
      * error messages. we should connect prepared() signal for async.
      * </br>
-     * \see prepared().
+     * <br>
+     * prepare() opens the directory once, asynchronously, and keeps the opened
+     * handle. The enumerateAsync() (or enumerateSync()) called after prepared()
+     * streams the children from that handle directly instead of opening the
+     * directory again. Local directories are opened by LocalDirectoryReader if
+     * the native backend is enabled.
+     * </br>
+     * \note prepared() is never sent from inside prepare(), it is always delivered
+     * from the event loop. So the listeners connected right after prepare() returns
+     * still receive it, without any delay.
+     * \see prepared(), enumerateAsync().
      */
     void prepare();
     /*!
@@ -103,6 +182,11 @@ Q_SIGNALS:
      * We often start an enumerating after prepared signal sended.
      * This will reduce the 'risks' of errors.
      * </br>
+     * <br>
+     * If there is no error and no target uri, the directory is already opened,
+     * the listener should call enumerateAsync() (or enumerateSync()) to take the
+     * opened handle. If it sets another directory instead, the handle is dropped.
+     * </br>
      * \see prepare().
      */
     void prepared(const std::shared_ptr<Peony::GErrorWrapper> &err = nullptr, const QString &targetUri = nullptr, bool critical = false);
@@ -113,6 +197,8 @@ Q_SIGNALS:
      * If we use enumerateAsync(), we might not get all
      * the children at once. This signal sends everytime
      * there are newly children found asynchronously.
+     * The first batch is small, and the following batches
+     * grow geometrically.
      * connect this signal in you classes and update you data.
      * or connect finished signal which sends when all
      * children were found asynchronously.
@@ -166,6 +252,85 @@ protected:
      */
     GFile *enumerateTargetFile();
 
+    /*!
+     * \brief queryAttributes
+     * \return the attributes should be queried while enumerating.
+     * \see setQueryFullInfo().
+     */
+    const char *queryAttributes();
+
+    /*!
+     * \brief addChild
+     * \param enumerator
+     * \param info
+     * \return the uri of the child.
+     * <br>
+     * Cache the child's uri, and if we are querying full info,
+     * fill the child's shared info with the enumerated GFileInfo.
+     * </br>
+     */
+    QString addChild(GFileEnumerator *enumerator, GFileInfo *info);
+    /*!
+     * \brief addLocalChild
+     * \param reader
+     * \param entry
+     * \return the uri of the child.
+     * <br>
+     * Same as addChild(), for the entries read by the native backend.
+     * </br>
+     */
+    QString addLocalChild(LocalDirectoryReader *reader, const LocalDirectoryEntry &entry);
+
+    /*!
+     * \brief enumerateLocalSync
+     * \return false if the native backend can not handle the directory,
+     * then we should fall back to GIO.
+     */
+    bool enumerateLocalSync();
+    /*!
+     * \brief enumerateLocalAsync
+     * \return false if the native backend can not handle the directory.
+     * \see readLocalChildrenAsync().
+     */
+    bool enumerateLocalAsync();
+    /*!
+     * \brief readLocalChildrenAsync
+     * \param open, if true, open the directory before reading the first batch.
+     * <br>
+     * Read the next batch of the local directory in a worker thread. The batches
+     * grow geometrically like the GIO path, and the next batch is read while we
+     * are handling the current one.
+     * </br>
+     */
+    void readLocalChildrenAsync(bool open = false);
+    void enumerateGioAsync();
+
+    /*!
+     * \brief prepareLocalAsync
+     * \return false if the native backend can not handle the directory.
+     * <br>
+     * Open the local directory in a worker thread, and keep the opened reader
+     * for the following enumerateAsync(). If the directory can not be opened
+     * natively, fall back to prepareGioAsync(), which reports the errors.
+     * </br>
+     */
+    bool prepareLocalAsync();
+    void prepareGioAsync();
+    /*!
+     * \brief clearPrepared
+     * Drop the directory handle opened by prepare(), if it is not taken yet.
+     */
+    void clearPrepared();
+    /*!
+     * \brief nextFilesAsync
+     * \param enumerator
+     * Start streaming the children of an opened enumerator in batches.
+     * \see enumerator_next_files_async_ready_callback().
+     */
+    void nextFilesAsync(GFileEnumerator *enumerator);
+
+    const IoCancellationToken ioToken();
+
     /*!
      * \brief mount_mountable_callback
      * \param file
@@ -190,6 +355,18 @@ protected:
             GAsyncResult *res,
             FileEnumerator *p_this);
 
+    /*!
+     * \brief prepare_async_ready_callback
+     * \param file
+     * \param res
+     * \param p_this
+     * \return
+     * \see prepare().
+     */
+    static GAsyncReadyCallback prepare_async_ready_callback(GFile *file,
+            GAsyncResult *res,
+            FileEnumerator *p_this);
+
     /*!
      * \brief find_children_async_ready_callback
      * \param file
@@ -219,8 +396,62 @@ private:
     GCancellable *m_cancellable = nullptr;
 
     QList<QString> *m_children_uris = nullptr;
+    /*!
+     * \brief m_children_infos
+     * <br>
+     * Hold the filled children infos when querying full info,
+     * otherwise they might be released before the holders get them.
+     * </br>
+     */
+    QList<std::shared_ptr<FileInfo>> *m_children_infos = nullptr;
+    /*!
+     * \brief m_children_types
+     * <br>
+     * The enumerated file types of the children, in the same order as uris.
+     * FileInfo::fromUri() doesn't query the type, so we hand it to the infos
+     * created in getChildren().
+     * </br>
+     */
+    QList<GFileType> *m_children_types = nullptr;
 
     bool m_auto_delete = false;
+    bool m_query_full_info = false;
+    bool m_native_backend_enabled = true;
+
+    /*!
+     * \brief m_local_reader
+     * The reader of the running native async enumeration, it is reset when
+     * the enumeration finished or cancelled.
+     */
+    std::shared_ptr<LocalDirectoryReader> m_local_reader;
+
+    /*!
+     * \brief m_prepared_enumerator
+     * The directory opened by prepare() with GIO, it is taken by the next enumeration.
+     */
+    GFileEnumerator *m_prepared_enumerator = nullptr;
+    /*!
+     * \brief m_prepared_local_reader
+     * The local directory opened by prepare() with the native backend.
+     */
+    std::shared_ptr<LocalDirectoryReader> m_prepared_local_reader;
+    /*!
+     * \brief m_prepared_query_full_info
+     * The handles are opened with the attributes of this mode, they are
+     * not reused if the mode is changed before enumerating.
+     */
+    bool m_prepared_query_full_info = false;
+
+    IoExecutor::Priority m_io_priority = IoExecutor::VisibleDirectory;
+    QPointer<IoCancellationGroup> m_io_group;
+
+    /*!
+     * \brief m_batch_size
+     * The size of the next batch in async enumeration. It grows geometrically
+     * from PEONY_FIND_NEXT_FILES_BATCH_SIZE.
+     * \see enumerator_next_files_async_ready_callback().
+     */
+    int m_batch_size = 0;
 };
 
 }
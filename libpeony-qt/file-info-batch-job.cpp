@@ -0,0 +1,293 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "file-info-batch-job.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "desktop-entry-cache.h"
+
+#include <QPointer>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <QDebug>
+
+using namespace Peony;
+
+/*!
+ * \brief The FileInfoBatchJob::QueryData struct
+ * <br>
+ * The user data of an async query. The job might be deleted before gio
+ * calls back, so we hold it with a QPointer.
+ * </br>
+ */
+struct FileInfoBatchJob::QueryData
+{
+    QPointer<FileInfoBatchJob> job;
+    std::shared_ptr<FileInfo> info;
+};
+
+/*!
+ * \brief warm_desktop_entry
+ * Parse the launcher in the worker thread, so that refreshInfoContents()
+ * finds it in DesktopEntryCache.
+ */
+static void warm_desktop_entry(GFile *file, GFileInfo *info)
+{
+    if (!info || !g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE))
+        return;
+
+    char *path = g_file_get_path(file);
+    if (!path)
+        return;
+    QString desktopFilePath = path;
+    g_free(path);
+    if (!DesktopEntryCache::isDesktopFilePath(desktopFilePath))
+        return;
+
+    //the launcher has just been stated, check the cached entry with it.
+    qint64 modifiedTime = -1;
+    if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+        modifiedTime = qint64(g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+    DesktopEntryCache::getInstance()->entry(desktopFilePath, modifiedTime);
+}
+
+static GFileInfo *query_info_sync(GFile *file)
+{
+    GFileInfo *info = g_file_query_info(file,
+                                        PEONY_FILE_INFO_QUERY_ATTRIBUTES,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        nullptr,
+                                        nullptr);
+    warm_desktop_entry(file, info);
+    return info;
+}
+
+static GFileInfo *query_listing_info_sync(GFile *file)
+{
+    GFileInfo *info = g_file_query_info(file,
+                                        FileInfoJob::listingQueryAttributes(file),
+                                        G_FILE_QUERY_INFO_NONE,
+                                        nullptr,
+                                        nullptr);
+    warm_desktop_entry(file, info);
+    return info;
+}
+
+FileInfoBatchJob::FileInfoBatchJob(const QList<std::shared_ptr<FileInfo>> &infos, QObject *parent) : QObject(parent)
+{
+    QSet<FileInfo *> added;
+    for (auto info : infos) {
+        if (!info || added.contains(info.get()))
+            continue;
+        added<<info.get();
+        m_infos<<info;
+    }
+
+    m_cancellable = g_cancellable_new();
+
+    m_flush_timer = new QTimer(this);
+    m_flush_timer->setSingleShot(true);
+    m_flush_timer->setInterval(PEONY_FILE_INFO_BATCH_JOB_FLUSH_INTERVAL);
+    connect(m_flush_timer, &QTimer::timeout, this, &FileInfoBatchJob::flush);
+}
+
+FileInfoBatchJob::FileInfoBatchJob(const QStringList &uris, QObject *parent) : FileInfoBatchJob(QList<std::shared_ptr<FileInfo>>(), parent)
+{
+    QSet<FileInfo *> added;
+    for (auto uri : uris) {
+        auto info = FileInfo::fromUri(uri);
+        if (added.contains(info.get()))
+            continue;
+        added<<info.get();
+        m_infos<<info;
+    }
+}
+
+FileInfoBatchJob::~FileInfoBatchJob()
+{
+    //the running queries will find the job has gone in callback.
+    g_cancellable_cancel(m_cancellable);
+    g_object_unref(m_cancellable);
+}
+
+bool FileInfoBatchJob::querySync()
+{
+    QList<GFile *> files;
+    for (auto info : m_infos) {
+        files<<info->gFileHandle();
+    }
+
+    QList<GFileInfo *> results = m_sniff_content_type? QtConcurrent::blockingMapped(files, query_info_sync):
+                                 QtConcurrent::blockingMapped(files, query_listing_info_sync);
+
+    bool successed = true;
+    QVector<std::shared_ptr<FileInfo>> updatedInfos;
+    for (int i = 0; i < results.count(); i++) {
+        auto result = results.at(i);
+        if (!result) {
+            successed = false;
+            continue;
+        }
+        FileInfoJob::refreshInfoContents(m_infos.at(i), result);
+        g_object_unref(result);
+        updatedInfos<<m_infos.at(i);
+    }
+
+    if (!updatedInfos.isEmpty())
+        Q_EMIT infosUpdated(updatedInfos);
+
+    if (m_auto_delete)
+        deleteLater();
+    return successed;
+}
+
+void FileInfoBatchJob::queryAsync()
+{
+    if (m_auto_delete)
+        connect(this, &FileInfoBatchJob::queryAsyncFinished, this, &FileInfoBatchJob::deleteLater, Qt::QueuedConnection);
+
+    if (m_finished) {
+        //cancelled and finished before this query.
+        if (m_auto_delete)
+            deleteLater();
+        return;
+    }
+
+    if (m_infos.isEmpty()) {
+        QTimer::singleShot(0, this, [=]() {
+            finish(true);
+        });
+        return;
+    }
+
+    startNextQueries();
+}
+
+void FileInfoBatchJob::cancel()
+{
+    g_cancellable_cancel(m_cancellable);
+
+    //no callback will finish the job if there is no query running.
+    if (m_running_count == 0 && !m_finished) {
+        QTimer::singleShot(0, this, [=]() {
+            finish(false);
+        });
+    }
+}
+
+GAsyncReadyCallback FileInfoBatchJob::query_info_async_callback(GFile *file, GAsyncResult *res, QueryData *data)
+{
+    GError *err = nullptr;
+    GFileInfo *_info = g_file_query_info_finish(file, res, &err);
+
+    if (err) {
+        if (err->code != G_IO_ERROR_CANCELLED)
+            qDebug()<<err->code<<err->message;
+        g_error_free(err);
+    }
+
+    if (data->job) {
+        data->job->onQueryFinished(data->info, _info);
+    }
+
+    if (_info)
+        g_object_unref(_info);
+    delete data;
+
+    return nullptr;
+}
+
+const char *FileInfoBatchJob::queryAttributes(GFile *file)
+{
+    if (m_sniff_content_type)
+        return PEONY_FILE_INFO_QUERY_ATTRIBUTES;
+    return FileInfoJob::listingQueryAttributes(file);
+}
+
+void FileInfoBatchJob::startNextQueries()
+{
+    while (m_running_count < m_max_parallel && m_next_index < m_infos.count()) {
+        if (g_cancellable_is_cancelled(m_cancellable))
+            break;
+
+        auto info = m_infos.at(m_next_index);
+        m_next_index++;
+        m_running_count++;
+
+        auto data = new QueryData;
+        data->job = this;
+        data->info = info;
+        g_file_query_info_async(info->gFileHandle(),
+                                queryAttributes(info->gFileHandle()),
+                                G_FILE_QUERY_INFO_NONE,
+                                G_PRIORITY_DEFAULT,
+                                m_cancellable,
+                                GAsyncReadyCallback(query_info_async_callback),
+                                data);
+    }
+}
+
+void FileInfoBatchJob::onQueryFinished(const std::shared_ptr<FileInfo> &info, GFileInfo *new_info)
+{
+    m_running_count--;
+
+    if (new_info) {
+        FileInfoJob::refreshInfoContents(info, new_info);
+        m_pending_infos<<info;
+        if (m_pending_infos.count() >= m_chunk_size) {
+            flush();
+        } else if (!m_flush_timer->isActive()) {
+            m_flush_timer->start();
+        }
+    } else {
+        m_has_error = true;
+    }
+
+    bool cancelled = g_cancellable_is_cancelled(m_cancellable);
+    if (!cancelled)
+        startNextQueries();
+
+    if (m_running_count == 0 && (cancelled || m_next_index >= m_infos.count())) {
+        finish(!m_has_error && !cancelled);
+    }
+}
+
+void FileInfoBatchJob::flush()
+{
+    m_flush_timer->stop();
+    if (m_pending_infos.isEmpty())
+        return;
+
+    QVector<std::shared_ptr<FileInfo>> infos;
+    infos.swap(m_pending_infos);
+    Q_EMIT infosUpdated(infos);
+}
+
+void FileInfoBatchJob::finish(bool successed)
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    flush();
+    Q_EMIT queryAsyncFinished(successed);
+}
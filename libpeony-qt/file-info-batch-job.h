@@ -0,0 +1,184 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILEINFOBATCHJOB_H
+#define FILEINFOBATCHJOB_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+
+#include <memory>
+#include <gio/gio.h>
+
+/*!
+ * \brief PEONY_FILE_INFO_BATCH_JOB_MAX_PARALLEL
+ * The max count of queries running at the same time in an async batch job.
+ */
+#ifndef PEONY_FILE_INFO_BATCH_JOB_MAX_PARALLEL
+#define PEONY_FILE_INFO_BATCH_JOB_MAX_PARALLEL 16
+#endif
+
+/*!
+ * \brief PEONY_FILE_INFO_BATCH_JOB_CHUNK_SIZE
+ * The max count of infos reported in one FileInfoBatchJob::infosUpdated() signal.
+ */
+#ifndef PEONY_FILE_INFO_BATCH_JOB_CHUNK_SIZE
+#define PEONY_FILE_INFO_BATCH_JOB_CHUNK_SIZE 64
+#endif
+
+/*!
+ * \brief PEONY_FILE_INFO_BATCH_JOB_FLUSH_INTERVAL
+ * The max time in milliseconds an updated info waits before it is reported.
+ */
+#ifndef PEONY_FILE_INFO_BATCH_JOB_FLUSH_INTERVAL
+#define PEONY_FILE_INFO_BATCH_JOB_FLUSH_INTERVAL 50
+#endif
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The FileInfoBatchJob class
+ * <br>
+ * FileInfoBatchJob queries a group of infos in one job. Instead of creating
+ * a FileInfoJob for every file, the model should create one batch job for the
+ * files it wants to refresh, and handle the updated infos in chunks.
+ * </br>
+ * <br>
+ * The async queries run in gio's worker threads, at most
+ * PEONY_FILE_INFO_BATCH_JOB_MAX_PARALLEL queries are running at the same time.
+ * The updated infos are collected and sent through infosUpdated() when the chunk
+ * is full, when the collected infos have waited for
+ * PEONY_FILE_INFO_BATCH_JOB_FLUSH_INTERVAL, or when the job finished.
+ * </br>
+ * \note
+ * The batch job does not share the cancellable of the infos, so a FileInfoJob
+ * of a same info will not cancel this job, and vice versa.
+ * \see FileInfoJob.
+ */
+class PEONYCORESHARED_EXPORT FileInfoBatchJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileInfoBatchJob(const QList<std::shared_ptr<FileInfo>> &infos, QObject *parent = nullptr);
+    explicit FileInfoBatchJob(const QStringList &uris, QObject *parent = nullptr);
+    ~FileInfoBatchJob();
+
+    const QList<std::shared_ptr<FileInfo>> getInfos() {
+        return m_infos;
+    }
+
+    void setAutoDelete(bool deleteWhenJobFinished = true) {
+        m_auto_delete = deleteWhenJobFinished;
+    }
+    void setMaxParallelJobs(int count) {
+        m_max_parallel = qMax(1, count);
+    }
+    void setChunkSize(int size) {
+        m_chunk_size = qMax(1, size);
+    }
+    /*!
+     * \brief setSniffContentType
+     * \param sniff
+     * <br>
+     * By default the job queries FileInfoJob::listingQueryAttributes(), which
+     * doesn't sniff the file contents of native files. Set it true for
+     * querying the real content types, such as upgrading the uncertain ones.
+     * </br>
+     * \see FileInfo::isContentTypeUncertain().
+     */
+    void setSniffContentType(bool sniff = true) {
+        m_sniff_content_type = sniff;
+    }
+
+    bool isRunning() {
+        return m_running_count > 0;
+    }
+
+    /*!
+     * \brief querySync
+     * \return true if all infos are queried successfully.
+     * <br>
+     * The GFileInfos are queried in Qt's global thread pool, and the infos
+     * are filled in the calling thread. infosUpdated() is sent once with all
+     * the updated infos.
+     * </br>
+     */
+    bool querySync();
+
+Q_SIGNALS:
+    /*!
+     * \brief infosUpdated
+     * \param infos, a chunk of the infos which have been updated.
+     */
+    void infosUpdated(const QVector<std::shared_ptr<Peony::FileInfo>> &infos);
+    /*!
+     * \brief queryAsyncFinished
+     * \param successed
+     * \retval true if all the queries finished without error.
+     * \retval false if the job was cancelled or any query failed.
+     * <br>
+     * It is sent exactly once, even if the job was cancelled before
+     * any query started.
+     * </br>
+     */
+    void queryAsyncFinished(bool successed);
+
+public Q_SLOTS:
+    void queryAsync();
+    void cancel();
+
+protected:
+    struct QueryData;
+    static GAsyncReadyCallback query_info_async_callback(GFile *file,
+            GAsyncResult *res,
+            QueryData *data);
+
+    const char *queryAttributes(GFile *file);
+    void startNextQueries();
+    void onQueryFinished(const std::shared_ptr<FileInfo> &info, GFileInfo *new_info);
+    void flush();
+    void finish(bool successed);
+
+private:
+    QList<std::shared_ptr<FileInfo>> m_infos;
+    QVector<std::shared_ptr<FileInfo>> m_pending_infos;
+
+    int m_next_index = 0;
+    int m_running_count = 0;
+    int m_max_parallel = PEONY_FILE_INFO_BATCH_JOB_MAX_PARALLEL;
+    int m_chunk_size = PEONY_FILE_INFO_BATCH_JOB_CHUNK_SIZE;
+
+    bool m_has_error = false;
+    bool m_finished = false;
+    bool m_auto_delete = false;
+    bool m_sniff_content_type = false;
+
+    GCancellable *m_cancellable = nullptr;
+    QTimer *m_flush_timer = nullptr;
+};
+
+}
+
+#endif // FILEINFOBATCHJOB_H
@@ -26,17 +26,57 @@
 #include "file-meta-info.h"
 
 #include "file-info-manager.h"
+#include "local-directory-reader.h"
+#include "theme-icon-cache.h"
+#include "desktop-entry-cache.h"
 
-#include <gio/gdesktopappinfo.h>
 
 #include <QDebug>
-#include <QDateTime>
 #include <QIcon>
 #include <QUrl>
-#include <QLocale>
+#include <QTimer>
 
 using namespace Peony;
 
+/*!
+ * \brief specialDirectoryIconName
+ * \return the icon name of home or a xdg user directory, for the infos queried
+ * without the icons. Otherwise return a null string.
+ */
+static QString specialDirectoryIconName(const QString &uri, GFileType type, bool symbolic)
+{
+    if (type != G_FILE_TYPE_DIRECTORY || !uri.startsWith("file://"))
+        return nullptr;
+
+    QByteArray path = QUrl(uri).path().toUtf8();
+    GIcon *icon = LocalDirectoryReader::specialDirectoryIcon(path, symbolic);
+    if (!icon)
+        return nullptr;
+
+    QString iconName;
+    if (symbolic) {
+        const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON(icon));
+        if (icon_names && *icon_names)
+            iconName = *icon_names;
+    } else {
+        iconName = ThemeIconCache::getInstance()->themedIconName(icon);
+    }
+    g_object_unref(icon);
+    return iconName;
+}
+
+/*!
+ * \brief contentTypeIconName
+ * \return the icon name of a file queried without the icons.
+ */
+static QString contentTypeIconName(const QString &uri, GFileType type, const QString &contentType, bool symbolic)
+{
+    QString iconName = specialDirectoryIconName(uri, type, symbolic);
+    if (iconName.isNull())
+        iconName = ThemeIconCache::getInstance()->contentTypeIconName(contentType, symbolic);
+    return iconName;
+}
+
 FileInfoJob::FileInfoJob(std::shared_ptr<FileInfo> info, QObject *parent) : QObject(parent)
 {
     m_info = info;
@@ -53,36 +93,23 @@ FileInfoJob::FileInfoJob(const QString &uri, QObject *parent) : QObject (parent)
 /*!
  * \brief FileInfoJob::~FileInfoJob
  * <br>
- * For FileInfo having a handle shared by all classes instance,
- * the shared data first is created in a global hash hold by
- * Peony::FileInfoManager instance. This makes shared_ptr
- * ref count always more than 1.
+ * FileInfoManager only holds weak references of the shared infos,
+ * so the info will be released with its last holder automaticly.
+ * We don't need to remove it from the manager here.
  * </br>
- * <br>
- * At this class we aslo hold a shared data from global hash
- * (though we aslo change its content here).
- * When info job instance in destructor, it means shared data
- * use count will reduce 1 soon. If current use count is 2,
- * that means there won't be another holder expect global hash.
- * So we can remove the last shared_ptr in the hash, then FileInfo
- * instance will be removed automaticly.
- * </br>
- * \see FileInfo::~FileInfo(), FileEnumerator::~FileEnumerator().
  */
 FileInfoJob::~FileInfoJob()
 {
     //qDebug()<<"~Job"<<m_info.use_count();
-    if (m_info.use_count() <= 2) {
-        Peony::FileInfoManager *mgr = Peony::FileInfoManager::getInstance();
-        mgr->remove(m_info);
-    }
 }
 
 void FileInfoJob::cancel()
 {
     //NOTE: do not use same cancellble for cancelling, otherwise all job might be cancelled.
-    g_cancellable_cancel(m_info->m_cancellable);
-    g_object_unref(m_info->m_cancellable);
+    if (m_info->m_cancellable) {
+        g_cancellable_cancel(m_info->m_cancellable);
+        g_object_unref(m_info->m_cancellable);
+    }
     m_info->m_cancellable = g_cancellable_new();
 }
 
@@ -98,8 +125,8 @@ bool FileInfoJob::querySync()
     }
     GError *err = nullptr;
 
-    auto _info = g_file_query_info(info->m_file,
-                                   "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+    auto _info = g_file_query_info(info->gFileHandle(),
+                                   PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                                    G_FILE_QUERY_INFO_NONE,
                                    nullptr,
                                    &err);
@@ -154,8 +181,8 @@ void FileInfoJob::queryAsync()
         Q_EMIT queryAsyncFinished(false);
         return;
     }
-    g_file_query_info_async(info->m_file,
-                            "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+    g_file_query_info_async(info->gFileHandle(),
+                            PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                             G_FILE_QUERY_INFO_NONE,
                             G_PRIORITY_DEFAULT,
                             info->m_cancellable,
@@ -166,17 +193,72 @@ void FileInfoJob::queryAsync()
         connect(this, &FileInfoJob::queryAsyncFinished, this, &FileInfoJob::deleteLater, Qt::QueuedConnection);
 }
 
-void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
+GAsyncReadyCallback FileInfoJob::query_file_type_async_callback(GFile *file, GAsyncResult *res, FileInfoJob *thisJob)
 {
-    if (!m_info->m_mutex.tryLock(300))
+    GError *err = nullptr;
+
+    GFileInfo *_info = g_file_query_info_finish(file,
+                       res,
+                       &err);
+
+    if (_info != nullptr) {
+        thisJob->m_info->setFileType(g_file_info_get_file_type(_info));
+        g_object_unref(_info);
+        Q_EMIT thisJob->queryAsyncFinished(true);
+    } else {
+        qDebug()<<err->code<<err->message;
+        g_error_free(err);
+        Q_EMIT thisJob->queryAsyncFinished(false);
+    }
+
+    return nullptr;
+}
+
+void FileInfoJob::queryFileTypeAsync()
+{
+    if (!m_info) {
+        Q_EMIT queryAsyncFinished(false);
+        return;
+    }
+
+    if (m_auto_delete)
+        connect(this, &FileInfoJob::queryAsyncFinished, this, &FileInfoJob::deleteLater, Qt::QueuedConnection);
+
+    if (m_info->isFileTypeResolved()) {
+        QTimer::singleShot(0, this, [=]() {
+            Q_EMIT queryAsyncFinished(true);
+        });
         return;
+    }
 
+    //do not use the shared cancellable, a full info query of the same info
+    //should not cancel this job.
+    g_file_query_info_async(m_info->gFileHandle(),
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT,
+                            nullptr,
+                            GAsyncReadyCallback(query_file_type_async_callback),
+                            this);
+}
+
+void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
+{
+    refreshInfoContents(m_info, new_info);
+}
+
+void FileInfoJob::refreshInfoContents(const std::shared_ptr<FileInfo> &sharedInfo, GFileInfo *new_info)
+{
     FileInfo *info = nullptr;
-    if (auto data = m_info) {
+    if (auto data = sharedInfo) {
         info = data.get();
     } else {
         return;
     }
+
+    if (!sharedInfo->m_mutex.tryLock(300))
+        return;
+
     GFileType type = g_file_info_get_file_type (new_info);
     switch (type) {
     case G_FILE_TYPE_DIRECTORY:
@@ -213,121 +295,154 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     info->m_is_virtual = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL);
 
     info->m_display_name = QString (g_file_info_get_display_name(new_info));
-    GIcon *g_icon = g_file_info_get_icon (new_info);
-    if (G_IS_ICON(g_icon)) {
-        const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_icon));
-        if (icon_names) {
-            auto p = icon_names;
-            while (*p) {
-                QIcon icon = QIcon::fromTheme(*p);
-                if (!icon.isNull()) {
-                    info->m_icon_name = QString (*p);
-                    break;
-                } else {
-                    p++;
-                }
-            }
-        }
-        //g_object_unref(g_icon);
+
+    const char *content_type = nullptr;
+    bool is_fast_content_type = false;
+    if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE)) {
+        content_type = g_file_info_get_content_type(new_info);
+    } else if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE)) {
+        content_type = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+        is_fast_content_type = true;
     }
+    info->m_content_type = FileInfo::internString(content_type);
+
+    //the resolved names are shared by ThemeIconCache, we don't need intern them.
+    //a listing query doesn't request the icons, see PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES.
+    auto iconCache = ThemeIconCache::getInstance();
+    QString icon_name;
+    if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_STANDARD_ICON)) {
+        icon_name = iconCache->themedIconName(g_file_info_get_icon(new_info));
+    } else if (content_type) {
+        icon_name = contentTypeIconName(sharedInfo->uri(), type, info->m_content_type, false);
+    }
+    if (!icon_name.isNull())
+        info->m_icon_name = icon_name;
 
     //qDebug()<<m_display_name<<m_icon_name;
-    GIcon *g_symbolic_icon = g_file_info_get_symbolic_icon (new_info);
-    if (G_IS_ICON(g_symbolic_icon)) {
-        const gchar* const* symbolic_icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_symbolic_icon));
-        if (symbolic_icon_names)
-            info->m_symbolic_icon_name = QString (*symbolic_icon_names);
-        //g_object_unref(g_symbolic_icon);
+    if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON)) {
+        GIcon *g_symbolic_icon = g_file_info_get_symbolic_icon(new_info);
+        if (G_IS_THEMED_ICON(g_symbolic_icon)) {
+            const gchar* const* symbolic_icon_names = g_themed_icon_get_names(G_THEMED_ICON(g_symbolic_icon));
+            if (symbolic_icon_names && *symbolic_icon_names)
+                info->m_symbolic_icon_name = FileInfo::internString(*symbolic_icon_names);
+        }
+    } else if (content_type) {
+        QString symbolic_icon_name = contentTypeIconName(sharedInfo->uri(), type, info->m_content_type, true);
+        if (!symbolic_icon_name.isNull())
+            info->m_symbolic_icon_name = symbolic_icon_name;
     }
 
     info->m_file_id = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_ID_FILE);
 
-    info->m_content_type = g_file_info_get_content_type (new_info);
-    if (info->m_content_type == nullptr) {
-        if (g_file_info_has_attribute(new_info, "standard::fast-content-type")) {
-            info->m_content_type = g_file_info_get_attribute_string(new_info, "standard::fast-content-type");
-        }
-    }
-
     info->m_size = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
     info->m_modified_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
     info->m_access_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
 
-    info->m_mime_type_string = info->m_content_type;
-    if (!info->m_mime_type_string.isEmpty()) {
-        char *content_type = g_content_type_get_description (info->m_mime_type_string.toUtf8().constData());
-        info->m_file_type = content_type;
-        g_free (content_type);
-        content_type = nullptr;
+    //the fast content type is guessed by name only, if the name is ambiguous,
+    //the contents should be sniffed later, see FileInfo::isContentTypeUncertain().
+    info->m_is_content_type_uncertain = false;
+    if (is_fast_content_type && type == G_FILE_TYPE_REGULAR && info->m_size > 0) {
+        gboolean uncertain = FALSE;
+        char *guessed_type = g_content_type_guess(g_file_info_get_name(new_info), nullptr, 0, &uncertain);
+        g_free(guessed_type);
+        info->m_is_content_type_uncertain = uncertain;
     }
 
-    char *size_full = g_format_size_full(info->m_size, G_FORMAT_SIZE_DEFAULT);
-    info->m_file_size = size_full;
-    g_free(size_full);
-
-    QDateTime date = QDateTime::fromMSecsSinceEpoch(info->m_modified_time*1000);
-    info->m_modified_date = date.toString(Qt::SystemLocaleShortDate);
+    //the display strings of size and dates are formatted on demand.
+    info->m_file_type = FileInfo::contentTypeDescription(info->m_content_type);
 
-    date = QDateTime::fromMSecsSinceEpoch(info->m_access_time*1000);
-    info->m_access_date = date.toString(Qt::SystemLocaleShortDate);
-
-    m_info->m_meta_info = FileMetaInfo::fromGFileInfo(m_info->uri(), new_info);
+    sharedInfo->m_meta_info = FileMetaInfo::fromGFileInfo(sharedInfo->uri(), new_info);
 
     if (info->isDesktopFile()) {
+        //the launchers are parsed once and shared, see DesktopEntryCache.
         QUrl url = info->uri();
-        GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(url.path().toUtf8());
-        if (!desktop_info) {
-            m_info->m_mutex.unlock();
-            info->updated();
-            return;
-        }
-#if GLIB_CHECK_VERSION(2, 56, 0)
-        auto string = g_desktop_app_info_get_locale_string(desktop_info, "Name");
-#else
-        //FIXME: should handle locale?
-        //change "Name" to QLocale::system().name(),
-        //try to fix Qt5.6 untranslated desktop file issue
-        auto key = "Name[" +  QLocale::system().name() + "]";
-        auto string = g_desktop_app_info_get_string(desktop_info, key.toUtf8().constData());
-#endif
-        qDebug() << "get name string:"<<string <<info->uri()<<info->displayName();
-        if (string) {
-            info->m_display_name = string;
-            g_free(string);
-        } else {
-            QString path = "/usr/share/applications/" + info->displayName();
-            auto name = getAppName(path);
-            if (name.length() > 0)
-                info->m_display_name = name;
-            else
-            {
-                string = g_desktop_app_info_get_string(desktop_info, "Name");
-                if (string) {
-                    info->m_display_name = string;
-                    g_free(string);
-                }
-            }
-        }
-        g_object_unref(desktop_info);
+        QString name = DesktopEntryCache::getInstance()->displayName(url.path());
+        if (!name.isNull())
+            info->m_display_name = name;
     }
 
+    info->m_is_loaded = true;
+
     Q_EMIT info->updated();
-    m_info->m_mutex.unlock();
+    sharedInfo->m_mutex.unlock();
 }
 
-QString FileInfoJob::getAppName(QString desktopfp)
+void FileInfoJob::refreshInfoContents(const std::shared_ptr<FileInfo> &sharedInfo, const LocalDirectoryEntry &entry)
 {
-    GError** error=nullptr;
-    GKeyFileFlags flags=G_KEY_FILE_NONE;
-    GKeyFile* keyfile=g_key_file_new ();
+    FileInfo *info = sharedInfo.get();
+    if (!info)
+        return;
 
-    QByteArray fpbyte=desktopfp.toLocal8Bit();
-    char* filepath=fpbyte.data();
-    g_key_file_load_from_file(keyfile,filepath,flags,error);
+    if (!sharedInfo->m_mutex.tryLock(300))
+        return;
+
+    if (entry.type == G_FILE_TYPE_DIRECTORY)
+        info->m_is_dir = true;
+
+    info->m_is_symbol_link = entry.is_symlink;
+    info->m_can_read = entry.can_read;
+    info->m_can_write = entry.can_write;
+    info->m_can_excute = entry.can_execute;
+    info->m_can_delete = entry.can_delete;
+    info->m_can_trash = entry.can_trash;
+    info->m_can_rename = entry.can_delete;
+
+    //a native local file is never a mountable or a virtual file.
+    info->m_can_mount = false;
+    info->m_can_unmount = false;
+    info->m_can_eject = false;
+    info->m_can_start = false;
+    info->m_can_stop = false;
+    info->m_is_virtual = false;
+
+    info->m_display_name = entry.display_name;
+    info->m_content_type = FileInfo::internString(entry.content_type.constData());
+
+    QString icon_name = contentTypeIconName(sharedInfo->uri(), entry.type, info->m_content_type, false);
+    if (!icon_name.isNull())
+        info->m_icon_name = icon_name;
+    QString symbolic_icon_name = contentTypeIconName(sharedInfo->uri(), entry.type, info->m_content_type, true);
+    if (!symbolic_icon_name.isNull())
+        info->m_symbolic_icon_name = symbolic_icon_name;
 
-    char* name=g_key_file_get_locale_string(keyfile,"Desktop Entry","Name", nullptr, nullptr);
-    QString namestr=QString::fromLocal8Bit(name);
+    info->m_file_id = entry.file_id;
 
-    g_key_file_free(keyfile);
-    return namestr;
+    info->m_size = entry.size;
+    info->m_modified_time = entry.modified_time;
+    info->m_access_time = entry.access_time;
+
+    //guessed by the reader with the content type.
+    info->m_is_content_type_uncertain = entry.is_content_type_uncertain;
+
+    info->m_file_type = FileInfo::contentTypeDescription(info->m_content_type);
+
+    sharedInfo->m_meta_info = FileMetaInfo::fromGFileInfo(sharedInfo->uri(), entry.metadata.get());
+
+    if (info->isDesktopFile()) {
+        //the launchers are parsed once and shared, see DesktopEntryCache.
+        QUrl url = info->uri();
+        QString name = DesktopEntryCache::getInstance()->displayName(url.path());
+        if (!name.isNull())
+            info->m_display_name = name;
+    }
+
+    info->m_is_loaded = true;
+
+    Q_EMIT info->updated();
+    sharedInfo->m_mutex.unlock();
+}
+
+const char *FileInfoJob::listingQueryAttributes(GFile *file)
+{
+    if (file && g_file_is_native(file))
+        return PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES;
+    return PEONY_FILE_INFO_QUERY_ATTRIBUTES;
+}
+
+QString FileInfoJob::getAppName(QString desktopfp)
+{
+    auto entry = DesktopEntryCache::getInstance()->entry(desktopfp);
+    if (!entry)
+        return nullptr;
+    return entry->locale_name;
 }
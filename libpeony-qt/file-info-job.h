@@ -30,9 +30,45 @@
 #include <memory>
 #include <gio/gio.h>
 
+/*!
+ * \brief PEONY_FILE_INFO_QUERY_ATTRIBUTES
+ * The attributes a FileInfo needs to be fully loaded. FileInfoJob uses them
+ * for querying a single file, and FileEnumerator can use them for querying
+ * all the children in the enumeration at once.
+ * \see FileEnumerator::setQueryFullInfo().
+ */
+#define PEONY_FILE_INFO_QUERY_ATTRIBUTES "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE
+
+/*!
+ * \brief PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES
+ * Same as PEONY_FILE_INFO_QUERY_ATTRIBUTES without standard::content-type and
+ * the icons. GIO's local backend reads the file contents for sniffing the type
+ * when any of them is requested, which is a disk read per file in a listing.
+ * The infos queried with these attributes use the fast content type, and the
+ * ambiguous ones are sniffed lazily.
+ * \see FileInfoJob::listingQueryAttributes(), FileInfo::isContentTypeUncertain().
+ */
+#define PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES \
+    G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL "," \
+    G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+    G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+    G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME "," \
+    G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE "," \
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+    G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE "," \
+    G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET "," \
+    G_FILE_ATTRIBUTE_STANDARD_TARGET_URI "," \
+    G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER "," \
+    "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE
+
 namespace Peony {
 
 class FileInfo;
+struct LocalDirectoryEntry;
 
 /*!
  * \brief The FileInfoJob class
@@ -52,6 +88,9 @@ class FileInfo;
 class PEONYCORESHARED_EXPORT FileInfoJob : public QObject
 {
     friend class FileInfo;
+    friend class FileEnumerator;
+    friend class FileInfoBatchJob;
+    friend class PersistentListingCache;
 
     Q_OBJECT
 public:
@@ -104,6 +143,17 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void queryAsync();
+    /*!
+     * \brief queryFileTypeAsync
+     * <br>
+     * Only resolve whether the file is a directory or a volume, without
+     * blocking the caller. queryAsyncFinished() will be sent when the type
+     * is resolved. If the type has already been known, the signal is sent
+     * in next event loop without any i/o.
+     * </br>
+     * \see FileInfo::isFileTypeResolved().
+     */
+    void queryFileTypeAsync();
     /*!
      * \brief cancel
      * <br>
@@ -116,11 +166,56 @@ public Q_SLOTS:
 
     QString getAppName(QString desktopfp);
 
+public:
+    /*!
+     * \brief listingQueryAttributes
+     * \param file
+     * \return the attributes should be queried when we list file or its children.
+     * <br>
+     * Native files use PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES. The other
+     * backends keep PEONY_FILE_INFO_QUERY_ATTRIBUTES, their icons might not be
+     * derived from content types, such as the volumes in computer:///.
+     * </br>
+     */
+    static const char *listingQueryAttributes(GFile *file);
+
 protected:
     static GAsyncReadyCallback query_info_async_callback(GFile *file,
             GAsyncResult *res,
             FileInfoJob *thisJob);
 
+    static GAsyncReadyCallback query_file_type_async_callback(GFile *file,
+            GAsyncResult *res,
+            FileInfoJob *thisJob);
+
+    /*!
+     * \brief refreshInfoContents
+     * \param info, the shared info to fill.
+     * \param new_info, a GFileInfo queried with PEONY_FILE_INFO_QUERY_ATTRIBUTES,
+     * or PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES.
+     * <br>
+     * Fill the shared info with the queried GFileInfo and send FileInfo::updated().
+     * The GFileInfo might come from a single query job, or from an enumerator
+     * which queried the full attributes of its children, so that we don't need
+     * query them once again.
+     * </br>
+     * <br>
+     * If new_info only has the fast content type, the icons are looked up from it,
+     * and the info is marked uncertain if the type can't be told by the name.
+     * </br>
+     */
+    static void refreshInfoContents(const std::shared_ptr<FileInfo> &info, GFileInfo *new_info);
+    /*!
+     * \brief refreshInfoContents
+     * \param info, the shared info to fill.
+     * \param entry, an entry read by a LocalDirectoryReader which stats its children.
+     * <br>
+     * Same as the GFileInfo version, but the fields are copied from the entry,
+     * which LocalDirectoryReader has resolved in its worker thread.
+     * </br>
+     */
+    static void refreshInfoContents(const std::shared_ptr<FileInfo> &info, const LocalDirectoryEntry &entry);
+
 private:
     void refreshInfoContents(GFileInfo *new_info);
     std::shared_ptr<FileInfo> m_info;
@@ -26,41 +26,46 @@
 
 using namespace Peony;
 
-static FileInfoManager* global_file_info_manager = nullptr;
-static QHash<QString, std::shared_ptr<FileInfo>> *global_info_list = nullptr;
-
 FileInfoManager::FileInfoManager()
 {
-    global_info_list = new QHash<QString, std::shared_ptr<FileInfo>>();
+
 }
 
 FileInfoManager::~FileInfoManager()
 {
-    delete global_info_list;
+
 }
 
 FileInfoManager *FileInfoManager::getInstance()
 {
-    if (!global_file_info_manager)
-        global_file_info_manager = new FileInfoManager;
+    //infos might be created in different threads at first time,
+    //make sure the instance is created only once.
+    static FileInfoManager *global_file_info_manager = new FileInfoManager;
     return global_file_info_manager;
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::findFileInfoByUri(QString uri)
 {
-    Q_ASSERT(global_info_list);
-    return global_info_list->value(uri);//.lock();
+    auto &shard = shardForUri(uri);
+    QReadLocker locker(&shard.lock);
+    return shard.infos.value(uri).lock();
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileInfo> info)
 {
-    Q_ASSERT(global_info_list);
+    auto uri = info->uri();
+    auto &shard = shardForUri(uri);
+    QWriteLocker locker(&shard.lock);
 
-    if (global_info_list->value(info->uri())) {
-        //qDebug()<<"has info yet"<<info->uri();
-        info = global_info_list->value(info->uri());
+    auto it = shard.infos.find(uri);
+    if (it != shard.infos.end()) {
+        if (auto existed = it.value().lock()) {
+            //qDebug()<<"has info yet"<<info->uri();
+            return existed;
+        }
+        it.value() = info;
     } else {
-        global_info_list->insert(info->uri(), info);
+        shard.infos.insert(uri, info);
     }
 
     return info;
@@ -68,30 +73,56 @@ std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileIn
 
 void FileInfoManager::removeFileInfobyUri(QString uri)
 {
-    Q_ASSERT(global_info_list);
-    global_info_list->remove(uri);
+    auto &shard = shardForUri(uri);
+    QWriteLocker locker(&shard.lock);
+    shard.infos.remove(uri);
+}
+
+void FileInfoManager::onFileInfoReleased(const QString &uri)
+{
+    auto &shard = shardForUri(uri);
+    {
+        QWriteLocker locker(&shard.lock);
+        auto it = shard.infos.find(uri);
+        if (it == shard.infos.end() || !it.value().expired())
+            return;
+        shard.infos.erase(it);
+    }
+    ThumbnailManager::getInstance()->releaseThumbnail(uri);
 }
 
 void FileInfoManager::clear()
 {
-    Q_ASSERT(global_info_list);
-    global_info_list->clear();
+    for (auto &shard : m_shards) {
+        QWriteLocker locker(&shard.lock);
+        shard.infos.clear();
+    }
 }
 
 void FileInfoManager::remove(QString uri)
 {
     ThumbnailManager::getInstance()->releaseThumbnail(uri);
-    Q_ASSERT(global_info_list);
-    global_info_list->remove(uri);
+    removeFileInfobyUri(uri);
 }
 
 void FileInfoManager::remove(std::shared_ptr<FileInfo> info)
 {
-    Q_ASSERT(global_info_list);
+    if (!info)
+        return;
     this->remove(info->uri());
 }
 
+int FileInfoManager::count()
+{
+    int count = 0;
+    for (auto &shard : m_shards) {
+        QReadLocker locker(&shard.lock);
+        count += shard.infos.count();
+    }
+    return count;
+}
+
 void FileInfoManager::showState()
 {
-    qDebug()<<global_info_list->keys().count()<<global_info_list->values().count();
+    qDebug()<<count();
 }
@@ -26,7 +26,11 @@
 #include "file-info.h"
 
 #include <QHash>
-#include <QMutex>
+#include <QReadWriteLock>
+
+#ifndef PEONY_FILE_INFO_MANAGER_SHARD_COUNT
+#define PEONY_FILE_INFO_MANAGER_SHARD_COUNT 64
+#endif
 
 namespace Peony {
 
@@ -34,53 +38,90 @@ namespace Peony {
  * \brief The FileInfoManager class
  * <br>
  * This is a class used to share FileInfo instances acrossing various members.
- * It is a single instance class with a hash table that cached all infos.
+ * It is a single instance class with an intern table that indexes all living infos.
  * We generally would not operate directly on instance of this class,
  * because FileInfo class provides an interface for this class.
  * use FileInfo::fromUri(), FileInfo::fromPath() or FileInfo::fromGFile()
  * for getting the corresponding shared data.
  * </br>
- * \note The memory management is based on std smart pointer, but it is not regular.
- * Because hash table always hold a use count of shared data. If you want to use
- * shared data of this class instance, you should remenmber this point:
- * When releasing your info resources, you aslo need to add an additional judgment that whether
- * there is no other member but you and manager instance hold this shared data.
- * If true, you should aslo remove the element in manager's hash for really releasing resources.
- * Otherwise, it might cause an one-time memory leak.
- * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::~FileInfo(), FileInfoJob::~FileInfoJob(),
- * FileEnumerator::~FileEnumerator().
- * \bug
- * Even though I try my best to make share the file info data, it seems that the info is not be shared
- * sometimes. Maybe there were some wrong in other classes?
+ * <br>
+ * The table only holds weak references of the shared infos, so an info
+ * will be released with its last holder, and its entry will be removed from
+ * the table at the same time. There is no need to check the use count and
+ * remove the info manually any more.
+ * </br>
+ * <br>
+ * Infos are looked up from gui thread, thumbnail jobs, file operations and
+ * info job callbacks at the same time. The table is split into shards by the
+ * uri's hash, every shard has its own read-write lock, so that the lookups
+ * in different threads rarely contend on a same lock, and reading a shard
+ * never blocks other readers.
+ * </br>
+ * \see FileInfo, FileInfoJob, FileEnumerator.
  */
 class PEONYCORESHARED_EXPORT FileInfoManager
 {
     friend class FileInfo;
 public:
     static FileInfoManager *getInstance();
-    std::shared_ptr<FileInfo> findFileInfoByUri(QString uri); //{return global_info_list->value(uri);}
+    std::shared_ptr<FileInfo> findFileInfoByUri(QString uri);
     void clear();
     void remove(QString uri);
     void remove(std::shared_ptr<FileInfo> info);
 
-    void lock() {
-        m_mutex.tryLock();
-    }
-    void unlock() {
-        m_mutex.unlock();
-    }
+    /*!
+     * \brief lock
+     * \deprecated
+     * The table is locked internally by shards, this method does nothing now.
+     */
+    void lock() {}
+    /*!
+     * \brief unlock
+     * \deprecated
+     * \see lock().
+     */
+    void unlock() {}
 
+    int count();
     void showState();
 
 protected:
-    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info); //{global_info_list->insert(info->uri(), info);}
-    void removeFileInfobyUri(QString uri); //{global_info_list->remove(uri);}
+    /*!
+     * \brief insertFileInfo
+     * \param info
+     * \return the shared info in the table.
+     * <br>
+     * If there is a living info with the same uri in the table, return it and
+     * drop the given one. Checking and inserting is atomic in the shard.
+     * </br>
+     */
+    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info);
+    void removeFileInfobyUri(QString uri);
+
+    /*!
+     * \brief onFileInfoReleased
+     * \param uri
+     * <br>
+     * Called by the deleter of a shared info, remove the expired entry
+     * of the uri if there is no newer info inserted.
+     * </br>
+     */
+    void onFileInfoReleased(const QString &uri);
 
 private:
     FileInfoManager();
     ~FileInfoManager();
 
-    QMutex m_mutex;
+    struct Shard {
+        QReadWriteLock lock;
+        QHash<QString, std::weak_ptr<FileInfo>> infos;
+    };
+
+    Shard &shardForUri(const QString &uri) {
+        return m_shards[qHash(uri) % PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
+    }
+
+    Shard m_shards[PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
 };
 
 }
@@ -29,19 +29,86 @@
 #include "thumbnail-manager.h"
 
 #include <QUrl>
+#include <QSet>
+#include <QHash>
+#include <QCache>
+#include <QReadWriteLock>
+#include <QDateTime>
+#include <QLocale>
 
 #include <QDebug>
 
+#ifndef PEONY_FILE_INFO_DATE_CACHE_SIZE
+#define PEONY_FILE_INFO_DATE_CACHE_SIZE 4096
+#endif
+
 using namespace Peony;
 
-FileInfo::FileInfo(QObject *parent) : QObject (parent)
+static QSet<QString> *global_string_pool = nullptr;
+static QHash<QString, QString> *global_type_description_hash = nullptr;
+static QReadWriteLock global_string_pool_lock;
+
+static QCache<quint64, QString> *global_date_cache = nullptr;
+static QString global_date_cache_locale = nullptr;
+static QMutex global_date_cache_mutex;
+
+/*!
+ * \brief formatDate
+ * \param time, seconds since epoch.
+ * \return the short date string in current system locale.
+ * <br>
+ * The short date string is shown in minute precision, so that many files
+ * share a same string. Cache the strings and clear them when locale changed.
+ * </br>
+ */
+static QString formatDate(quint64 time)
+{
+    QMutexLocker locker(&global_date_cache_mutex);
+    if (!global_date_cache) {
+        global_date_cache = new QCache<quint64, QString>(PEONY_FILE_INFO_DATE_CACHE_SIZE);
+    }
+    auto localeName = QLocale::system().name();
+    if (localeName != global_date_cache_locale) {
+        global_date_cache->clear();
+        global_date_cache_locale = localeName;
+    }
+
+    quint64 key = time/60;
+    if (auto cached = global_date_cache->object(key)) {
+        return *cached;
+    }
+
+    QDateTime date = QDateTime::fromMSecsSinceEpoch(time*1000);
+    QString *string = new QString(date.toString(Qt::SystemLocaleShortDate));
+    global_date_cache->insert(key, string);
+    return *string;
+}
+
+FileInfo::FileInfo(QObject *parent) : QObject (parent),
+    m_is_dir(false),
+    m_is_volume(false),
+    m_is_symbol_link(false),
+    m_is_virtual(false),
+    m_is_loaded(false),
+    m_is_type_resolved(false),
+    m_is_content_type_uncertain(false),
+    m_can_read(true),
+    m_can_write(false),
+    m_can_excute(false),
+    m_can_delete(false),
+    m_can_trash(false),
+    m_can_rename(false),
+    m_can_mount(false),
+    m_can_unmount(false),
+    m_can_eject(false),
+    m_can_start(false),
+    m_can_stop(false)
 {
-    m_cancellable = g_cancellable_new();
+
 }
 
-FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
+FileInfo::FileInfo(const QString &uri, QObject *parent) : FileInfo(parent)
 {
-    m_cancellable = g_cancellable_new();
     /*!
      * \note
      * In qt program we alwas handle file's uri format as unicode,
@@ -52,26 +119,9 @@ FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
      */
     QUrl url(uri.toUtf8());
     m_uri = url.toDisplayString();
-    auto encoded = url.toEncoded();
-    encoded.replace("#", "%23");
-    m_file = g_file_new_for_uri(encoded.data());
-    m_parent = g_file_get_parent(m_file);
-    m_is_remote = !g_file_is_native(m_file);
-    GFileType type = g_file_query_file_type(m_file,
-                                            G_FILE_QUERY_INFO_NONE,
-                                            nullptr);
-    switch (type) {
-    case G_FILE_TYPE_DIRECTORY:
-        //qDebug()<<"dir";
-        m_is_dir = true;
-        break;
-    case G_FILE_TYPE_MOUNTABLE:
-        //qDebug()<<"mountable";
-        m_is_volume = true;
-        break;
-    default:
-        break;
-    }
+    //NOTE: do not query the file type here, it might block the thread
+    //for a long time when the file is in an unresponsive remote mount.
+    //the type will be resolved by enumerator or FileInfoJob.
 }
 
 FileInfo::~FileInfo()
@@ -79,55 +129,156 @@ FileInfo::~FileInfo()
     //qDebug()<<"~FileInfo"<<m_uri;
     disconnect();
 
-    g_object_unref(m_cancellable);
-    g_object_unref(m_file);
-
-    if (m_target_file)
-        g_object_unref(m_target_file);
-    if (m_parent)
-        g_object_unref(m_parent);
+    if (m_cancellable)
+        g_object_unref(m_cancellable);
+    if (auto file = m_file.loadAcquire())
+        g_object_unref(file);
 
     m_uri = nullptr;
 }
 
+GFile *FileInfo::gFileHandle()
+{
+    GFile *file = m_file.loadAcquire();
+    if (file)
+        return file;
+
+    QUrl url(m_uri.toUtf8());
+    auto encoded = url.toEncoded();
+    encoded.replace("#", "%23");
+    file = g_file_new_for_uri(encoded.data());
+    if (!m_file.testAndSetOrdered(nullptr, file)) {
+        //another thread has created the handle.
+        g_object_unref(file);
+        file = m_file.loadAcquire();
+    }
+    return file;
+}
+
+QString FileInfo::fileSize()
+{
+    if (!m_is_loaded)
+        return nullptr;
+    char *size_full = g_format_size_full(m_size, G_FORMAT_SIZE_DEFAULT);
+    QString fileSize = size_full;
+    g_free(size_full);
+    return fileSize;
+}
+
+QString FileInfo::modifiedDate()
+{
+    if (!m_is_loaded)
+        return nullptr;
+    return formatDate(m_modified_time);
+}
+
+QString FileInfo::accessDate()
+{
+    if (!m_is_loaded)
+        return nullptr;
+    return formatDate(m_access_time);
+}
+
+QString FileInfo::internString(const char *string)
+{
+    if (!string)
+        return nullptr;
+
+    QString key = string;
+    {
+        QReadLocker locker(&global_string_pool_lock);
+        if (global_string_pool) {
+            auto it = global_string_pool->constFind(key);
+            if (it != global_string_pool->constEnd())
+                return *it;
+        }
+    }
+
+    QWriteLocker locker(&global_string_pool_lock);
+    if (!global_string_pool)
+        global_string_pool = new QSet<QString>;
+    auto it = global_string_pool->constFind(key);
+    if (it != global_string_pool->constEnd())
+        return *it;
+    global_string_pool->insert(key);
+    return key;
+}
+
+QString FileInfo::contentTypeDescription(const QString &contentType)
+{
+    if (contentType.isEmpty())
+        return nullptr;
+
+    {
+        QReadLocker locker(&global_string_pool_lock);
+        if (global_type_description_hash) {
+            auto it = global_type_description_hash->constFind(contentType);
+            if (it != global_type_description_hash->constEnd())
+                return it.value();
+        }
+    }
+
+    //g_content_type_get_description() looks up the mime database, do it
+    //outside of the lock.
+    char *content_type = g_content_type_get_description(contentType.toUtf8().constData());
+    QString description = internString(content_type);
+    g_free(content_type);
+
+    QWriteLocker locker(&global_string_pool_lock);
+    if (!global_type_description_hash)
+        global_type_description_hash = new QHash<QString, QString>;
+    global_type_description_hash->insert(contentType, description);
+    return description;
+}
+
 std::shared_ptr<FileInfo> FileInfo::fromUri(QString uri, bool addToHash)
 {
     FileInfoManager *info_manager = FileInfoManager::getInstance();
-    info_manager->lock();
     std::shared_ptr<FileInfo> info = info_manager->findFileInfoByUri(uri);
     if (info != nullptr) {
-        info_manager->unlock();
         return info;
+    }
+
+    std::shared_ptr<FileInfo> newly_info;
+    if (addToHash) {
+        //the manager only holds a weak reference, remove the entry
+        //when the last holder released the info.
+        newly_info = std::shared_ptr<FileInfo>(new FileInfo, [](FileInfo *released_info) {
+            QString released_uri = released_info->m_uri;
+            delete released_info;
+            FileInfoManager::getInstance()->onFileInfoReleased(released_uri);
+        });
     } else {
-        std::shared_ptr<FileInfo> newly_info = std::make_shared<FileInfo>();
-        QUrl url(uri.toUtf8());
-        newly_info->m_uri = url.toDisplayString();
-        auto encoded = url.toEncoded();
-        encoded.replace("#", "%23");
-        newly_info->m_file = g_file_new_for_uri(encoded.data());
-        newly_info->m_parent = g_file_get_parent(newly_info->m_file);
-        newly_info->m_is_remote = !g_file_is_native(newly_info->m_file);
-        GFileType type = g_file_query_file_type(newly_info->m_file,
-                                                G_FILE_QUERY_INFO_NONE,
-                                                nullptr);
-        switch (type) {
-        case G_FILE_TYPE_DIRECTORY:
-            //qDebug()<<"dir";
-            newly_info->m_is_dir = true;
-            break;
-        case G_FILE_TYPE_MOUNTABLE:
-            //qDebug()<<"mountable";
-            newly_info->m_is_volume = true;
-            break;
-        default:
-            break;
-        }
-        if (addToHash) {
-            newly_info = info_manager->insertFileInfo(newly_info);
-        }
-        info_manager->unlock();
-        return newly_info;
+        newly_info = std::make_shared<FileInfo>();
+    }
+    QUrl url(uri.toUtf8());
+    newly_info->m_uri = url.toDisplayString();
+    //we don't query the file type here, see FileInfo::isFileTypeResolved().
+    //the GFile handle is also created lazily, see FileInfo::gFileHandle().
+    if (addToHash) {
+        newly_info = info_manager->insertFileInfo(newly_info);
+    }
+    return newly_info;
+}
+
+void FileInfo::setFileType(GFileType type)
+{
+    if (type == G_FILE_TYPE_UNKNOWN)
+        return;
+
+    //the flags share one word, FileInfoJob writes the others with the lock held.
+    QMutexLocker locker(&m_mutex);
+    switch (type) {
+    case G_FILE_TYPE_DIRECTORY:
+        m_is_dir = true;
+        break;
+    case G_FILE_TYPE_MOUNTABLE:
+        m_is_volume = true;
+        break;
+    default:
+        break;
     }
+    m_is_type_resolved = true;
 }
 
 std::shared_ptr<FileInfo> FileInfo::fromPath(QString path, bool addToHash)
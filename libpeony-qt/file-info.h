@@ -32,6 +32,7 @@
 #include <QObject>
 
 #include <QMutex>
+#include <QAtomicPointer>
 
 #include <QIcon>
 
@@ -54,6 +55,7 @@ class PEONYCORESHARED_EXPORT FileInfo : public QObject
 {
     friend class FileInfoJob;
     friend class FileMetaInfo;
+    friend class FileEnumerator;
 
     Q_OBJECT
 public:
@@ -102,22 +104,26 @@ public:
     QString fileID() {
         return m_file_id;
     }
+    /*!
+     * \brief mimeType
+     * \return the same as type().
+     */
     QString mimeType() {
-        return m_mime_type_string;
+        return m_content_type;
     }
     QString fileType() {
         return m_file_type;
     }
 
-    QString fileSize() {
-        return m_file_size;
-    }
-    QString modifiedDate() {
-        return m_modified_date;
-    }
-    QString accessDate() {
-        return m_access_date;
-    }
+    /*!
+     * \brief fileSize
+     * \return the formatted size string for displaying.
+     * \note The display strings are not stored in info, they are formatted
+     * from the raw values on demand.
+     */
+    QString fileSize();
+    QString modifiedDate();
+    QString accessDate();
 
     QString type() {
         return m_content_type;
@@ -173,6 +179,41 @@ public:
     bool isEmptyInfo() {
         return m_display_name == nullptr;
     }
+    /*!
+     * \brief isLoaded
+     * \return true if the info has been filled by a FileInfoJob or
+     * by a full info enumeration at least once.
+     */
+    bool isLoaded() {
+        return m_is_loaded;
+    }
+    /*!
+     * \brief isFileTypeResolved
+     * \return true if we have known whether the file is a directory or a volume.
+     * <br>
+     * FileInfo::fromUri() never touches the filesystem, so a newly created info
+     * doesn't know its type until it is filled by an enumeration or a FileInfoJob.
+     * If you really need the type at once, use FileInfoJob::queryFileTypeAsync().
+     * </br>
+     */
+    bool isFileTypeResolved() {
+        return m_is_type_resolved || m_is_loaded;
+    }
+    /*!
+     * \brief isContentTypeUncertain
+     * \return true if the content type was guessed by the name only, and
+     * the name is ambiguous.
+     * <br>
+     * The listings don't sniff the file contents. The holders should query
+     * the info with a FileInfoJob (or a FileInfoBatchJob which sniffs content
+     * types) when the file is visible or going to be used, which upgrades the
+     * type and the icon.
+     * </br>
+     * \see PEONY_FILE_INFO_LISTING_QUERY_ATTRIBUTES.
+     */
+    bool isContentTypeUncertain() {
+        return m_is_content_type_uncertain;
+    }
 
     AccessFlags accesses() {
         auto flags = AccessFlags();
@@ -201,9 +242,12 @@ public:
 #endif
     }
 
-    GFile *gFileHandle() {
-        return m_file;
-    }
+    /*!
+     * \brief gFileHandle
+     * \return the GFile handle of this info.
+     * \note The handle is created at first time it is needed.
+     */
+    GFile *gFileHandle();
 
     //const QIcon thumbnail() {return m_thumbnail;}
     //void setThumbnail(const QIcon &thumbnail) {m_thumbnail = thumbnail;}
@@ -211,62 +255,93 @@ public:
 Q_SIGNALS:
     void updated();
 
+protected:
+    /*!
+     * \brief setFileType
+     * \param type
+     * <br>
+     * Set the type we got from enumeration data or a light weight query,
+     * without querying the other attributes.
+     * </br>
+     * \note It locks m_mutex, FileInfoJob writes the other packed flags
+     * with the lock held.
+     */
+    void setFileType(GFileType type);
+
+    /*!
+     * \brief internString
+     * \param string
+     * \return a shared copy of the string in a global pool.
+     * <br>
+     * Content types and icon names are repeated in thousands of infos,
+     * the infos share the pooled string data instead of holding their own copy.
+     * </br>
+     */
+    static QString internString(const char *string);
+    /*!
+     * \brief contentTypeDescription
+     * \param contentType
+     * \return the cached, interned description of the content type.
+     */
+    static QString contentTypeDescription(const QString &contentType);
+
 private:
     QString m_uri = nullptr;
-    bool m_is_valid = false;
-    bool m_is_dir = false;
-    bool m_is_volume = false;
-    bool m_is_remote = false;
-    bool m_is_symbol_link = false;
-    bool m_is_virtual = false;
-
-    bool m_is_loaded = false;
 
     QString m_display_name = nullptr;
+    /*!
+     * \brief m_icon_name
+     * m_icon_name, m_symbolic_icon_name, m_content_type and m_file_type
+     * are interned.
+     * \see internString().
+     */
     QString m_icon_name = nullptr;
     QString m_symbolic_icon_name = nullptr;
     QString m_file_id = nullptr;
 
     QString m_content_type = nullptr;
+    QString m_file_type = nullptr;
+
     guint64 m_size = 0;
     guint64 m_modified_time = 0;
     guint64 m_access_time = 0;
 
-    /*!
-     * \deprecated
-     * \brief m_mime_type_string
-     * \see m_content_type
-     */
-    QString m_mime_type_string = nullptr;
-    QString m_file_type = nullptr;
-    QString m_file_size = nullptr;
-    QString m_modified_date = nullptr;
-    QString m_access_date = nullptr;
+    //packed flags, they are initialized in constructor. they share one word,
+    //so they must only be written with m_mutex held.
+    bool m_is_dir : 1;
+    bool m_is_volume : 1;
+    bool m_is_symbol_link : 1;
+    bool m_is_virtual : 1;
 
-    //access
-    bool m_can_read = true;
-    bool m_can_write = false;
-    bool m_can_excute = false;
-    bool m_can_delete = false;
-    bool m_can_trash = false;
-    bool m_can_rename = false;
+    bool m_is_loaded : 1;
+    bool m_is_type_resolved : 1;
+    bool m_is_content_type_uncertain : 1;
 
-    bool m_can_mount = false;
-    bool m_can_unmount = false;
-    bool m_can_eject = false;
+    //access
+    bool m_can_read : 1;
+    bool m_can_write : 1;
+    bool m_can_excute : 1;
+    bool m_can_delete : 1;
+    bool m_can_trash : 1;
+    bool m_can_rename : 1;
 
-    bool m_can_start = false;
-    bool m_can_stop = false;
+    bool m_can_mount : 1;
+    bool m_can_unmount : 1;
+    bool m_can_eject : 1;
 
-    //FIXME: should i use smart pointer wrap these data?
-    GFile *m_file = nullptr;
-    GFile *m_parent = nullptr;
+    bool m_can_start : 1;
+    bool m_can_stop : 1;
 
-    GFile *m_target_file = nullptr;
+    /*!
+     * \brief m_file
+     * Created at first time in gFileHandle().
+     */
+    QAtomicPointer<GFile> m_file;
 
     /*!
      * \brief m_cancellable
      * This cancellable is used in async query file info in FileInfoJob instance.
+     * It is created when the first async query started.
      */
     GCancellable *m_cancellable = nullptr;
 
@@ -44,7 +44,7 @@ FileLaunchAction *FileLaunchManager::getDefaultAction(const QString &uri)
     auto info = FileInfo::fromUri(uri);
     QString mimeType = info->mimeType();
 
-    if (mimeType.isEmpty()) {
+    if (mimeType.isEmpty() || info->isContentTypeUncertain()) {
         FileInfoJob job(info);
         job.querySync();
         mimeType = info->mimeType();
@@ -69,7 +69,7 @@ const QList<FileLaunchAction*> FileLaunchManager::getRecommendActions(const QStr
 {
     auto info = FileInfo::fromUri(uri);
     QString mimeType = info->mimeType();
-    if (mimeType.isEmpty()) {
+    if (mimeType.isEmpty() || info->isContentTypeUncertain()) {
         FileInfoJob job(info);
         job.querySync();
         mimeType = info->mimeType();
@@ -90,7 +90,7 @@ const QList<FileLaunchAction*> FileLaunchManager::getFallbackActions(const QStri
 {
     auto info = FileInfo::fromUri(uri);
     QString mimeType = info->mimeType();
-    if (mimeType.isEmpty()) {
+    if (mimeType.isEmpty() || info->isContentTypeUncertain()) {
         FileInfoJob job(info);
         job.querySync();
         mimeType = info->mimeType();
@@ -111,7 +111,7 @@ const QList<FileLaunchAction*> FileLaunchManager::getAllActionsForType(const QSt
 {
     auto info = FileInfo::fromUri(uri);
     QString mimeType = info->mimeType();
-    if (mimeType.isEmpty()) {
+    if (mimeType.isEmpty() || info->isContentTypeUncertain()) {
         FileInfoJob job(info);
         job.querySync();
         mimeType = info->mimeType();
@@ -170,7 +170,7 @@ void FileLaunchManager::openAsync(const QString &uri, bool forceWithArg, bool sk
 void FileLaunchManager::setDefaultLauchAction(const QString &uri, FileLaunchAction *action)
 {
     auto info = FileInfo::fromUri(uri, false);
-    if (info->mimeType().isEmpty()) {
+    if (info->mimeType().isEmpty() || info->isContentTypeUncertain()) {
         FileInfoJob job(info);
         job.querySync();
     }
@@ -22,6 +22,7 @@
 
 #include "file-watcher.h"
 #include "gerror-wrapper.h"
+#include "desktop-entry-cache.h"
 
 #include "file-label-model.h"
 
@@ -33,6 +34,24 @@
 
 using namespace Peony;
 
+/*!
+ * \brief invalidateDesktopEntry
+ * DesktopEntryCache doesn't check the launchers at lookup, drop the changed ones here.
+ */
+static void invalidateDesktopEntry(GFile *file)
+{
+    if (!file)
+        return;
+
+    char *path = g_file_get_path(file);
+    if (!path)
+        return;
+    QString desktopFilePath = path;
+    g_free(path);
+    if (DesktopEntryCache::isDesktopFilePath(desktopFilePath))
+        DesktopEntryCache::getInstance()->remove(desktopFilePath);
+}
+
 FileWatcher::FileWatcher(QString uri, QObject *parent) : QObject(parent)
 {
     m_uri = uri;
@@ -245,7 +264,8 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
 {
     //qDebug()<<"dir_changed_callback";
     Q_UNUSED(monitor);
-    Q_UNUSED(other_file);
+    invalidateDesktopEntry(file);
+    invalidateDesktopEntry(other_file);
     switch (event_type) {
     case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
     case G_FILE_MONITOR_EVENT_CHANGED: {
@@ -21,7 +21,7 @@
  */
 
 #include "global-settings.h"
-#include <QtConcurrent>
+#include "io-executor.h"
 
 #include <QGSettings>
 
@@ -93,7 +93,7 @@ bool GlobalSettings::isExist(const QString &key)
 void GlobalSettings::reset(const QString &key)
 {
     m_cache.remove(key);
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         if (m_mutex.tryLock(1000)) {
             m_settings->remove(key);
             m_settings->sync();
@@ -110,7 +110,7 @@ void GlobalSettings::resetAll()
     for (auto key : tmp) {
         Q_EMIT this->valueChanged(key);
     }
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         if (m_mutex.tryLock(1000)) {
             m_settings->clear();
             m_settings->sync();
@@ -122,7 +122,7 @@ void GlobalSettings::resetAll()
 void GlobalSettings::setValue(const QString &key, const QVariant &value)
 {
     m_cache.insert(key, value);
-    QtConcurrent::run([=]() {
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
         if (m_mutex.tryLock(1000)) {
             m_settings->setValue(key, value);
             m_settings->sync();
@@ -39,6 +39,10 @@
 #define DEFAULT_WINDOW_SIZE "default-window-size"
 #define DEFAULT_SIDEBAR_WIDTH "default-sidebar-width"
 
+//a string list of uri schemes, such as "smb", "sftp" or "mtp",
+//the listings of these locations are cached on disk.
+#define PERSISTENT_LISTING_CACHE_SCHEMES "persistent-listing-cache-schemes"
+
 #define DEFAULT_VIEW_ID "directory-view/default-view-id"
 #define DEFAULT_VIEW_ZOOM_LEVEL "directory-view/default-view-zoom-level"
 
@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "icon-pixmap-cache.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionViewItem>
+
+using namespace Peony;
+
+static IconPixmapCache *global_instance = nullptr;
+
+IconPixmapCache *IconPixmapCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new IconPixmapCache;
+    return global_instance;
+}
+
+IconPixmapCache::IconPixmapCache(QObject *parent) : QObject(parent)
+{
+    m_pixmaps.setMaxCost(PEONY_ICON_PIXMAP_CACHE_MAX_COST);
+    m_theme_name = QIcon::themeName();
+}
+
+void IconPixmapCache::checkTheme()
+{
+    QString themeName = QIcon::themeName();
+    if (themeName == m_theme_name)
+        return;
+
+    m_theme_name = themeName;
+    m_pixmaps.clear();
+}
+
+void IconPixmapCache::clear()
+{
+    m_pixmaps.clear();
+}
+
+/*!
+ * \brief pixmapKey
+ * \return the key of a pixmap. The device pixel ratio is a part of key,
+ * as QIcon::pixmap() renders with it.
+ */
+static QString pixmapKey(const QString &key, const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    return QString("%1-%2x%3-%4-%5-%6").arg(key).arg(size.width()).arg(size.height())
+            .arg(qApp->devicePixelRatio()).arg(int(mode)).arg(int(state));
+}
+
+const QPixmap IconPixmapCache::insertPixmap(const QString &fullKey, const QIcon &icon, const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    QPixmap pixmap = icon.isNull()? QPixmap(): icon.pixmap(size, mode, state);
+    int cost = qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+    m_pixmaps.insert(fullKey, new QPixmap(pixmap), cost);
+    return pixmap;
+}
+
+const QPixmap IconPixmapCache::pixmap(const QIcon &icon, const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    if (icon.isNull() || !size.isValid())
+        return QPixmap();
+
+    checkTheme();
+    QString fullKey = pixmapKey(QString::number(icon.cacheKey()), size, mode, state);
+    if (auto cached = m_pixmaps.object(fullKey))
+        return *cached;
+    return insertPixmap(fullKey, icon, size, mode, state);
+}
+
+const QPixmap IconPixmapCache::emblem(const QString &iconName, const QSize &size)
+{
+    checkTheme();
+    QString fullKey = pixmapKey("emblem:" + iconName, size, QIcon::Normal, QIcon::Off);
+    if (auto cached = m_pixmaps.object(fullKey))
+        return *cached;
+    //a missing emblem is cached as a null pixmap too.
+    return insertPixmap(fullKey, QIcon::fromTheme(iconName), size, QIcon::Normal, QIcon::Off);
+}
+
+void IconPixmapCache::paintPixmap(QPainter *painter, const QPixmap &pixmap, const QRect &rect, Qt::Alignment alignment)
+{
+    if (pixmap.isNull())
+        return;
+    //the same as QIcon::paint().
+    QSize size = pixmap.size() / pixmap.devicePixelRatio();
+    QRect alignedRect = QStyle::alignedRect(painter->layoutDirection(), alignment, size, rect);
+    painter->drawPixmap(alignedRect, pixmap);
+}
+
+void IconPixmapCache::paintDecoration(QPainter *painter, const QIcon &icon, const QRect &rect, const QStyleOptionViewItem &option)
+{
+    //the same mode and state as QCommonStyle uses for CE_ItemViewItem.
+    QIcon::Mode mode = QIcon::Normal;
+    if (!option.state.testFlag(QStyle::State_Enabled))
+        mode = QIcon::Disabled;
+    else if (option.state.testFlag(QStyle::State_Selected))
+        mode = QIcon::Selected;
+    QIcon::State state = option.state.testFlag(QStyle::State_Open)? QIcon::On: QIcon::Off;
+
+    paintPixmap(painter, pixmap(icon, rect.size(), mode, state), rect, option.decorationAlignment);
+}
+
+void IconPixmapCache::paintEmblem(QPainter *painter, const QString &iconName, const QRect &rect, Qt::Alignment alignment)
+{
+    paintPixmap(painter, emblem(iconName, rect.size()), rect, alignment);
+}
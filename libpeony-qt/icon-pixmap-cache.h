@@ -0,0 +1,102 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ICONPIXMAPCACHE_H
+#define ICONPIXMAPCACHE_H
+
+#include <QObject>
+#include "peony-core_global.h"
+
+#include <QCache>
+#include <QIcon>
+#include <QPixmap>
+
+/*!
+ * \brief PEONY_ICON_PIXMAP_CACHE_MAX_COST
+ * The max size of the pixmaps IconPixmapCache keeps, in kilobytes.
+ */
+#ifndef PEONY_ICON_PIXMAP_CACHE_MAX_COST
+#define PEONY_ICON_PIXMAP_CACHE_MAX_COST 65536
+#endif
+
+class QPainter;
+class QStyleOptionViewItem;
+
+namespace Peony {
+
+/*!
+ * \brief The IconPixmapCache class
+ * <br>
+ * IconPixmapCache keeps the rasterized decorations and emblems of the item views,
+ * keyed by the icon, the size, the device pixel ratio and the icon mode. Painting
+ * an item whose decoration was painted before is just a pixmap blit, without
+ * asking the icon engine again.
+ * </br>
+ * <br>
+ * A decoration is keyed by QIcon::cacheKey(). The themed icons are shared by
+ * ThemeIconCache, so all the items with a same icon share one pixmap. The cache
+ * is dropped when the views zoomed, as all the sizes change, and when the icon
+ * theme changed, as the emblems are keyed by their names.
+ * </br>
+ * \note QPixmap should only be used in gui thread, so does this class.
+ */
+class PEONYCORESHARED_EXPORT IconPixmapCache : public QObject
+{
+    Q_OBJECT
+public:
+    static IconPixmapCache *getInstance();
+
+    /*!
+     * \brief pixmap
+     * \return the same pixmap as QIcon::pixmap(size, mode, state), from cache if possible.
+     */
+    const QPixmap pixmap(const QIcon &icon, const QSize &size, QIcon::Mode mode = QIcon::Normal, QIcon::State state = QIcon::Off);
+    /*!
+     * \brief emblem
+     * \return the pixmap of the themed emblem icon, or a null pixmap if it is not in the theme.
+     */
+    const QPixmap emblem(const QString &iconName, const QSize &size);
+
+    /*!
+     * \brief paintDecoration
+     * Paint the icon in rect like QStyle does with the decoration of option,
+     * the mode and state of icon is decided by the state of option.
+     */
+    void paintDecoration(QPainter *painter, const QIcon &icon, const QRect &rect, const QStyleOptionViewItem &option);
+    void paintEmblem(QPainter *painter, const QString &iconName, const QRect &rect, Qt::Alignment alignment = Qt::AlignCenter);
+
+public Q_SLOTS:
+    void clear();
+
+protected:
+    void checkTheme();
+    void paintPixmap(QPainter *painter, const QPixmap &pixmap, const QRect &rect, Qt::Alignment alignment);
+    const QPixmap insertPixmap(const QString &fullKey, const QIcon &icon, const QSize &size, QIcon::Mode mode, QIcon::State state);
+
+private:
+    explicit IconPixmapCache(QObject *parent = nullptr);
+
+    QCache<QString, QPixmap> m_pixmaps;
+    QString m_theme_name;
+};
+
+}
+
+#endif // ICONPIXMAPCACHE_H
@@ -0,0 +1,222 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "io-executor.h"
+
+#include <QThreadPool>
+#include <QThread>
+#include <QMutexLocker>
+
+#include <glib.h>
+
+/*!
+ * \brief PEONY_IO_EXECUTOR_MIN_THREAD_COUNT
+ * The i/o tasks mostly wait for the disks or the network, so we use
+ * more workers than cores on small machines.
+ */
+#ifndef PEONY_IO_EXECUTOR_MIN_THREAD_COUNT
+#define PEONY_IO_EXECUTOR_MIN_THREAD_COUNT 4
+#endif
+
+using namespace Peony;
+
+IoCancellationGroup::IoCancellationGroup(QObject *parent) : QObject(parent)
+{
+    m_token.m_state = std::make_shared<QAtomicInt>(0);
+}
+
+IoCancellationGroup::~IoCancellationGroup()
+{
+    m_token.m_state->storeRelease(1);
+}
+
+void IoCancellationGroup::cancel()
+{
+    m_token.m_state->storeRelease(1);
+    m_token.m_state = std::make_shared<QAtomicInt>(0);
+    Q_EMIT cancelled();
+}
+
+namespace Peony {
+
+class IoTaskRunnable : public QRunnable
+{
+public:
+    IoTaskRunnable(IoExecutor *executor, IoExecutor::Priority priority, const IoExecutor::Task &task) {
+        m_executor = executor;
+        m_priority = priority;
+        m_task = task;
+    }
+
+    void run() override {
+        //the group might be cancelled while the task is waiting for a worker.
+        if (m_task.token.isCancelled()) {
+            if (m_task.dropped)
+                m_task.dropped();
+        } else {
+            m_task.run();
+        }
+        m_executor->taskFinished(m_priority);
+    }
+
+private:
+    IoExecutor *m_executor;
+    IoExecutor::Priority m_priority;
+    IoExecutor::Task m_task;
+};
+
+}
+
+IoExecutor *IoExecutor::getInstance()
+{
+    //the executor might be used in worker threads at first time.
+    static IoExecutor *global_instance = new IoExecutor;
+    return global_instance;
+}
+
+IoExecutor::IoExecutor(QObject *parent) : QObject(parent)
+{
+    m_max_thread_count = qMax(QThread::idealThreadCount(), PEONY_IO_EXECUTOR_MIN_THREAD_COUNT);
+
+    m_thread_pool = new QThreadPool(this);
+    m_thread_pool->setMaxThreadCount(m_max_thread_count);
+
+    for (int i = 0; i < PriorityCount; i++) {
+        m_running_counts[i] = 0;
+    }
+    m_concurrency_limits[VisibleDirectory] = m_max_thread_count;
+    //the thumbnailers create QPixmap and QIcon, which are not thread safe,
+    //so they are run one by one. see ThumbnailManager::createThumbnailInternal().
+    m_concurrency_limits[VisibleThumbnail] = 1;
+    m_concurrency_limits[Background] = qMax(2, m_max_thread_count/2);
+    m_concurrency_limits[Prefetch] = 1;
+}
+
+int IoExecutor::ioPriority(Priority priority)
+{
+    switch (priority) {
+    case VisibleDirectory:
+        return G_PRIORITY_HIGH;
+    case VisibleThumbnail:
+        return G_PRIORITY_DEFAULT;
+    case Background:
+        return G_PRIORITY_DEFAULT_IDLE;
+    default:
+        return G_PRIORITY_LOW;
+    }
+}
+
+void IoExecutor::setConcurrencyLimit(Priority priority, int limit)
+{
+    QList<Task> dropped;
+    QMutexLocker locker(&m_mutex);
+    m_concurrency_limits[priority] = qMax(1, limit);
+    dispatch(dropped);
+    locker.unlock();
+
+    dropTasks(dropped);
+}
+
+int IoExecutor::concurrencyLimit(Priority priority)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_concurrency_limits[priority];
+}
+
+void IoExecutor::submit(Priority priority,
+                        const std::function<void()> &task,
+                        const IoCancellationToken &token,
+                        const std::function<void()> &dropped)
+{
+    Task t;
+    t.run = task;
+    t.dropped = dropped;
+    t.token = token;
+
+    QList<Task> droppedTasks;
+    QMutexLocker locker(&m_mutex);
+    m_queues[priority].enqueue(t);
+    dispatch(droppedTasks);
+    locker.unlock();
+
+    dropTasks(droppedTasks);
+}
+
+void IoExecutor::start(QRunnable *runnable, Priority priority, const IoCancellationToken &token)
+{
+    bool autoDelete = runnable->autoDelete();
+    submit(priority, [=]() {
+        runnable->run();
+        if (autoDelete)
+            delete runnable;
+    }, token, [=]() {
+        if (autoDelete)
+            delete runnable;
+    });
+}
+
+void IoExecutor::dispatch(QList<Task> &dropped)
+{
+    while (m_running_count < m_max_thread_count) {
+        int priority = 0;
+        for (; priority < PriorityCount; priority++) {
+            if (m_queues[priority].isEmpty())
+                continue;
+            if (m_running_counts[priority] >= m_concurrency_limits[priority])
+                continue;
+            //keep the last worker for the visible directory.
+            if (priority != VisibleDirectory && m_running_count >= m_max_thread_count - 1)
+                continue;
+            break;
+        }
+        if (priority == PriorityCount)
+            return;
+
+        Task task = m_queues[priority].dequeue();
+        if (task.token.isCancelled()) {
+            dropped<<task;
+            continue;
+        }
+
+        m_running_counts[priority]++;
+        m_running_count++;
+        m_thread_pool->start(new IoTaskRunnable(this, Priority(priority), task));
+    }
+}
+
+void IoExecutor::taskFinished(Priority priority)
+{
+    QList<Task> dropped;
+    QMutexLocker locker(&m_mutex);
+    m_running_counts[priority]--;
+    m_running_count--;
+    dispatch(dropped);
+    locker.unlock();
+
+    dropTasks(dropped);
+}
+
+void IoExecutor::dropTasks(const QList<Task> &dropped)
+{
+    for (auto task : dropped) {
+        if (task.dropped)
+            task.dropped();
+    }
+}
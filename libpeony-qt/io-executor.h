@@ -0,0 +1,249 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IOEXECUTOR_H
+#define IOEXECUTOR_H
+
+#include <QObject>
+#include "peony-core_global.h"
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QQueue>
+
+#include <functional>
+#include <memory>
+
+class QThreadPool;
+class QRunnable;
+
+namespace Peony {
+
+/*!
+ * \brief The IoCancellationToken class
+ * <br>
+ * A token is handed to the tasks submitted with a IoCancellationGroup.
+ * It is cheap to copy and safe to read in any thread, and it stays valid
+ * after the group is destroyed.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT IoCancellationToken
+{
+    friend class IoCancellationGroup;
+public:
+    IoCancellationToken() {}
+
+    bool isNull() const {
+        return !m_state;
+    }
+    bool isCancelled() const {
+        return m_state && m_state->load() != 0;
+    }
+
+private:
+    std::shared_ptr<QAtomicInt> m_state;
+};
+
+/*!
+ * \brief The IoCancellationGroup class
+ * <br>
+ * A group collects the background work started for a view or a tab, such as
+ * the enumeration of its directory and the thumbnails of its items. When the
+ * user navigates away, cancel() drops all the queued tasks of the group at once,
+ * and the running ones can check their token to stop early.
+ * </br>
+ * <br>
+ * The group can be reused after cancel(), the tasks submitted later get a new token.
+ * The group is cancelled when it is destroyed.
+ * </br>
+ * \see IoExecutor.
+ */
+class PEONYCORESHARED_EXPORT IoCancellationGroup : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IoCancellationGroup(QObject *parent = nullptr);
+    ~IoCancellationGroup();
+
+    /*!
+     * \brief token
+     * \return the token of current generation.
+     */
+    const IoCancellationToken token() const {
+        return m_token;
+    }
+
+Q_SIGNALS:
+    /*!
+     * \brief cancelled
+     * Sent after the tokens handed out so far are cancelled. The holders of GIO
+     * async operations should cancel them in this signal.
+     */
+    void cancelled();
+
+public Q_SLOTS:
+    void cancel();
+
+private:
+    IoCancellationToken m_token;
+};
+
+/*!
+ * \brief The IoExecutor class
+ * <br>
+ * IoExecutor is the shared executor of the background i/o in libpeony-qt.
+ * The tasks are queued by their priority classes, and a queued task is started
+ * only when a worker is free and its class is under its concurrency limit.
+ * The workers are always taken by the higher classes first.
+ * </br>
+ * <br>
+ * The last worker is kept for VisibleDirectory, so the directory the user is
+ * looking at is never starved by thumbnailing, counting or prefetching.
+ * </br>
+ * <br>
+ * GIO async operations are not run by the executor, they should use
+ * ioPriority() of their class as the io_priority, and cancel themselves
+ * when their IoCancellationGroup is cancelled.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT IoExecutor : public QObject
+{
+    friend class IoTaskRunnable;
+    Q_OBJECT
+public:
+    enum Priority {
+        VisibleDirectory,
+        VisibleThumbnail,
+        Background,
+        Prefetch,
+        PriorityCount
+    };
+    Q_ENUM(Priority)
+
+    static IoExecutor *getInstance();
+
+    /*!
+     * \brief ioPriority
+     * \param priority
+     * \return the io_priority should be used by GIO async operations of the class.
+     */
+    static int ioPriority(Priority priority);
+
+    int maxThreadCount() {
+        return m_max_thread_count;
+    }
+    void setConcurrencyLimit(Priority priority, int limit);
+    int concurrencyLimit(Priority priority);
+
+    /*!
+     * \brief submit
+     * \param priority
+     * \param task, run in a worker thread.
+     * \param token, if it is cancelled before the task started, the task is dropped.
+     * \param dropped, called instead of task when the task is dropped.
+     * It might be called in any thread.
+     */
+    void submit(Priority priority,
+                const std::function<void()> &task,
+                const IoCancellationToken &token = IoCancellationToken(),
+                const std::function<void()> &dropped = nullptr);
+
+    /*!
+     * \brief start
+     * \param runnable
+     * \param priority
+     * \param token
+     * <br>
+     * Same as QThreadPool::start(), the runnable is deleted after it finished
+     * (or dropped) if its autoDelete() is true.
+     * </br>
+     */
+    void start(QRunnable *runnable,
+               Priority priority = Background,
+               const IoCancellationToken &token = IoCancellationToken());
+
+    /*!
+     * \brief run
+     * \param priority
+     * \param function
+     * \param token
+     * \return a future of the result, which is cancelled if the task is dropped.
+     * <br>
+     * The future can be watched by a QFutureWatcher like QtConcurrent::run().
+     * </br>
+     */
+    template <typename T>
+    QFuture<T> run(Priority priority,
+                   const std::function<T()> &function,
+                   const IoCancellationToken &token = IoCancellationToken())
+    {
+        QFutureInterface<T> futureInterface;
+        futureInterface.reportStarted();
+        auto future = futureInterface.future();
+
+        submit(priority, [=]() mutable {
+            futureInterface.reportResult(function());
+            futureInterface.reportFinished();
+        }, token, [=]() mutable {
+            futureInterface.reportCanceled();
+            futureInterface.reportFinished();
+        });
+        return future;
+    }
+
+protected:
+    struct Task
+    {
+        std::function<void()> run;
+        std::function<void()> dropped;
+        IoCancellationToken token;
+    };
+
+    /*!
+     * \brief dispatch
+     * \param dropped, the tasks found cancelled, they should be dropped
+     * after m_mutex unlocked.
+     * Start the queued tasks while there are free workers. It must be called
+     * with m_mutex locked.
+     */
+    void dispatch(QList<Task> &dropped);
+    void taskFinished(Priority priority);
+
+    static void dropTasks(const QList<Task> &dropped);
+
+private:
+    explicit IoExecutor(QObject *parent = nullptr);
+
+    QThreadPool *m_thread_pool = nullptr;
+    int m_max_thread_count = 0;
+
+    QQueue<Task> m_queues[PriorityCount];
+    int m_running_counts[PriorityCount];
+    int m_concurrency_limits[PriorityCount];
+    int m_running_count = 0;
+
+    QMutex m_mutex;
+};
+
+}
+
+#endif // IOEXECUTOR_H
@@ -0,0 +1,434 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "local-directory-reader.h"
+#include "desktop-entry-cache.h"
+
+#include <QAtomicInt>
+#include <QHash>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+
+using namespace Peony;
+
+/*!
+ * \brief statx_unsupported
+ * Set if the kernel doesn't support statx(), then we use fstatat() instead.
+ */
+static QAtomicInt statx_unsupported;
+
+static GFileType fileTypeFromMode(quint32 mode)
+{
+    if (S_ISDIR(mode))
+        return G_FILE_TYPE_DIRECTORY;
+    if (S_ISREG(mode))
+        return G_FILE_TYPE_REGULAR;
+    if (S_ISLNK(mode))
+        return G_FILE_TYPE_SYMBOLIC_LINK;
+    return G_FILE_TYPE_SPECIAL;
+}
+
+static GFileType fileTypeFromDirent(unsigned char type)
+{
+    switch (type) {
+    case DT_DIR:
+        return G_FILE_TYPE_DIRECTORY;
+    case DT_REG:
+        return G_FILE_TYPE_REGULAR;
+    case DT_LNK:
+        return G_FILE_TYPE_SYMBOLIC_LINK;
+    case DT_CHR:
+    case DT_BLK:
+    case DT_FIFO:
+    case DT_SOCK:
+        return G_FILE_TYPE_SPECIAL;
+    default:
+        return G_FILE_TYPE_UNKNOWN;
+    }
+}
+
+/*!
+ * \brief specialDirectoryIconNames
+ * \return the icon names of home and xdg user directories, the same as GIO's local backend.
+ */
+static const QHash<QByteArray, QByteArray> &specialDirectoryIconNames()
+{
+    static const QHash<QByteArray, QByteArray> names = []() {
+        QHash<QByteArray, QByteArray> hash;
+        hash.insert(g_get_home_dir(), "user-home");
+        const struct {
+            GUserDirectory directory;
+            const char *icon_name;
+        } directories[] = {
+            {G_USER_DIRECTORY_DESKTOP, "user-desktop"},
+            {G_USER_DIRECTORY_DOCUMENTS, "folder-documents"},
+            {G_USER_DIRECTORY_DOWNLOAD, "folder-download"},
+            {G_USER_DIRECTORY_MUSIC, "folder-music"},
+            {G_USER_DIRECTORY_PICTURES, "folder-pictures"},
+            {G_USER_DIRECTORY_PUBLIC_SHARE, "folder-publicshare"},
+            {G_USER_DIRECTORY_TEMPLATES, "folder-templates"},
+            {G_USER_DIRECTORY_VIDEOS, "folder-videos"},
+        };
+        for (auto directory : directories) {
+            const char *path = g_get_user_special_dir(directory.directory);
+            if (path && !hash.contains(path))
+                hash.insert(path, directory.icon_name);
+        }
+        return hash;
+    }();
+    return names;
+}
+
+LocalDirectoryReader::LocalDirectoryReader(const QByteArray &path, bool statChildren)
+{
+    m_path = path;
+    m_stat_children = statChildren;
+}
+
+LocalDirectoryReader::~LocalDirectoryReader()
+{
+    if (m_dir)
+        closedir(m_dir);
+}
+
+QByteArray LocalDirectoryReader::nativePath(GFile *dir)
+{
+    if (!dir || !g_file_has_uri_scheme(dir, "file"))
+        return QByteArray();
+
+    char *path = g_file_get_path(dir);
+    if (!path)
+        return QByteArray();
+    QByteArray nativePath(path);
+    g_free(path);
+    return nativePath;
+}
+
+bool LocalDirectoryReader::open()
+{
+    int fd = ::open(m_path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        m_error_code = errno;
+        return false;
+    }
+    m_dir = fdopendir(fd);
+    if (!m_dir) {
+        m_error_code = errno;
+        ::close(fd);
+        return false;
+    }
+
+    if (!m_stat_children)
+        return true;
+
+    //GIO checks the access of every file with access(), we compute it from
+    //the mode bits instead, which needs the credentials and the state of the
+    //directory.
+    struct stat dirStat;
+    if (fstat(fd, &dirStat) == 0) {
+        m_device = dirStat.st_dev;
+        m_owner = dirStat.st_uid;
+        m_is_sticky = dirStat.st_mode & S_ISVTX;
+    }
+    struct statvfs fsStat;
+    if (fstatvfs(fd, &fsStat) == 0) {
+        m_is_read_only = fsStat.f_flag & ST_RDONLY;
+    }
+    m_is_writable = access(m_path.constData(), W_OK) == 0;
+
+    m_uid = getuid();
+    int groupsCount = getgroups(0, nullptr);
+    if (groupsCount > 0) {
+        m_groups.resize(groupsCount);
+        groupsCount = getgroups(groupsCount, m_groups.data());
+        m_groups.resize(qMax(groupsCount, 0));
+    }
+    m_groups<<getgid();
+
+    //files on the same file system with home can always be trashed.
+    struct stat homeStat;
+    if (stat(g_get_home_dir(), &homeStat) == 0 && quint64(homeStat.st_dev) == m_device)
+        m_has_trash_dir = 1;
+
+    return true;
+}
+
+int LocalDirectoryReader::read(QVector<LocalDirectoryEntry> &entries, int maxCount)
+{
+    if (!m_dir || m_at_end)
+        return 0;
+
+    int fd = dirfd(m_dir);
+    int count = 0;
+    while (count < maxCount) {
+        errno = 0;
+        struct dirent *dirEntry = readdir(m_dir);
+        if (!dirEntry) {
+            if (errno != 0)
+                m_error_code = errno;
+            m_at_end = true;
+            break;
+        }
+
+        const char *name = dirEntry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+
+        LocalDirectoryEntry entry;
+        entry.name = name;
+        entry.type = fileTypeFromDirent(dirEntry->d_type);
+
+        //the type of a symbolic link is the type of its target, as GIO does.
+        if (m_stat_children || entry.type == G_FILE_TYPE_SYMBOLIC_LINK || entry.type == G_FILE_TYPE_UNKNOWN) {
+            if (!statEntry(fd, name, false, entry)) {
+                //the file was removed after we read it.
+                continue;
+            }
+            if (S_ISLNK(entry.mode)) {
+                entry.is_symlink = true;
+                if (!statEntry(fd, name, true, entry)) {
+                    entry.is_broken_symlink = true;
+                    entry.type = G_FILE_TYPE_SYMBOLIC_LINK;
+                }
+            }
+            if (m_stat_children) {
+                resolveContentType(entry);
+                readMetadata(entry);
+                char *displayName = g_filename_display_name(entry.name.constData());
+                entry.display_name = QString::fromUtf8(displayName);
+                g_free(displayName);
+                entry.file_id = QString("l%1:%2").arg(entry.device).arg(entry.inode);
+            }
+
+            //parse the launchers here rather than in gui thread.
+            if (m_stat_children && entry.type == G_FILE_TYPE_REGULAR && hasAccess(entry, 1) &&
+                    entry.name.endsWith(".desktop")) {
+                QByteArray path = m_path;
+                if (!path.endsWith('/'))
+                    path += '/';
+                path += entry.name;
+                DesktopEntryCache::getInstance()->entry(QString::fromUtf8(path), qint64(entry.modified_time));
+            }
+        }
+
+        if (m_stat_children) {
+            if (m_has_trash_dir < 0)
+                resolveTrashDir(entry);
+            resolveAccess(entry);
+        }
+
+        entries<<entry;
+        count++;
+    }
+    return count;
+}
+
+bool LocalDirectoryReader::statEntry(int dirFd, const char *name, bool follow, LocalDirectoryEntry &entry)
+{
+#ifdef STATX_BASIC_STATS
+    if (!statx_unsupported.load()) {
+        struct statx stx;
+        int flags = AT_NO_AUTOMOUNT | (follow? 0: AT_SYMLINK_NOFOLLOW);
+        unsigned int mask = STATX_TYPE | STATX_MODE | STATX_UID | STATX_GID |
+                            STATX_SIZE | STATX_MTIME | STATX_ATIME | STATX_INO;
+        if (statx(dirFd, name, flags, mask, &stx) == 0) {
+            entry.mode = stx.stx_mode;
+            entry.uid = stx.stx_uid;
+            entry.gid = stx.stx_gid;
+            entry.size = stx.stx_size;
+            entry.modified_time = stx.stx_mtime.tv_sec;
+            entry.access_time = stx.stx_atime.tv_sec;
+            entry.device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+            entry.inode = stx.stx_ino;
+            entry.type = fileTypeFromMode(entry.mode);
+            entry.is_stated = true;
+            return true;
+        }
+        if (errno != ENOSYS)
+            return false;
+        statx_unsupported.store(1);
+    }
+#endif
+
+    struct stat st;
+    if (fstatat(dirFd, name, &st, follow? 0: AT_SYMLINK_NOFOLLOW) != 0)
+        return false;
+
+    entry.mode = st.st_mode;
+    entry.uid = st.st_uid;
+    entry.gid = st.st_gid;
+    entry.size = st.st_size;
+    entry.modified_time = st.st_mtime;
+    entry.access_time = st.st_atime;
+    entry.device = st.st_dev;
+    entry.inode = st.st_ino;
+    entry.type = fileTypeFromMode(entry.mode);
+    entry.is_stated = true;
+    return true;
+}
+
+void LocalDirectoryReader::resolveContentType(LocalDirectoryEntry &entry)
+{
+    //same as the fast content type of GIO's local backend, we never sniff
+    //the file contents here.
+    if (entry.is_broken_symlink) {
+        entry.content_type = "inode/symlink";
+    } else if (S_ISDIR(entry.mode)) {
+        entry.content_type = "inode/directory";
+    } else if (S_ISCHR(entry.mode)) {
+        entry.content_type = "inode/chardevice";
+    } else if (S_ISBLK(entry.mode)) {
+        entry.content_type = "inode/blockdevice";
+    } else if (S_ISFIFO(entry.mode)) {
+        entry.content_type = "inode/fifo";
+    } else if (S_ISSOCK(entry.mode)) {
+        entry.content_type = "inode/socket";
+    } else if (S_ISREG(entry.mode) && entry.size == 0) {
+        entry.content_type = "application/x-zerosize";
+    } else {
+        gboolean uncertain = FALSE;
+        char *contentType = g_content_type_guess(entry.name.constData(), nullptr, 0, &uncertain);
+        entry.content_type = contentType;
+        g_free(contentType);
+        //a non-empty regular file could be sniffed later.
+        entry.is_content_type_uncertain = uncertain && S_ISREG(entry.mode);
+    }
+}
+
+bool LocalDirectoryReader::hasAccess(const LocalDirectoryEntry &entry, int bit)
+{
+    if (entry.is_broken_symlink)
+        return false;
+
+    if (m_uid == 0) {
+        if (bit == 1)
+            return S_ISDIR(entry.mode) || (entry.mode & (S_IXUSR | S_IXGRP | S_IXOTH));
+        return true;
+    }
+
+    if (entry.uid == m_uid)
+        return entry.mode & (bit << 6);
+    if (m_groups.contains(entry.gid))
+        return entry.mode & (bit << 3);
+    return entry.mode & bit;
+}
+
+void LocalDirectoryReader::resolveAccess(LocalDirectoryEntry &entry)
+{
+    entry.can_read = hasAccess(entry, 4);
+    entry.can_write = !m_is_read_only && hasAccess(entry, 2);
+    entry.can_execute = hasAccess(entry, 1);
+
+    bool canDelete = m_is_writable && !m_is_read_only;
+    if (canDelete && m_is_sticky && m_uid != 0)
+        canDelete = entry.uid == m_uid || m_owner == m_uid;
+    entry.can_delete = canDelete;
+    entry.can_trash = canDelete && m_has_trash_dir > 0;
+}
+
+void LocalDirectoryReader::loadMetadata()
+{
+    m_is_metadata_loaded = true;
+
+    GFile *dir = g_file_new_for_path(m_path.constData());
+    GFileEnumerator *enumerator = g_file_enumerate_children(dir,
+                                  G_FILE_ATTRIBUTE_STANDARD_NAME "," "metadata::*",
+                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                  nullptr,
+                                  nullptr);
+    g_object_unref(dir);
+    if (!enumerator)
+        return;
+
+    while (GFileInfo *info = g_file_enumerator_next_file(enumerator, nullptr, nullptr)) {
+        //most files have no metadata, don't keep their infos.
+        if (g_file_info_has_namespace(info, "metadata")) {
+            m_metadata.insert(g_file_info_get_name(info), std::shared_ptr<GFileInfo>(info, g_object_unref));
+        } else {
+            g_object_unref(info);
+        }
+    }
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+}
+
+void LocalDirectoryReader::readMetadata(LocalDirectoryEntry &entry)
+{
+    if (!m_is_metadata_loaded)
+        loadMetadata();
+    entry.metadata = m_metadata.take(entry.name);
+}
+
+void LocalDirectoryReader::resolveTrashDir(const LocalDirectoryEntry &entry)
+{
+    //the directory is not on the file system of home, GIO looks up the trash
+    //directories of the mount. Ask it once for this directory, with its first
+    //entry. A failed check means the files can not be trashed.
+    m_has_trash_dir = 0;
+    if (!m_is_writable || m_is_read_only)
+        return;
+
+    QByteArray path = m_path;
+    if (!path.endsWith('/'))
+        path += '/';
+    path += entry.name;
+    GFile *file = g_file_new_for_path(path.constData());
+    GFileInfo *info = g_file_query_info(file,
+                                        G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                        nullptr,
+                                        nullptr);
+    g_object_unref(file);
+    if (!info)
+        return;
+
+    m_has_trash_dir = g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH)? 1: 0;
+    g_object_unref(info);
+}
+
+GIcon *LocalDirectoryReader::specialDirectoryIcon(const QByteArray &path, bool symbolic)
+{
+    const auto &names = specialDirectoryIconNames();
+    if (!names.contains(path))
+        return nullptr;
+
+    QByteArray iconName = names.value(path);
+    QByteArray fallbackName = "folder";
+    if (symbolic) {
+        iconName += "-symbolic";
+        fallbackName += "-symbolic";
+    }
+    const char *iconNames[] = {iconName.constData(), fallbackName.constData()};
+    return g_themed_icon_new_from_names(const_cast<char **>(iconNames), 2);
+}
+
+QString LocalDirectoryReader::childUri(const LocalDirectoryEntry &entry)
+{
+    QByteArray path = m_path;
+    if (!path.endsWith('/'))
+        path += '/';
+    path += entry.name;
+    return QString("file://%1").arg(QString::fromUtf8(path));
+}
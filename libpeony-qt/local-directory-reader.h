@@ -0,0 +1,206 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LOCALDIRECTORYREADER_H
+#define LOCALDIRECTORYREADER_H
+
+#include "peony-core_global.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include <gio/gio.h>
+#include <dirent.h>
+#include <sys/types.h>
+
+namespace Peony {
+
+/*!
+ * \brief The LocalDirectoryEntry struct
+ * <br>
+ * A raw directory entry read by LocalDirectoryReader. If the reader stats
+ * its children, the stat fields and the resolved fields are valid, otherwise
+ * only the name and the type are.
+ * </br>
+ * \see FileInfoJob::refreshInfoContents().
+ */
+struct LocalDirectoryEntry
+{
+    QByteArray name;
+    QByteArray content_type;
+    GFileType type = G_FILE_TYPE_UNKNOWN;
+    /*!
+     * \brief is_content_type_uncertain
+     * True if content_type was guessed by an ambiguous name,
+     * see FileInfo::isContentTypeUncertain().
+     */
+    bool is_content_type_uncertain = false;
+
+    //resolved in the worker thread, so that the gui thread only copies them.
+    QString display_name;
+    QString file_id;
+    bool can_read = false;
+    bool can_write = false;
+    bool can_execute = false;
+    bool can_delete = false;
+    bool can_trash = false;
+
+    bool is_stated = false;
+    bool is_symlink = false;
+    bool is_broken_symlink = false;
+
+    quint32 mode = 0;
+    quint32 uid = 0;
+    quint32 gid = 0;
+    quint64 size = 0;
+    quint64 modified_time = 0;
+    quint64 access_time = 0;
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    /*!
+     * \brief metadata
+     * The metadata::* attributes of the file, nullptr if it has none.
+     */
+    std::shared_ptr<GFileInfo> metadata;
+};
+
+/*!
+ * \brief The LocalDirectoryReader class
+ * <br>
+ * LocalDirectoryReader lists a native local directory with readdir() (which
+ * is getdents64 under the hood) and statx(), relative to the directory fd.
+ * It skips the whole GIO machinery, such as the per-file access() calls,
+ * xattr and selinux lookups and the content sniffing, which makes it much
+ * faster than a GFileEnumerator for large local directories.
+ * </br>
+ * <br>
+ * open() and read() only do the syscalls and the metadata lookups, they can be
+ * called in a worker thread.
+ * read() resolves the fields of a listing query of GIO's local backend into
+ * the entries, with a fast (name guessed) content type, and without the icons.
+ * The metadata attributes are read in one bulk query of the directory, so the
+ * gui thread only copies the entries into the infos.
+ * </br>
+ * \see FileEnumerator::setNativeBackendEnabled().
+ */
+class PEONYCORESHARED_EXPORT LocalDirectoryReader
+{
+public:
+    explicit LocalDirectoryReader(const QByteArray &path, bool statChildren = true);
+    ~LocalDirectoryReader();
+
+    /*!
+     * \brief nativePath
+     * \param dir
+     * \return the local path of dir, or an empty array if dir is not a file:// location.
+     */
+    static QByteArray nativePath(GFile *dir);
+
+    /*!
+     * \brief specialDirectoryIcon
+     * \param path
+     * \param symbolic
+     * \return a new icon if path is home or a xdg user directory, otherwise nullptr.
+     */
+    static GIcon *specialDirectoryIcon(const QByteArray &path, bool symbolic);
+
+    const QByteArray &path() {
+        return m_path;
+    }
+
+    /*!
+     * \brief open
+     * \return true if the directory is opened, otherwise errorCode() is the errno.
+     */
+    bool open();
+    bool isOpened() {
+        return m_dir;
+    }
+    int errorCode() {
+        return m_error_code;
+    }
+
+    /*!
+     * \brief read
+     * \param entries, the read entries will be appended to.
+     * \param maxCount
+     * \return the count of read entries, atEnd() is true if there are no more entries.
+     */
+    int read(QVector<LocalDirectoryEntry> &entries, int maxCount);
+    bool atEnd() {
+        return m_at_end;
+    }
+
+    /*!
+     * \brief childUri
+     * \return the uri of entry, in the form FileEnumerator uses for local children.
+     */
+    QString childUri(const LocalDirectoryEntry &entry);
+
+protected:
+    bool statEntry(int dirFd, const char *name, bool follow, LocalDirectoryEntry &entry);
+    void resolveContentType(LocalDirectoryEntry &entry);
+    bool hasAccess(const LocalDirectoryEntry &entry, int bit);
+    void resolveAccess(LocalDirectoryEntry &entry);
+    void loadMetadata();
+    void readMetadata(LocalDirectoryEntry &entry);
+    void resolveTrashDir(const LocalDirectoryEntry &entry);
+
+private:
+    QByteArray m_path;
+    bool m_stat_children = true;
+
+    DIR *m_dir = nullptr;
+    int m_error_code = 0;
+    bool m_at_end = false;
+
+    //the permission context of the directory, see open().
+    uid_t m_uid = 0;
+    QVector<gid_t> m_groups;
+    quint64 m_device = 0;
+    quint32 m_owner = 0;
+    bool m_is_read_only = false;
+    bool m_is_writable = false;
+    bool m_is_sticky = false;
+    /*!
+     * \brief m_has_trash_dir
+     * -1 if we don't know yet whether the files of this directory can be trashed.
+     * It is resolved by read() once, a failed check is kept as 0.
+     */
+    int m_has_trash_dir = -1;
+
+    /*!
+     * \brief m_metadata
+     * The metadata of the children which have any, by name. The metadata is
+     * stored by gvfs and only GIO can read it, so loadMetadata() enumerates the
+     * directory once for it, instead of querying every entry.
+     */
+    QHash<QByteArray, std::shared_ptr<GFileInfo>> m_metadata;
+    bool m_is_metadata_loaded = false;
+};
+
+}
+
+#endif // LOCALDIRECTORYREADER_H
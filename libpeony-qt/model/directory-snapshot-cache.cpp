@@ -0,0 +1,183 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "directory-snapshot-cache.h"
+
+#include "file-info.h"
+#include "file-watcher.h"
+
+#include <QUrl>
+
+#include <QDebug>
+
+using namespace Peony;
+
+static DirectorySnapshotCache *global_instance = nullptr;
+
+DirectorySnapshot::DirectorySnapshot(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children, QObject *parent) : QObject(parent)
+{
+    m_uri = uri;
+    m_children = children;
+}
+
+DirectorySnapshot::~DirectorySnapshot()
+{
+    stopMonitor();
+}
+
+bool DirectorySnapshot::isMonitored()
+{
+    return m_watcher && m_watcher->supportMonitor();
+}
+
+void DirectorySnapshot::startMonitor()
+{
+    m_watcher = std::make_shared<FileWatcher>(m_uri);
+    m_watcher->setMonitorChildrenChange(true);
+
+    connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](const QString &uri) {
+        auto info = FileInfo::fromUri(uri);
+        if (!m_children.contains(info))
+            m_children<<info;
+        m_changed_uris<<info->uri();
+    });
+    connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](const QString &uri) {
+        QString decodedUri = QUrl(uri).toDisplayString();
+        for (auto child : m_children) {
+            if (child->uri() == decodedUri) {
+                m_children.removeOne(child);
+                break;
+            }
+        }
+        m_changed_uris.remove(decodedUri);
+    });
+    connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
+        m_changed_uris<<QUrl(uri).toDisplayString();
+    });
+
+    connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=]() {
+        Q_EMIT invalidated(m_uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=]() {
+        Q_EMIT invalidated(m_uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
+        Q_EMIT invalidated(m_uri);
+    });
+
+    m_watcher->startMonitor();
+}
+
+void DirectorySnapshot::stopMonitor()
+{
+    if (!m_watcher)
+        return;
+
+    m_watcher->disconnect(this);
+    m_watcher->stopMonitor();
+    m_watcher.reset();
+}
+
+DirectorySnapshotCache *DirectorySnapshotCache::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new DirectorySnapshotCache;
+    }
+    return global_instance;
+}
+
+DirectorySnapshotCache::DirectorySnapshotCache(QObject *parent) : QObject(parent)
+{
+
+}
+
+DirectorySnapshotCache::~DirectorySnapshotCache()
+{
+    clear();
+}
+
+void DirectorySnapshotCache::insert(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children)
+{
+    if (uri.isEmpty() || m_max_count <= 0)
+        return;
+
+    remove(uri);
+
+    auto snapshot = std::make_shared<DirectorySnapshot>(uri, children);
+    connect(snapshot.get(), &DirectorySnapshot::invalidated, this, &DirectorySnapshotCache::remove, Qt::QueuedConnection);
+    snapshot->startMonitor();
+
+    m_snapshots.insert(uri, snapshot);
+    m_lru_uris.append(uri);
+
+    trim();
+}
+
+std::shared_ptr<DirectorySnapshot> DirectorySnapshotCache::take(const QString &uri)
+{
+    auto snapshot = m_snapshots.take(uri);
+    if (!snapshot)
+        return nullptr;
+
+    m_lru_uris.removeOne(uri);
+    snapshot->disconnect(this);
+    snapshot->stopMonitor();
+    return snapshot;
+}
+
+void DirectorySnapshotCache::setMaxCount(int count)
+{
+    m_max_count = count;
+    trim();
+}
+
+void DirectorySnapshotCache::setMaxCost(int cost)
+{
+    m_max_cost = cost;
+    trim();
+}
+
+void DirectorySnapshotCache::remove(const QString &uri)
+{
+    m_snapshots.remove(uri);
+    m_lru_uris.removeOne(uri);
+}
+
+void DirectorySnapshotCache::clear()
+{
+    m_snapshots.clear();
+    m_lru_uris.clear();
+}
+
+void DirectorySnapshotCache::trim()
+{
+    //the snapshots grow while they are monitored, so count the cost here.
+    qint64 totalCost = 0;
+    for (auto snapshot : m_snapshots) {
+        totalCost += snapshot->cost();
+    }
+
+    while (!m_lru_uris.isEmpty() && (m_lru_uris.count() > m_max_count || totalCost > m_max_cost)) {
+        auto uri = m_lru_uris.takeFirst();
+        auto snapshot = m_snapshots.take(uri);
+        if (snapshot)
+            totalCost -= snapshot->cost();
+    }
+}
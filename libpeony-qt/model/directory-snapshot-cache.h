@@ -0,0 +1,181 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DIRECTORYSNAPSHOTCACHE_H
+#define DIRECTORYSNAPSHOTCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+#include <memory>
+
+/*!
+ * \brief PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COUNT
+ * The max count of directories kept in snapshot cache.
+ */
+#ifndef PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COUNT
+#define PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COUNT 8
+#endif
+
+/*!
+ * \brief PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COST
+ * The max estimated memory in bytes of all the cached snapshots.
+ */
+#ifndef PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COST
+#define PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COST 64*1024*1024
+#endif
+
+/*!
+ * \brief PEONY_DIRECTORY_SNAPSHOT_ENTRY_COST
+ * The estimated memory in bytes of a child in snapshot, including its info.
+ */
+#ifndef PEONY_DIRECTORY_SNAPSHOT_ENTRY_COST
+#define PEONY_DIRECTORY_SNAPSHOT_ENTRY_COST 512
+#endif
+
+namespace Peony {
+
+class FileInfo;
+class FileWatcher;
+
+/*!
+ * \brief The DirectorySnapshot class
+ * <br>
+ * A snapshot holds the children infos of a directory which has been
+ * enumerated. While it is cached, a FileWatcher keeps its children list
+ * up to date, and records the children which are created or changed, so
+ * that the restored view only need refresh these children.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT DirectorySnapshot : public QObject
+{
+    friend class DirectorySnapshotCache;
+    Q_OBJECT
+public:
+    explicit DirectorySnapshot(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children, QObject *parent = nullptr);
+    ~DirectorySnapshot();
+
+    const QString uri() {
+        return m_uri;
+    }
+    const QList<std::shared_ptr<FileInfo>> children() {
+        return m_children;
+    }
+    /*!
+     * \brief changedUris
+     * \return the children created or changed while the snapshot was cached.
+     */
+    const QStringList changedUris() {
+        return m_changed_uris.toList();
+    }
+    /*!
+     * \brief isMonitored
+     * \return false if the directory doesn't support monitoring, in that
+     * case the changes were not recorded, the holder should re-enumerate
+     * the directory for reconciling.
+     */
+    bool isMonitored();
+
+    int cost() {
+        return (m_children.count() + 1)*PEONY_DIRECTORY_SNAPSHOT_ENTRY_COST;
+    }
+
+Q_SIGNALS:
+    /*!
+     * \brief invalidated
+     * The directory was deleted, moved or unmounted, the snapshot is useless.
+     */
+    void invalidated(const QString &uri);
+
+protected:
+    void startMonitor();
+    void stopMonitor();
+
+private:
+    QString m_uri;
+    QList<std::shared_ptr<FileInfo>> m_children;
+    QSet<QString> m_changed_uris;
+    std::shared_ptr<FileWatcher> m_watcher;
+};
+
+/*!
+ * \brief The DirectorySnapshotCache class
+ * <br>
+ * An LRU cache of recently visited directories' snapshots. When a view leaves
+ * a directory, the model puts the loaded children into the cache, and when a
+ * view enters a cached directory again, the model takes the snapshot and
+ * shows it instantly instead of enumerating the directory from scratch.
+ * </br>
+ * <br>
+ * The cache is bounded by both the count of snapshots and their estimated
+ * memory cost.
+ * </br>
+ * \see FileItem::findChildrenAsync(), FileItemModel::setRootItem().
+ */
+class PEONYCORESHARED_EXPORT DirectorySnapshotCache : public QObject
+{
+    Q_OBJECT
+public:
+    static DirectorySnapshotCache *getInstance();
+
+    void insert(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children);
+    /*!
+     * \brief take
+     * \param uri
+     * \return the snapshot of the directory, or nullptr if not cached.
+     * The snapshot is removed from the cache, and it stops monitoring.
+     */
+    std::shared_ptr<DirectorySnapshot> take(const QString &uri);
+    bool contains(const QString &uri) {
+        return m_snapshots.contains(uri);
+    }
+
+    void setMaxCount(int count);
+    void setMaxCost(int cost);
+
+public Q_SLOTS:
+    void remove(const QString &uri);
+    void clear();
+
+protected:
+    void trim();
+
+private:
+    explicit DirectorySnapshotCache(QObject *parent = nullptr);
+    ~DirectorySnapshotCache();
+
+    QHash<QString, std::shared_ptr<DirectorySnapshot>> m_snapshots;
+    /*!
+     * \brief m_lru_uris
+     * The most recently used uri is at the end.
+     */
+    QStringList m_lru_uris;
+
+    int m_max_count = PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COUNT;
+    int m_max_cost = PEONY_DIRECTORY_SNAPSHOT_CACHE_MAX_COST;
+};
+
+}
+
+#endif // DIRECTORYSNAPSHOTCACHE_H
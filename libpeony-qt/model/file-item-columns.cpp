@@ -0,0 +1,393 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "file-item-columns.h"
+#include "file-item-sort-key.h"
+#include "file-item-model.h"
+
+using namespace Peony;
+
+template <typename T>
+static void insertValue(std::vector<T> &column, int row)
+{
+    column.insert(column.begin() + row, T());
+}
+
+template <typename T>
+static void removeValues(std::vector<T> &column, int first, int count)
+{
+    column.erase(column.begin() + first, column.begin() + first + count);
+}
+
+template <typename T>
+static void permuteValues(std::vector<T> &column, const std::vector<int> &rows)
+{
+    std::vector<T> values;
+    values.reserve(rows.size());
+    for (int row : rows) {
+        values.push_back(column[row]);
+    }
+    column.swap(values);
+}
+
+void FileItemColumns::reserve(int count)
+{
+    m_name_offsets.reserve(count);
+    m_display_lengths.reserve(count);
+    m_lower_lengths.reserve(count);
+    m_base_lengths.reserve(count);
+    m_base_hashes.reserve(count);
+    m_duplicated_numbers.reserve(count);
+    m_collator_indexes.reserve(count);
+    m_sizes.reserve(count);
+    m_modified_times.reserve(count);
+    m_type_ids.reserve(count);
+    m_type_categories.reserve(count);
+    m_flags.reserve(count);
+}
+
+/*!
+ * \brief MIN_COMPACT_NAME_LENGTH
+ * The arena is not compacted until it has at least this length of unused names.
+ */
+static const int MIN_COMPACT_NAME_LENGTH = 4096;
+
+void FileItemColumns::insert(int row, const Row &values)
+{
+    insertValue(m_name_offsets, row);
+    insertValue(m_display_lengths, row);
+    insertValue(m_lower_lengths, row);
+    insertValue(m_base_lengths, row);
+    insertValue(m_base_hashes, row);
+    insertValue(m_duplicated_numbers, row);
+    insertValue(m_collator_indexes, row);
+    insertValue(m_sizes, row);
+    insertValue(m_modified_times, row);
+    insertValue(m_type_ids, row);
+    insertValue(m_type_categories, row);
+    insertValue(m_flags, row);
+    m_collator_indexes[row] = -1;
+    setValues(row, values);
+}
+
+void FileItemColumns::update(int row, const Row &values)
+{
+    setValues(row, values);
+    compact();
+}
+
+bool FileItemColumns::hasValues(int row, const Row &values) const
+{
+    return displayName(row) == values.display_name &&
+            m_sizes[row] == values.size &&
+            m_modified_times[row] == values.modified_time &&
+            m_type_categories[row] == values.type_categories &&
+            isDir(row) == values.is_dir &&
+            m_type_id_hash.value(values.file_type, quint16(m_types.size())) == m_type_ids[row];
+}
+
+void FileItemColumns::remove(int first, int count)
+{
+    for (int row = first; row < first + count; row++) {
+        m_dead_name_length += nameSlotLength(row);
+        if (m_collator_indexes[row] >= 0)
+            m_dead_collator_count++;
+    }
+    removeValues(m_name_offsets, first, count);
+    removeValues(m_display_lengths, first, count);
+    removeValues(m_lower_lengths, first, count);
+    removeValues(m_base_lengths, first, count);
+    removeValues(m_base_hashes, first, count);
+    removeValues(m_duplicated_numbers, first, count);
+    removeValues(m_collator_indexes, first, count);
+    removeValues(m_sizes, first, count);
+    removeValues(m_modified_times, first, count);
+    removeValues(m_type_ids, first, count);
+    removeValues(m_type_categories, first, count);
+    removeValues(m_flags, first, count);
+    compact();
+}
+
+void FileItemColumns::permute(const std::vector<int> &rows)
+{
+    //the names stay in the arena, only their offsets move with the rows.
+    permuteValues(m_name_offsets, rows);
+    permuteValues(m_display_lengths, rows);
+    permuteValues(m_lower_lengths, rows);
+    permuteValues(m_base_lengths, rows);
+    permuteValues(m_base_hashes, rows);
+    permuteValues(m_duplicated_numbers, rows);
+    permuteValues(m_collator_indexes, rows);
+    permuteValues(m_sizes, rows);
+    permuteValues(m_modified_times, rows);
+    permuteValues(m_type_ids, rows);
+    permuteValues(m_type_categories, rows);
+    permuteValues(m_flags, rows);
+}
+
+int FileItemColumns::nameSlotLength(int row) const
+{
+    return m_display_lengths[row] + m_lower_lengths[row] + m_base_lengths[row];
+}
+
+void FileItemColumns::compact()
+{
+    int liveLength = m_names.size() - m_dead_name_length;
+    if (m_dead_name_length >= MIN_COMPACT_NAME_LENGTH && m_dead_name_length > liveLength) {
+        QString names;
+        names.reserve(liveLength);
+        for (int row = 0; row < count(); row++) {
+            int offset = names.size();
+            names.append(m_names.midRef(int(m_name_offsets[row]), nameSlotLength(row)));
+            m_name_offsets[row] = quint32(offset);
+        }
+        m_names = names;
+        m_dead_name_length = 0;
+    }
+
+    int liveCount = int(m_collator_keys.size()) - m_dead_collator_count;
+    if (m_dead_collator_count > 0 && m_dead_collator_count > liveCount) {
+        std::vector<QCollatorSortKey> keys;
+        keys.reserve(liveCount);
+        for (int row = 0; row < count(); row++) {
+            if (m_collator_indexes[row] < 0)
+                continue;
+            keys.push_back(m_collator_keys[m_collator_indexes[row]]);
+            m_collator_indexes[row] = int(keys.size()) - 1;
+        }
+        m_collator_keys.swap(keys);
+        m_dead_collator_count = 0;
+    }
+}
+
+void FileItemColumns::setValues(int row, const Row &values)
+{
+    const QString &displayName = values.display_name;
+    QString lowerName = displayName.toLower();
+    int number = 0;
+    QString base = FileItemSortKey::duplicatedBase(displayName, &number);
+
+    //the slot of the row is the display name, followed by the lowercased name
+    //and the duplicated base if they differ from it.
+    quint8 flags = 0;
+    QString slot = displayName;
+    quint16 lowerLength = 0;
+    if (lowerName == displayName) {
+        flags |= LowerIsDisplay;
+    } else {
+        slot.append(lowerName);
+        lowerLength = quint16(lowerName.size());
+    }
+    quint16 baseLength = 0;
+    if (base.size() != displayName.size()) {
+        flags |= HasDuplicatedSuffix;
+        slot.append(base);
+        baseLength = quint16(base.size());
+    }
+
+    //write over the old slot if the new one fits, or append it.
+    int oldLength = nameSlotLength(row);
+    if (oldLength > 0 && slot.size() <= oldLength) {
+        m_names.replace(int(m_name_offsets[row]), slot.size(), slot);
+        m_dead_name_length += oldLength - slot.size();
+    } else {
+        m_name_offsets[row] = quint32(m_names.size());
+        m_names.append(slot);
+        m_dead_name_length += oldLength;
+    }
+    m_display_lengths[row] = quint16(displayName.size());
+    m_lower_lengths[row] = lowerLength;
+    m_base_lengths[row] = baseLength;
+    m_base_hashes[row] = qHash(base);
+    m_duplicated_numbers[row] = number;
+
+    //reuse the collator key of the row if it has one.
+    int collatorIndex = m_collator_indexes[row];
+    if (FileItemSortKey::startsWithChinese(displayName)) {
+        flags |= StartsWithChinese;
+        if (collatorIndex >= 0) {
+            m_collator_keys[collatorIndex] = FileItemSortKey::collatorKey(displayName);
+        } else {
+            m_collator_indexes[row] = int(m_collator_keys.size());
+            m_collator_keys.push_back(FileItemSortKey::collatorKey(displayName));
+        }
+    } else if (collatorIndex >= 0) {
+        m_collator_indexes[row] = -1;
+        m_dead_collator_count++;
+    }
+
+    if (values.is_dir)
+        flags |= IsDir;
+    if (!displayName.isEmpty() && displayName.at(0) == '.')
+        flags |= IsHidden;
+    m_flags[row] = flags;
+
+    m_sizes[row] = values.size;
+    m_modified_times[row] = values.modified_time;
+    m_type_ids[row] = typeId(values.file_type);
+    m_type_categories[row] = values.type_categories;
+}
+
+quint16 FileItemColumns::typeId(const QString &fileType)
+{
+    auto it = m_type_id_hash.constFind(fileType);
+    if (it != m_type_id_hash.constEnd())
+        return *it;
+
+    quint16 id = quint16(m_types.size());
+    m_types.push_back(FileItemSortKey::sharedTypeOrdinal(fileType));
+    m_type_id_hash.insert(fileType, id);
+    return id;
+}
+
+std::vector<int> FileItemColumns::typeOrdinals() const
+{
+    std::vector<int> ordinals;
+    ordinals.reserve(m_types.size());
+    for (auto &ordinal : m_types) {
+        ordinals.push_back(*ordinal);
+    }
+    return ordinals;
+}
+
+QStringRef FileItemColumns::displayName(int row) const
+{
+    return QStringRef(&m_names, int(m_name_offsets[row]), m_display_lengths[row]);
+}
+
+QStringRef FileItemColumns::lowerName(int row) const
+{
+    if (m_flags[row] & LowerIsDisplay)
+        return displayName(row);
+    return QStringRef(&m_names, int(m_name_offsets[row]) + m_display_lengths[row], m_lower_lengths[row]);
+}
+
+QStringRef FileItemColumns::duplicatedBase(int row) const
+{
+    if (!(m_flags[row] & HasDuplicatedSuffix))
+        return displayName(row);
+    return QStringRef(&m_names,
+                      int(m_name_offsets[row]) + m_display_lengths[row] + m_lower_lengths[row],
+                      m_base_lengths[row]);
+}
+
+bool FileItemColumns::lessThan(int left,
+                               int right,
+                               int column,
+                               Qt::SortOrder order,
+                               bool folderFirst,
+                               bool chineseFirst) const
+{
+    return lessThan(left, *m_types[m_type_ids[left]], right, *m_types[m_type_ids[right]],
+                    column, order, folderFirst, chineseFirst);
+}
+
+bool FileItemColumns::lessThan(int left,
+                               int right,
+                               const std::vector<int> &typeOrdinals,
+                               int column,
+                               Qt::SortOrder order,
+                               bool folderFirst,
+                               bool chineseFirst) const
+{
+    return lessThan(left, typeOrdinals[m_type_ids[left]], right, typeOrdinals[m_type_ids[right]],
+                    column, order, folderFirst, chineseFirst);
+}
+
+bool FileItemColumns::lessThan(int left,
+                               int leftTypeOrdinal,
+                               int right,
+                               int rightTypeOrdinal,
+                               int column,
+                               Qt::SortOrder order,
+                               bool folderFirst,
+                               bool chineseFirst) const
+{
+    //the same order as FileItemSortKey::lessThan().
+    if (folderFirst && isDir(left) != isDir(right)) {
+        if (order == Qt::AscendingOrder)
+            return isDir(left);
+        return !isDir(left);
+    }
+
+    switch (column) {
+    case FileItemModel::FileName:
+        return nameLessThan(left, right, order, chineseFirst);
+    case FileItemModel::FileSize:
+        return m_sizes[left] < m_sizes[right];
+    case FileItemModel::FileType:
+        return leftTypeOrdinal < rightTypeOrdinal;
+    case FileItemModel::ModifiedDate:
+        return m_modified_times[left] < m_modified_times[right];
+    default:
+        return false;
+    }
+}
+
+bool FileItemColumns::nameLessThan(int left, int right, Qt::SortOrder order, bool chineseFirst) const
+{
+    if (m_base_hashes[left] == m_base_hashes[right] && duplicatedBase(left) == duplicatedBase(right)) {
+        if (m_duplicated_numbers[left] == m_duplicated_numbers[right])
+            return displayName(left) < displayName(right);
+        return m_duplicated_numbers[left] < m_duplicated_numbers[right];
+    }
+
+    if (chineseFirst) {
+        bool leftChinese = m_flags[left] & StartsWithChinese;
+        bool rightChinese = m_flags[right] & StartsWithChinese;
+        //all start with Chinese, use the locale compare.
+        if (leftChinese && rightChinese)
+            return m_collator_keys[m_collator_indexes[left]].compare(m_collator_keys[m_collator_indexes[right]]) < 0;
+        if (leftChinese || rightChinese) {
+            if (order == Qt::AscendingOrder)
+                return leftChinese;
+            return rightChinese;
+        }
+    }
+
+    return lowerName(left) < lowerName(right);
+}
+
+bool FileItemColumns::sameSortValues(int row, const Row &values, int column, bool folderFirst) const
+{
+    if (folderFirst && isDir(row) != values.is_dir)
+        return false;
+
+    switch (column) {
+    case FileItemModel::FileName:
+        return displayName(row) == values.display_name;
+    case FileItemModel::FileSize:
+        return m_sizes[row] == values.size;
+    case FileItemModel::FileType:
+        return m_types[m_type_ids[row]] == FileItemSortKey::sharedTypeOrdinal(values.file_type);
+    case FileItemModel::ModifiedDate:
+        return m_modified_times[row] == values.modified_time;
+    default:
+        return true;
+    }
+}
+
+void FileItemColumns::fillFilterKey(int row, FileItemFilterKey &key) const
+{
+    key.is_hidden = m_flags[row] & IsHidden;
+    key.type_categories = m_type_categories[row];
+    key.modified_time = qint64(m_modified_times[row]);
+    key.size = m_sizes[row];
+}
@@ -0,0 +1,216 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILEITEMCOLUMNS_H
+#define FILEITEMCOLUMNS_H
+
+#include "peony-core_global.h"
+#include "file-item-filter-predicate.h"
+
+#include <QString>
+#include <QStringRef>
+#include <QHash>
+#include <QCollatorSortKey>
+
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief PEONY_COLUMNAR_ROW_THRESHOLD
+ * The flat directories with at least this number of rows are sorted and
+ * filtered on a FileItemColumns table instead of the keys of each item.
+ */
+#ifndef PEONY_COLUMNAR_ROW_THRESHOLD
+#define PEONY_COLUMNAR_ROW_THRESHOLD 200000
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The FileItemColumns class
+ * <br>
+ * FileItemColumns keeps the values FileItemProxyFilterSortModel sorts and filters
+ * the top level rows on as contiguous columns, one value per source row: the names
+ * in one string arena with their offsets and lengths, the sizes, the modified times,
+ * the file type ids and the flag bits. Comparing or filtering a row only reads a
+ * few arrays, instead of following the keys of every item on the heap.
+ * </br>
+ * <br>
+ * It is a mirror of the values of the FileInfo of each row, not the storage of the
+ * rows: the model still keeps one FileItem and one FileInfo per row, which the views
+ * read. The proxy drops the keys of the items when it builds the table, only a label
+ * filter creates the filter keys again, so the values are not kept three times.
+ * </br>
+ * <br>
+ * The file types are stored as ids of a small type table, its ordinals are shared
+ * with FileItemSortKey, so they stay correct when a new type appears. The worker
+ * threads should compare with the ordinals taken by typeOrdinals() in gui thread.
+ * </br>
+ * <br>
+ * A changed row is written over its old names if they fit, otherwise appended to
+ * the arena. The space of the replaced and removed names, and of the unused collator
+ * keys, is given back by compacting the table once it is more than the live part.
+ * </br>
+ * \note The table must not be modified while other threads read it, copy it instead.
+ */
+class PEONYCORESHARED_EXPORT FileItemColumns
+{
+public:
+    struct Row
+    {
+        QString display_name;
+        QString file_type;
+        quint32 type_categories = 0;
+        quint64 size = 0;
+        quint64 modified_time = 0;
+        bool is_dir = false;
+    };
+
+    int count() const {
+        return int(m_sizes.size());
+    }
+    void reserve(int count);
+
+    void insert(int row, const Row &values);
+    void update(int row, const Row &values);
+    void remove(int first, int count);
+    /*!
+     * \brief permute
+     * \param rows, the old row of every new row.
+     * Reorder the rows the same way as FileItemModel::permuteChildren().
+     */
+    void permute(const std::vector<int> &rows);
+
+    /*!
+     * \brief hasValues
+     * \return true if the row already holds values, so update() is not needed.
+     */
+    bool hasValues(int row, const Row &values) const;
+
+    bool isDir(int row) const {
+        return m_flags[row] & IsDir;
+    }
+
+    /*!
+     * \brief typeOrdinals
+     * \return the current ordinals of the type ids, it must be called in gui thread.
+     */
+    std::vector<int> typeOrdinals() const;
+
+    /*!
+     * \brief lessThan
+     * \return the same result as FileItemSortKey::lessThan() for the keys of the rows.
+     */
+    bool lessThan(int left,
+                  int right,
+                  int column,
+                  Qt::SortOrder order,
+                  bool folderFirst,
+                  bool chineseFirst) const;
+    bool lessThan(int left,
+                  int right,
+                  const std::vector<int> &typeOrdinals,
+                  int column,
+                  Qt::SortOrder order,
+                  bool folderFirst,
+                  bool chineseFirst) const;
+
+    /*!
+     * \brief sameSortValues
+     * \return true if the row is placed the same with values when sorted by column.
+     * \see FileItemSortKey::sameSortValues().
+     */
+    bool sameSortValues(int row, const Row &values, int column, bool folderFirst) const;
+
+    /*!
+     * \brief fillFilterKey
+     * Fill the values of the row into key, except the labels.
+     */
+    void fillFilterKey(int row, FileItemFilterKey &key) const;
+
+private:
+    enum Flag {
+        IsDir = 0x1,
+        IsHidden = 0x2,
+        StartsWithChinese = 0x4,
+        LowerIsDisplay = 0x8,
+        HasDuplicatedSuffix = 0x10
+    };
+
+    bool lessThan(int left,
+                  int leftTypeOrdinal,
+                  int right,
+                  int rightTypeOrdinal,
+                  int column,
+                  Qt::SortOrder order,
+                  bool folderFirst,
+                  bool chineseFirst) const;
+
+    void setValues(int row, const Row &values);
+    int nameSlotLength(int row) const;
+    void compact();
+    quint16 typeId(const QString &fileType);
+
+    QStringRef displayName(int row) const;
+    QStringRef lowerName(int row) const;
+    QStringRef duplicatedBase(int row) const;
+    bool nameLessThan(int left, int right, Qt::SortOrder order, bool chineseFirst) const;
+
+    /*!
+     * \brief m_names
+     * The arena of the names. The display name of a row is followed by its
+     * lowercased name and its duplicated base, if they differ from it.
+     */
+    QString m_names;
+    std::vector<quint32> m_name_offsets;
+    std::vector<quint16> m_display_lengths;
+    std::vector<quint16> m_lower_lengths;
+    std::vector<quint16> m_base_lengths;
+    std::vector<uint> m_base_hashes;
+    std::vector<int> m_duplicated_numbers;
+
+    /*!
+     * \brief m_collator_indexes
+     * The index of the collator key in m_collator_keys, only the names
+     * start with chinese have one.
+     */
+    std::vector<int> m_collator_indexes;
+    std::vector<QCollatorSortKey> m_collator_keys;
+
+    /*!
+     * \brief m_dead_name_length
+     * The length of the names in m_names which no row uses, see compact().
+     */
+    int m_dead_name_length = 0;
+    int m_dead_collator_count = 0;
+
+    std::vector<quint64> m_sizes;
+    std::vector<quint64> m_modified_times;
+    std::vector<quint16> m_type_ids;
+    std::vector<quint32> m_type_categories;
+    std::vector<quint8> m_flags;
+
+    QHash<QString, quint16> m_type_id_hash;
+    std::vector<std::shared_ptr<int>> m_types;
+};
+
+}
+
+#endif // FILEITEMCOLUMNS_H
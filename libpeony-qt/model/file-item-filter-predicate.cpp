@@ -0,0 +1,83 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "file-item-filter-predicate.h"
+
+using namespace Peony;
+
+bool FileItemFilterPredicate::accepts(const FileItemFilterKey &key) const
+{
+    if (!show_hidden && key.is_hidden)
+        return false;
+
+    if (type_mask != 0 && !(key.type_categories & type_mask))
+        return false;
+
+    if (time_filter_enabled) {
+        bool accepted = false;
+        for (const auto &range : time_ranges) {
+            if (key.modified_time >= range.first && key.modified_time < range.second) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+            return false;
+    }
+
+    if (size_filter_enabled) {
+        bool accepted = false;
+        for (const auto &range : size_ranges) {
+            if (key.size >= range.first && key.size <= range.second) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+            return false;
+    }
+
+    for (const auto &clause : label_clauses) {
+        if (!intersects(key.label_bits, clause))
+            return false;
+    }
+
+    return true;
+}
+
+void FileItemFilterPredicate::setLabelBit(FileLabelBits &bits, int id)
+{
+    if (id < 0)
+        return;
+    int word = id / 64;
+    if (bits.count() <= word)
+        bits.resize(word + 1);
+    bits[word] |= quint64(1) << (id % 64);
+}
+
+bool FileItemFilterPredicate::intersects(const FileLabelBits &left, const FileLabelBits &right)
+{
+    int count = qMin(left.count(), right.count());
+    for (int i = 0; i < count; i++) {
+        if (left.at(i) & right.at(i))
+            return true;
+    }
+    return false;
+}
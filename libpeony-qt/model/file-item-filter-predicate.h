@@ -0,0 +1,114 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILEITEMFILTERPREDICATE_H
+#define FILEITEMFILTERPREDICATE_H
+
+#include "peony-core_global.h"
+
+#include <QVector>
+#include <QPair>
+
+namespace Peony {
+
+/*!
+ * \brief FileLabelBits
+ * A bitset of label ids, bit n is set if the label with id n is included.
+ */
+typedef QVector<quint64> FileLabelBits;
+
+/*!
+ * \brief The FileItemFilterKey struct
+ * <br>
+ * The values of an item FileItemFilterPredicate checks, created by
+ * FileItemProxyFilterSortModel once the info of an item arrives. The label
+ * ids are read from the file metadata only if a label condition is active.
+ * </br>
+ */
+struct FileItemFilterKey
+{
+    bool is_hidden = false;
+    /*!
+     * \brief type_categories
+     * Bit n is set if the content type is in the FileItemProxyFilterSortModel::FilterFileType n.
+     */
+    quint32 type_categories = 0;
+    qint64 modified_time = 0;
+    quint64 size = 0;
+
+    bool labels_loaded = false;
+    FileLabelBits label_bits;
+};
+
+/*!
+ * \brief The FileItemFilterPredicate class
+ * <br>
+ * The active filter conditions of FileItemProxyFilterSortModel, compiled once
+ * when they changed. The file types are a bitmask of categories, the modified
+ * time conditions are ranges of seconds computed from the current date, and
+ * every label condition is a set of label ids which a file must have one of.
+ * So checking a row does not allocate or look up the label model.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT FileItemFilterPredicate
+{
+public:
+    bool accepts(const FileItemFilterKey &key) const;
+
+    bool needLabels() const {
+        return !label_clauses.isEmpty();
+    }
+
+    static void setLabelBit(FileLabelBits &bits, int id);
+    static bool intersects(const FileLabelBits &left, const FileLabelBits &right);
+
+    bool show_hidden = false;
+
+    /*!
+     * \brief type_mask
+     * The accepted type categories, 0 means all types are accepted.
+     */
+    quint32 type_mask = 0;
+
+    /*!
+     * \brief time_ranges
+     * [start, end) of the accepted modified time in seconds, only used if
+     * time_filter_enabled is true.
+     */
+    bool time_filter_enabled = false;
+    QVector<QPair<qint64, qint64>> time_ranges;
+
+    /*!
+     * \brief size_ranges
+     * [min, max] of the accepted size, only used if size_filter_enabled is true.
+     */
+    bool size_filter_enabled = false;
+    QVector<QPair<quint64, quint64>> size_ranges;
+
+    /*!
+     * \brief label_clauses
+     * A file is accepted if it has at least one label of every clause.
+     */
+    QVector<FileLabelBits> label_clauses;
+};
+
+}
+
+#endif // FILEITEMFILTERPREDICATE_H
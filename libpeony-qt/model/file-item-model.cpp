@@ -23,6 +23,9 @@
 #include "file-item-model.h"
 #include "file-item.h"
 #include "file-info.h"
+#include "file-info-batch-job.h"
+#include "directory-snapshot-cache.h"
+#include "persistent-listing-cache.h"
 
 #include "file-operation-manager.h"
 #include "file-move-operation.h"
@@ -31,12 +34,16 @@
 #include "file-utils.h"
 
 #include "thumbnail-manager.h"
+#include "theme-icon-cache.h"
+#include "io-executor.h"
 
 #include "file-operation-utils.h"
 
 #include <QIcon>
+#include <QFont>
 #include <QMimeData>
 #include <QUrl>
+#include <QTimer>
 
 #include <QDebug>
 
@@ -45,14 +52,21 @@ using namespace Peony;
 FileItemModel::FileItemModel(QObject *parent) : QAbstractItemModel (parent)
 {
     setPositiveResponse(true);
+    m_io_group = new IoCancellationGroup(this);
+
+    m_idle_thumbnail_timer = new QTimer(this);
+    m_idle_thumbnail_timer->setInterval(PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_INTERVAL);
+    connect(m_idle_thumbnail_timer, &QTimer::timeout, this, &FileItemModel::startIdleThumbnails);
 }
 
 FileItemModel::~FileItemModel()
 {
     qDebug()<<"~FileItemModel";
     disconnect();
-    if (m_root_item)
+    if (m_root_item) {
+        m_root_item->saveChildrenSnapshot();
         delete m_root_item;
+    }
 }
 
 const QString FileItemModel::getRootUri()
@@ -76,27 +90,63 @@ void FileItemModel::setRootUri(const QString &uri)
 void FileItemModel::setRootItem(FileItem *item)
 {
     beginResetModel();
-    m_root_item->deleteLater();
+    if (m_root_item) {
+        m_root_item->saveChildrenSnapshot();
+        //drop the queued i/o of previous root at once.
+        m_io_group->cancel();
+        clearPendingThumbnails();
+        m_visible_uris.clear();
+        m_root_item->deleteLater();
+    }
 
     m_root_item = item;
-    m_root_item->findChildrenAsync();
+    bool wasStale = m_is_stale;
+    m_is_stale = false;
+
+    //a recently visited directory is shown from its snapshot instantly.
+    //a slow remote directory is shown from the listing cached on disk, and
+    //marked as stale until it is revalidated.
+    auto snapshot = DirectorySnapshotCache::getInstance()->take(m_root_item->uri());
+    QList<std::shared_ptr<FileInfo>> cachedInfos;
+    if (!snapshot && PersistentListingCache::getInstance()->isEnabledForUri(m_root_item->uri())) {
+        cachedInfos = PersistentListingCache::getInstance()->load(m_root_item->uri());
+    }
+
+    if (snapshot) {
+        m_root_item->restoreChildren(snapshot->children());
+    } else if (!cachedInfos.isEmpty()) {
+        m_root_item->restoreChildren(cachedInfos);
+        m_is_stale = true;
+    } else {
+        m_root_item->findChildrenAsync();
+    }
 
     endResetModel();
+
+    if (wasStale != m_is_stale)
+        Q_EMIT listingStaleChanged(m_is_stale);
+
+    if (snapshot) {
+        m_root_item->reconcileRestoredChildren(snapshot);
+    } else if (m_is_stale) {
+        Q_EMIT updated();
+        m_root_item->revalidateStaleChildren();
+    }
 }
 
 QModelIndex FileItemModel::index(int row, int column, const QModelIndex &parent) const
 {
     //root children
     if (!parent.isValid()) {
-        if (row < 0 || row > m_root_item->m_children->count()-1)
+        if (row < 0 || row > m_root_item->m_children.count()-1)
             return QModelIndex();
-        return createIndex(row, column, m_root_item->m_children->at(row));
+        return createIndex(row, column, m_root_item->m_children.at(row));
     }
 
     FileItem *item = static_cast<FileItem*>(parent.internalPointer());
-    if (row < 0 || row > item->m_children->count()-1)
+    if (row < 0 || row > item->m_children.count()-1)
         return QModelIndex();
-    return createIndex(row, column, item->m_children->at(row));
+    return createIndex(row, column, item->m_children.at(row));
 }
 
 FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
@@ -106,56 +156,69 @@ FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
 
 QModelIndex FileItemModel::firstColumnIndex(FileItem *item)
 {
-    //root children
-    if (item->m_parent == nullptr) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, 0, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, 0, item);
-        }
+    //the item without parent is looked up in root children.
+    FileItem *parentItem = item->m_parent? item->m_parent: m_root_item;
+    int row = parentItem->rowOfChild(item);
+    if (row < 0)
         return QModelIndex();
-    }
+    return createIndex(row, 0, item);
 }
 
 QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
 {
-    if (!item->m_parent) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, Other, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, Other, item);
-        }
+    FileItem *parentItem = item->m_parent? item->m_parent: m_root_item;
+    int row = parentItem->rowOfChild(item);
+    if (row < 0)
         return QModelIndex();
-    }
+    return createIndex(row, Other, item);
 }
 
 const QModelIndex FileItemModel::indexFromUri(const QString &uri)
 {
     //FIXME: support recursively finding?
-    for (auto child : *m_root_item->m_children) {
-        if (child->uri() == uri) {
-            return child->firstColumnIndex();
+    auto child = m_root_item->m_directory? m_root_item->m_directory->children_hash.value(uri): nullptr;
+    if (child)
+        return child->firstColumnIndex();
+    return QModelIndex();
+}
+
+void FileItemModel::permuteChildren(const QModelIndex &parent, const std::vector<int> &rows)
+{
+    FileItem *parentItem = parent.isValid()? itemFromIndex(parent): m_root_item;
+    if (!parentItem || int(rows.size()) != parentItem->m_children.count())
+        return;
+
+    QList<QPersistentModelIndex> parents;
+    if (parent.isValid())
+        parents<<parent;
+    Q_EMIT layoutAboutToBeChanged(parents, QAbstractItemModel::VerticalSortHint);
+
+    std::vector<int> newRows(rows.size());
+    QVector<FileItem*> children(parentItem->m_children.count());
+    for (int row = 0; row < int(rows.size()); row++) {
+        auto child = parentItem->m_children.at(rows[row]);
+        child->m_row = row;
+        children[row] = child;
+        newRows[rows[row]] = row;
+    }
+    parentItem->m_children.swap(children);
+    //the rows are numbered above.
+    parentItem->directoryState()->first_dirty_row = parentItem->m_children.count();
+
+    QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.count());
+    for (auto index : from) {
+        auto item = itemFromIndex(index);
+        if ((item->m_parent? item->m_parent: m_root_item) == parentItem) {
+            to<<createIndex(newRows[index.row()], index.column(), index.internalPointer());
+        } else {
+            to<<index;
         }
     }
-    return QModelIndex();
+    changePersistentIndexList(from, to);
+
+    Q_EMIT layoutChanged(parents, QAbstractItemModel::VerticalSortHint);
 }
 
 QModelIndex FileItemModel::parent(const QModelIndex &child) const
@@ -179,10 +242,10 @@ int FileItemModel::rowCount(const QModelIndex &parent) const
         if (!m_root_item) {
             return 0;
         }
-        return m_root_item->m_children->count();
+        return m_root_item->m_children.count();
     }
     FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
-    return parent_item->m_children->count();
+    return parent_item->m_children.count();
 }
 
 QVariant FileItemModel::data(const QModelIndex &index, int role) const
@@ -198,6 +261,13 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     if (role == FileItemModel::UriRole)
         return QVariant(item->uri());
 
+    //mark the listing restored from disk cache until it is revalidated.
+    if (role == Qt::FontRole && m_is_stale) {
+        QFont font;
+        font.setItalic(true);
+        return font;
+    }
+
     //qDebug()<<item->m_info->uri();
     switch (index.column()) {
     case FileName: {
@@ -215,14 +285,17 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
                 return thumbnail;
             }
             */
+            if (item->m_info->isContentTypeUncertain())
+                const_cast<FileItemModel *>(this)->sniffContentTypeLater(item->m_info->uri());
+
             auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(item->m_info->uri());
             if (!thumbnail.isNull()) {
                 if (item->m_info->uri().endsWith(".desktop") && !item->m_info->canExecute()) {
-                    return QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+                    return ThemeIconCache::getInstance()->icon(item->m_info->iconName());
                 }
                 return thumbnail;
             }
-            QIcon icon = QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+            QIcon icon = ThemeIconCache::getInstance()->icon(item->m_info->iconName());
             return QVariant(icon);
         }
         case Qt::ToolTipRole: {
@@ -237,7 +310,7 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
         case Qt::DisplayRole: {
             if (item->hasChildren()) {
                 if (item->m_expanded) {
-                    return QVariant(QString::number(item->m_children->count()) + tr("child(ren)"));
+                    return QVariant(QString::number(item->m_children.count()) + tr("child(ren)"));
                 }
                 return QVariant();
             }
@@ -377,7 +450,7 @@ void FileItemModel::onFoundChildren(const QModelIndex &parent)
         return;
     }
     FileItem *parentItem = static_cast<FileItem*>(parent.internalPointer());
-    beginInsertRows(parent, 0, parentItem->m_children->count() - 1);
+    beginInsertRows(parent, 0, parentItem->m_children.count() - 1);
     endInsertRows();
 }
 
@@ -395,6 +468,25 @@ void FileItemModel::onItemRemoved(FileItem *item)
     removeRow(item->firstColumnIndex().row(), item->m_parent->firstColumnIndex());
 }
 
+void FileItemModel::requestUpdate()
+{
+    if (m_update_scheduled)
+        return;
+
+    //the first request in a frame is handled at once, the following ones
+    //are merged into the next frame.
+    int delay = 0;
+    if (m_last_update_timer.isValid())
+        delay = qMax(qint64(0), PEONY_FILE_ITEM_FRAME_INTERVAL - m_last_update_timer.elapsed());
+
+    m_update_scheduled = true;
+    QTimer::singleShot(int(delay), this, [=]() {
+        m_update_scheduled = false;
+        m_last_update_timer.start();
+        Q_EMIT updated();
+    });
+}
+
 void FileItemModel::cancelFindChildren()
 {
     qDebug()<<"cancel";
@@ -527,3 +619,115 @@ bool FileItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action, i
     //use QAbstractModel::dropMimeData() here;
     return true;
 }
+
+void FileItemModel::sniffContentTypeLater(const QString &uri)
+{
+    if (m_sniffing_uris.contains(uri))
+        return;
+
+    m_sniffing_uris<<uri;
+    m_pending_sniff_uris<<uri;
+    //collect the items painted in this frame.
+    if (m_pending_sniff_uris.count() == 1)
+        QTimer::singleShot(0, this, &FileItemModel::sniffPendingContentTypes);
+}
+
+void FileItemModel::sniffPendingContentTypes()
+{
+    QStringList uris;
+    uris.swap(m_pending_sniff_uris);
+    if (uris.isEmpty())
+        return;
+
+    auto job = new FileInfoBatchJob(uris, this);
+    job->setSniffContentType();
+    job->setAutoDelete();
+    connect(job, &FileInfoBatchJob::infosUpdated, this, [=](const QVector<std::shared_ptr<FileInfo>> &infos) {
+        if (!m_root_item)
+            return;
+        QStringList updatedUris;
+        for (auto info : infos) {
+            updatedUris<<info->uri();
+        }
+        m_root_item->notifyChildrenDataChanged(updatedUris);
+    });
+    connect(job, &FileInfoBatchJob::queryAsyncFinished, this, [=]() {
+        for (auto uri : uris) {
+            m_sniffing_uris.remove(uri);
+        }
+    });
+    job->queryAsync();
+}
+
+void FileItemModel::setVisibleUris(const QStringList &uris)
+{
+    m_visible_uris = uris;
+    if (!m_root_item)
+        return;
+
+    for (auto uri : uris) {
+        auto child = m_root_item->getChildFromUri(uri);
+        if (child && child->m_info->isContentTypeUncertain())
+            sniffContentTypeLater(child->uri());
+    }
+    startVisibleThumbnails();
+}
+
+void FileItemModel::requestThumbnails(const QStringList &uris)
+{
+    for (auto uri : uris) {
+        if (m_pending_thumbnail_set.contains(uri))
+            continue;
+        m_pending_thumbnail_set<<uri;
+        m_pending_thumbnail_uris<<uri;
+    }
+    startVisibleThumbnails();
+}
+
+void FileItemModel::startVisibleThumbnails()
+{
+    auto watcher = m_root_item? m_root_item->childrenWatcher(): nullptr;
+    if (!watcher || m_pending_thumbnail_set.isEmpty())
+        return;
+
+    for (auto uri : m_visible_uris) {
+        if (m_pending_thumbnail_set.remove(uri))
+            ThumbnailManager::getInstance()->createThumbnail(uri, watcher, false, m_io_group->token());
+    }
+
+    if (m_pending_thumbnail_set.isEmpty()) {
+        clearPendingThumbnails();
+    } else if (!m_idle_thumbnail_timer->isActive()) {
+        m_idle_thumbnail_timer->start();
+    }
+}
+
+void FileItemModel::startIdleThumbnails()
+{
+    auto watcher = m_root_item? m_root_item->childrenWatcher(): nullptr;
+    if (!watcher)
+        return;
+
+    int count = 0;
+    while (count < PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_COUNT && !m_pending_thumbnail_uris.isEmpty()) {
+        QString uri = m_pending_thumbnail_uris.takeFirst();
+        //created by visible window already.
+        if (!m_pending_thumbnail_set.remove(uri))
+            continue;
+        //removed while pending.
+        if (!m_root_item->getChildFromUri(uri))
+            continue;
+        ThumbnailManager::getInstance()->createThumbnail(uri, watcher, false, m_io_group->token(), IoExecutor::Prefetch);
+        count++;
+    }
+
+    if (m_pending_thumbnail_set.isEmpty())
+        clearPendingThumbnails();
+}
+
+void FileItemModel::clearPendingThumbnails()
+{
+    m_idle_thumbnail_timer->stop();
+    m_pending_thumbnail_uris.clear();
+    m_pending_thumbnail_set.clear();
+}
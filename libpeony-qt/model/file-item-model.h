@@ -24,11 +24,35 @@
 #define FILEITEMMODEL_H
 
 #include <QAbstractItemModel>
+#include <QSet>
+#include <QElapsedTimer>
 #include "peony-core_global.h"
 
+#include <vector>
+
+/*!
+ * \brief PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_INTERVAL
+ * The interval in milliseconds of queuing the thumbnails of the items
+ * out of the visible window.
+ */
+#ifndef PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_INTERVAL
+#define PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_INTERVAL 200
+#endif
+
+/*!
+ * \brief PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_COUNT
+ * The max number of the thumbnails out of the visible window queued in each interval.
+ */
+#ifndef PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_COUNT
+#define PEONY_FILE_ITEM_MODEL_IDLE_THUMBNAIL_COUNT 32
+#endif
+
+class QTimer;
+
 namespace Peony {
 
 class FileItem;
+class IoCancellationGroup;
 class FileItemProxyFilterSortModel;
 
 /*!
@@ -105,6 +129,16 @@ public:
         return  m_can_expand;
     }
 
+    /*!
+     * \brief isListingStale
+     * \return true if the children are restored from PersistentListingCache
+     * and they have not been revalidated yet.
+     * \see listingStaleChanged().
+     */
+    bool isListingStale() {
+        return m_is_stale;
+    }
+
     const QString getRootUri();
     void setRootUri(const QString &uri);
     /*!
@@ -233,9 +267,21 @@ Q_SIGNALS:
      * when a 'folder' item children changed, this signal should be emit.
      * </br>
      * \note proxy model should connect this signal and start sort and filter again.
+     * The items should use requestUpdate() instead of sending it directly.
      */
     void updated();
 
+    /*!
+     * \brief listingStaleChanged
+     * \param stale
+     * <br>
+     * A view can connect this signal for telling user the shown listing
+     * is the last known one, and it is being revalidated.
+     * </br>
+     * \see isListingStale().
+     */
+    void listingStaleChanged(bool stale);
+
 public Q_SLOTS:
     /*!
      * \brief onFoundChildren
@@ -258,12 +304,116 @@ public Q_SLOTS:
 
     void cancelFindChildren();
 
+    /*!
+     * \brief requestUpdate
+     * <br>
+     * Request an updated() signal. The requests are coalesced, updated() is sent
+     * at most once in PEONY_FILE_ITEM_FRAME_INTERVAL, so an event storm of the
+     * file system only causes one sort and filter pass per frame.
+     * </br>
+     */
+    void requestUpdate();
+
+    /*!
+     * \brief ioCancellationGroup
+     * \return the group of the background i/o started for current root,
+     * such as enumerating and thumbnailing. It is cancelled when the root is changed.
+     * \see IoExecutor.
+     */
+    IoCancellationGroup *ioCancellationGroup() {
+        return m_io_group;
+    }
+
     void setRootIndex(const QModelIndex &index);
 
+    /*!
+     * \brief setVisibleUris
+     * \param uris, the children of root shown in a view's viewport, with a
+     * prefetch margin around it.
+     * <br>
+     * The thumbnails of the root's children are not created when they are listed.
+     * They are pending in the model, the ones in the visible window are created
+     * first in IoExecutor::VisibleThumbnail class, and the others are queued a few
+     * at a time in IoExecutor::Prefetch class. The uncertain content types in the
+     * window are sniffed as well. So the work done on entering a directory scales
+     * with the viewport, not the directory size.
+     * </br>
+     * \see requestThumbnails().
+     */
+    void setVisibleUris(const QStringList &uris);
+
+protected:
+    /*!
+     * \brief requestThumbnails
+     * \param uris, the children of root which need thumbnails.
+     * \see setVisibleUris().
+     */
+    void requestThumbnails(const QStringList &uris);
+    /*!
+     * \brief startVisibleThumbnails
+     * Create the pending thumbnails in the visible window. The thumbnails are
+     * created only after the root's watcher started, so that the views are
+     * notified when they are done.
+     */
+    void startVisibleThumbnails();
+    void startIdleThumbnails();
+    void clearPendingThumbnails();
+
+    /*!
+     * \brief sniffContentTypeLater
+     * \param uri
+     * <br>
+     * The listings only guess the content types by names. When an item
+     * with an uncertain type is going to be painted, we sniff its contents
+     * in a batch job with the other visible ones, and upgrade the icon after
+     * the job finished.
+     * </br>
+     * \see FileInfo::isContentTypeUncertain().
+     */
+    void sniffContentTypeLater(const QString &uri);
+    void sniffPendingContentTypes();
+
+    /*!
+     * \brief permuteChildren
+     * \param parent, the index of the item whose children are reordered.
+     * \param rows, the old row of every new row.
+     * <br>
+     * Move the children into the given order with one layout change, and
+     * remap the persistent indexes. It is used by FileItemProxyFilterSortModel
+     * to apply a sort of a very large directory without comparing the rows
+     * again in gui thread.
+     * </br>
+     */
+    void permuteChildren(const QModelIndex &parent, const std::vector<int> &rows);
+
 private:
     FileItem *m_root_item = nullptr;
     bool m_is_positive = false;
     bool m_can_expand = false;
+    bool m_is_stale = false;
+
+    IoCancellationGroup *m_io_group = nullptr;
+
+    bool m_update_scheduled = false;
+    QElapsedTimer m_last_update_timer;
+
+    QStringList m_pending_sniff_uris;
+    /*!
+     * \brief m_sniffing_uris
+     * The pending and running uris, so that repaints don't start duplicated queries.
+     */
+    QSet<QString> m_sniffing_uris;
+
+    QStringList m_visible_uris;
+    /*!
+     * \brief m_pending_thumbnail_uris
+     * The children wait for thumbnails in listing order. The ones created by
+     * the visible window are removed from m_pending_thumbnail_set only, and
+     * skipped when they are taken from the list.
+     */
+    QStringList m_pending_thumbnail_uris;
+    QSet<QString> m_pending_thumbnail_set;
+    QTimer *m_idle_thumbnail_timer = nullptr;
 };
 
 }
@@ -24,26 +24,164 @@
 #include "file-item-model.h"
 #include "file-item.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "file-item-sort-key.h"
 #include "file-info.h"
 #include "file-meta-info.h"
 #include "file-label-model.h"
 
 #include "file-utils.h"
-#include "file-operation-utils.h"
 
 #include "global-settings.h"
 
 #include <QDebug>
 #include <QMessageBox>
 #include <QDate>
+#include <QTimer>
+#include <QThread>
+#include <QtConcurrent>
 
-#include <QLocale>
-#include <QCollator>
+#include <algorithm>
+#include <numeric>
+#include <limits>
 
 using namespace Peony;
 
-QLocale locale = QLocale(QLocale::system().name());
-QCollator comparer = QCollator(locale);
+/*!
+ * \brief The FileItemSortSnapshot struct
+ * The sort keys and the settings a parallel sort works on. The type ordinals
+ * are copied, as the shared ones might be renumbered in gui thread.
+ * <br>
+ * The keys of the items which have no key yet are created with the raw values
+ * only, and prepared by the worker threads, see unprepared_rows.
+ * </br>
+ * <br>
+ * For a very large directory the rows are compared on the columns instead of
+ * the keys, then the type ordinals are indexed by the type ids of the columns.
+ * </br>
+ */
+struct Peony::FileItemSortSnapshot
+{
+    std::vector<std::shared_ptr<FileItemSortKey>> keys;
+    std::vector<int> unprepared_rows;
+    QLocale collator_locale;
+    std::shared_ptr<const FileItemColumns> columns;
+    std::vector<int> type_ordinals;
+    int column = 0;
+    Qt::SortOrder order = Qt::AscendingOrder;
+    bool folder_first = true;
+    bool chinese_first = false;
+
+    /*!
+     * \brief touched
+     * The rows changed while sorting, only used in gui thread. Their prepared
+     * keys are not given to the items, as they might be out of date.
+     */
+    std::vector<char> touched;
+};
+
+/*!
+ * \brief The SortRange struct
+ * The rows [first, last) of a chunk, the chunks [first, middle) and [middle, last)
+ * are merged into one.
+ */
+struct SortRange
+{
+    int first;
+    int middle;
+    int last;
+};
+
+/*!
+ * \brief parallelSort
+ * \return the rows of the snapshot in display order, or an empty vector if cancelled.
+ * <br>
+ * The rows are split into one chunk per thread and sorted with std::stable_sort,
+ * then the neighbouring chunks are merged in parallel until only one is left. The
+ * result is the same as the stable sort of QSortFilterProxyModel.
+ * </br>
+ */
+static std::vector<int> parallelSort(std::shared_ptr<FileItemSortSnapshot> snapshot, std::shared_ptr<QAtomicInt> cancelled)
+{
+    int count = snapshot->columns? snapshot->columns->count(): int(snapshot->keys.size());
+    std::vector<int> rows(count);
+    std::iota(rows.begin(), rows.end(), 0);
+    if (count == 0)
+        return rows;
+
+    int chunkCount = qMax(1, QThread::idealThreadCount());
+
+    //prepare the new keys first, every chunk uses its own collator.
+    int unpreparedCount = int(snapshot->unprepared_rows.size());
+    if (unpreparedCount > 0) {
+        int prepareSize = (unpreparedCount + chunkCount - 1) / chunkCount;
+        QVector<SortRange> prepares;
+        for (int first = 0; first < unpreparedCount; first += prepareSize) {
+            prepares<<SortRange{first, first, qMin(first + prepareSize, unpreparedCount)};
+        }
+        QtConcurrent::blockingMap(prepares, [&](const SortRange &range) {
+            QCollator collator(snapshot->collator_locale);
+            for (int i = range.first; i < range.last; i++) {
+                if (cancelled->load())
+                    return;
+                snapshot->keys[snapshot->unprepared_rows[i]]->prepare(collator);
+            }
+        });
+        if (cancelled->load())
+            return std::vector<int>();
+    }
+
+    auto lessThan = [snapshot](int left, int right) {
+        //the same as QSortFilterProxyModel, a descending sort compares the rows reversed.
+        if (snapshot->order == Qt::DescendingOrder)
+            std::swap(left, right);
+        if (snapshot->columns) {
+            return snapshot->columns->lessThan(left, right, snapshot->type_ordinals,
+                                               snapshot->column, snapshot->order,
+                                               snapshot->folder_first, snapshot->chinese_first);
+        }
+        return FileItemSortKey::lessThan(*snapshot->keys[left], snapshot->type_ordinals[left],
+                                         *snapshot->keys[right], snapshot->type_ordinals[right],
+                                         snapshot->column, snapshot->order,
+                                         snapshot->folder_first, snapshot->chinese_first);
+    };
+
+    int chunkSize = (count + chunkCount - 1) / chunkCount;
+    QVector<SortRange> ranges;
+    for (int first = 0; first < count; first += chunkSize) {
+        ranges<<SortRange{first, first, qMin(first + chunkSize, count)};
+    }
+
+    QtConcurrent::blockingMap(ranges, [&](const SortRange &range) {
+        if (cancelled->load())
+            return;
+        std::stable_sort(rows.begin() + range.first, rows.begin() + range.last, lessThan);
+    });
+
+    while (ranges.count() > 1) {
+        if (cancelled->load())
+            return std::vector<int>();
+
+        QVector<SortRange> merges;
+        for (int i = 0; i + 1 < ranges.count(); i += 2) {
+            merges<<SortRange{ranges.at(i).first, ranges.at(i).last, ranges.at(i + 1).last};
+        }
+        QtConcurrent::blockingMap(merges, [&](const SortRange &range) {
+            if (cancelled->load())
+                return;
+            std::inplace_merge(rows.begin() + range.first,
+                               rows.begin() + range.middle,
+                               rows.begin() + range.last,
+                               lessThan);
+        });
+        if (ranges.count() % 2)
+            merges<<ranges.last();
+        ranges = merges;
+    }
+
+    if (cancelled->load())
+        return std::vector<int>();
+    return rows;
+}
 
 FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QSortFilterProxyModel(parent)
 {
@@ -51,406 +189,799 @@ FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QS
     m_show_hidden = settings->isExist("show-hidden")? settings->getValue("show-hidden").toBool(): false;
     m_use_default_name_sort_order = settings->isExist("chinese-first")? settings->getValue("chinese-first").toBool(): false;
     m_folder_first = settings->isExist("folder-first")? settings->getValue("folder-first").toBool(): true;
+
+    //QSortFilterProxyModel filters and places the inserted or changed source rows
+    //by itself when dynamic sort filter is enabled, so there is no need to sort or
+    //filter the whole model once the source model updated.
+    setDynamicSortFilter(true);
+
+    compileFilter();
+    //the label conditions are compiled into label ids.
+    auto labelModel = FileLabelModel::getGlobalModel();
+    auto onLabelsChanged = [=]() {
+        compileFilter();
+        if (m_filter_predicate.needLabels())
+            invalidateFilter();
+    };
+    connect(labelModel, &FileLabelModel::dataChanged, this, onLabelsChanged);
+    connect(labelModel, &FileLabelModel::modelReset, this, onLabelsChanged);
+}
+
+FileItemProxyFilterSortModel::~FileItemProxyFilterSortModel()
+{
+    cancelSort();
 }
 
 void FileItemProxyFilterSortModel::setSourceModel(QAbstractItemModel *model)
 {
+    cancelSort();
+    bool wasSourceOrdered = m_source_ordered;
     if (sourceModel())
-        disconnect(sourceModel());
+        disconnect(sourceModel(), nullptr, this, nullptr);
+    dropColumns();
+    if (model) {
+        connect(model, &QAbstractItemModel::dataChanged, this, &FileItemProxyFilterSortModel::dropItemKeys);
+        connect(model, &QAbstractItemModel::rowsInserted, this, &FileItemProxyFilterSortModel::insertColumnRows);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, &FileItemProxyFilterSortModel::removeColumnRows);
+        connect(model, &QAbstractItemModel::rowsMoved, this, &FileItemProxyFilterSortModel::dropColumns);
+        connect(model, &QAbstractItemModel::layoutChanged, this, &FileItemProxyFilterSortModel::onSourceLayoutChanged);
+        connect(model, &QAbstractItemModel::modelReset, this, &FileItemProxyFilterSortModel::dropColumns);
+        //the running sort works on a snapshot of the rows, restart it once the rows changed.
+        //a changed row only restarts it if its position might change, see dropItemKeys(),
+        //and the appended rows are placed after it finished, see onSourceRowsInserted().
+        connect(model, &QAbstractItemModel::rowsInserted, this, &FileItemProxyFilterSortModel::onSourceRowsInserted);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, &FileItemProxyFilterSortModel::onSourceChanged);
+        connect(model, &QAbstractItemModel::rowsMoved, this, &FileItemProxyFilterSortModel::onSourceChanged);
+        connect(model, &QAbstractItemModel::modelReset, this, &FileItemProxyFilterSortModel::onSourceChanged);
+    }
+    m_source_ordered = false;
+    m_misplaced_indexes.clear();
     QSortFilterProxyModel::setSourceModel(model);
-    FileItemModel *file_item_model = static_cast<FileItemModel*>(model);
-    connect(file_item_model, &FileItemModel::updated, this, &FileItemProxyFilterSortModel::update);
+    if (model) {
+        //connected after QSortFilterProxyModel, so the rows are sorted after it reset its mapping.
+        connect(model, &QAbstractItemModel::modelReset, this, &FileItemProxyFilterSortModel::leaveSourceOrder);
+    }
+    if (wasSourceOrdered && m_requested_sort_column >= 0)
+        startSort();
 }
 
-FileItem *FileItemProxyFilterSortModel::itemFromIndex(const QModelIndex &proxyIndex)
+void FileItemProxyFilterSortModel::sort(int column, Qt::SortOrder order)
 {
-    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
-    QModelIndex index = mapToSource(proxyIndex);
-    return model->itemFromIndex(index);
+    if (column == m_requested_sort_column && order == m_requested_sort_order)
+        return;
+    m_requested_sort_column = column;
+    m_requested_sort_order = order;
+    startSort();
 }
 
-QModelIndex FileItemProxyFilterSortModel::getSourceIndex(const QModelIndex &proxyIndex)
+void FileItemProxyFilterSortModel::resortAll()
 {
-    return mapToSource(proxyIndex);
+    if (m_requested_sort_column < 0)
+        m_requested_sort_column = 0;
+    startSort();
 }
 
-const QModelIndex FileItemProxyFilterSortModel::indexFromUri(const QString &uri)
+void FileItemProxyFilterSortModel::startSort()
 {
-    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
-    const QModelIndex sourceIndex = model->indexFromUri(uri);
-    return mapFromSource(sourceIndex);
-}
+    cancelSort();
 
-bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
-{
-    //comment these improve code to fix disorder issue
-    //and chinese first or folder first has not effect issue
-    //Fix me with better solutions
-//    if (left.data().isNull())
-//        return sortOrder() == Qt::AscendingOrder? false: true;
-
-//    if (right.data().isNull())
-//        return sortOrder() == Qt::AscendingOrder? true: false;
-
-//    if (left.column() != 0 || right.column() != 0) {
-//        return true;
-//    }
-
-    //qDebug()<<left<<right;
-    if (left.isValid() && right.isValid()) {
-        FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
-        auto leftItem = model->itemFromIndex(left);
-        auto rightItem = model->itemFromIndex(right);
-        if (!(leftItem->hasChildren() && rightItem->hasChildren())) {
-            //make folder always has a higher order.
-            if (!leftItem->hasChildren() && !rightItem->hasChildren()) {
-                goto default_sort;
-            }
-            if (m_folder_first) {
-                bool lesser = leftItem->hasChildren();
-                if (sortOrder() == Qt::AscendingOrder)
-                    return lesser;
-                return !lesser;
-            }
-        }
+    auto model = sourceModel();
+    int rowCount = model? model->rowCount(): 0;
+    if (rowCount < PEONY_PARALLEL_SORT_THRESHOLD || !FileItemSortKey::hasColumnKey(m_requested_sort_column)) {
+        m_source_ordered = false;
+        applySort();
+        return;
+    }
 
-default_sort:
-        switch (sortColumn()) {
-        case FileItemModel::FileName: {
-            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftItem->m_info->displayName(), rightItem->m_info->displayName())) {
-                return FileOperationUtils::leftNameLesserThanRightName(leftItem->info()->displayName(), rightItem->info()->displayName());
-            }
-            if (m_use_default_name_sort_order) {
-                QString leftDisplayName = leftItem->m_info->displayName();
-                QString rightDisplayName = rightItem->m_info->displayName();
-                bool leftStartWithChinese = startWithChinese(leftDisplayName);
-                bool rightStartWithChinese = startWithChinese(rightDisplayName);
-                //all start with Chinese, use the default compare directly
-                if (leftStartWithChinese && rightStartWithChinese)
-                    return comparer.compare(leftDisplayName, rightDisplayName) < 0;
-                //simplify the logic
-                if (leftStartWithChinese || rightStartWithChinese) {
-                    if (sortOrder() == Qt::AscendingOrder) {
-                        return leftStartWithChinese;
-                    }
-                    return rightStartWithChinese;
-                }
-            }
-            return leftItem->m_info->displayName().toLower() < rightItem->m_info->displayName().toLower();
+    auto snapshot = std::make_shared<FileItemSortSnapshot>();
+    auto items = std::make_shared<QVector<FileItem*>>();
+    items->reserve(rowCount);
+    snapshot->touched.resize(rowCount, 0);
+    if (auto table = columns()) {
+        //the worker threads share the columns, they are copied before the next change.
+        snapshot->columns = m_columns;
+        snapshot->type_ordinals = table->typeOrdinals();
+        for (int row = 0; row < rowCount; row++) {
+            *items<<static_cast<FileItem*>(model->index(row, 0).internalPointer());
         }
-        case FileItemModel::FileSize: {
-            return leftItem->m_info->size() < rightItem->m_info->size();
+    } else {
+        //only the raw values are taken here, the name keys and the collator keys
+        //of the new keys are computed by the worker threads.
+        snapshot->keys.reserve(rowCount);
+        snapshot->type_ordinals.reserve(rowCount);
+        snapshot->collator_locale = FileItemSortKey::collatorLocale();
+        for (int row = 0; row < rowCount; row++) {
+            auto item = static_cast<FileItem*>(model->index(row, 0).internalPointer());
+            if (item->m_keys && item->m_keys->sort_key) {
+                snapshot->keys.push_back(item->m_keys->sort_key);
+            } else {
+                snapshot->keys.push_back(rawSortKey(item));
+                snapshot->unprepared_rows.push_back(row);
+            }
+            snapshot->type_ordinals.push_back(snapshot->keys.back()->typeOrdinal());
+            *items<<item;
         }
-        case FileItemModel::FileType: {
-            return leftItem->m_info->fileType() < rightItem->m_info->fileType();
+    }
+    snapshot->column = m_requested_sort_column;
+    snapshot->order = m_requested_sort_order;
+    snapshot->folder_first = m_folder_first;
+    snapshot->chinese_first = m_use_default_name_sort_order;
+
+    auto cancelled = std::make_shared<QAtomicInt>(0);
+    auto watcher = new QFutureWatcher<std::vector<int>>(this);
+    m_sort_cancelled = cancelled;
+    m_sort_watcher = watcher;
+    m_sort_snapshot = snapshot;
+
+    connect(watcher, &QFutureWatcher<std::vector<int>>::finished, this, [=]() {
+        watcher->deleteLater();
+        if (cancelled->load())
+            return;
+        m_sort_watcher = nullptr;
+        m_sort_cancelled = nullptr;
+        m_sort_snapshot = nullptr;
+
+        //no row was inserted, removed or moved since the snapshot, and the changed
+        //rows are still in place, or the sort would be cancelled.
+        for (int row : snapshot->unprepared_rows) {
+            auto item = items->at(row);
+            if (!snapshot->touched[row] && !(item->m_keys && item->m_keys->sort_key))
+                itemKeys(item)->sort_key = snapshot->keys[row];
         }
-        case FileItemModel::ModifiedDate: {
-            return leftItem->m_info->modifiedTime() < rightItem->m_info->modifiedTime();
+
+        //the rows appended while sorting are kept after the sorted ones.
+        auto rows = watcher->result();
+        int sortedCount = int(rows.size());
+        int count = sourceModel()->rowCount();
+        for (int row = sortedCount; row < count; row++) {
+            rows.push_back(row);
         }
-        default:
-            break;
+        applyPermutation(QModelIndex(), rows);
+        sortExpandedChildren(QModelIndex());
+        if (count > sortedCount && !isSourceRangeOrdered(QModelIndex(), sortedCount, count - 1)) {
+            for (int row = sortedCount; row < count; row++) {
+                m_misplaced_indexes<<QPersistentModelIndex(sourceModel()->index(row, 0));
+            }
+            schedulePlaceMisplacedRows();
         }
+    });
+    watcher->setFuture(QtConcurrent::run(parallelSort, snapshot, cancelled));
+}
+
+void FileItemProxyFilterSortModel::cancelSort()
+{
+    if (!m_sort_watcher)
+        return;
+    m_sort_cancelled->store(1);
+    m_sort_cancelled = nullptr;
+    m_sort_watcher = nullptr;
+    m_sort_snapshot = nullptr;
+}
+
+void FileItemProxyFilterSortModel::applySort()
+{
+    if (m_requested_sort_column == sortColumn() && m_requested_sort_order == sortOrder()) {
+        //the comparator changed, every row might move. QSortFilterProxyModel::sort()
+        //does nothing with the same column and order, but enabling the dynamic sort
+        //filter sorts all the rows at once.
+        setDynamicSortFilter(false);
+        setDynamicSortFilter(true);
+    } else {
+        QSortFilterProxyModel::sort(m_requested_sort_column, m_requested_sort_order);
     }
+}
 
-    return QSortFilterProxyModel::lessThan(left, right);
+void FileItemProxyFilterSortModel::onSourceChanged()
+{
+    if (!m_sort_watcher)
+        return;
+
+    cancelSort();
+    scheduleSort();
 }
 
-bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+void FileItemProxyFilterSortModel::scheduleSort()
 {
-    //FIXME:
-    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
-    //root
-    auto childIndex = model->index(sourceRow, 0, sourceParent);
-    if (childIndex.isValid()) {
-        auto item = static_cast<FileItem*>(childIndex.internalPointer());
-        if (!m_show_hidden) {
-            //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-            //QMessageBox::warning(nullptr, "filter", item->m_info->displayName());
-            //qDebug()<<item->m_info->displayName();
-            if (item->m_info->displayName() != nullptr) {
-                if (item->m_info->displayName().at(0) == '.')
-                    //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-                    return false;
-            }
-        }
-        //regExp
+    if (m_sort_restart_scheduled)
+        return;
 
-        //check the file info filter conditions
-        //qDebug()<<"start filter conditions check"<<item->m_info->displayName()<<item->m_info->type();
-        if (! checkFileTypeFilter(item->m_info->type()))
-            return false;
-        if (! checkFileModifyTimeFilter(item->m_info->modifiedTime()))
-            return false;
-        if (! checkFileSizeFilter(item->m_info->size()))
-            return false;
+    m_sort_restart_scheduled = true;
+    //start once the changes of this frame are all done.
+    QTimer::singleShot(0, this, [=]() {
+        m_sort_restart_scheduled = false;
+        startSort();
+    });
+}
 
-        //check the file label filter conditions
-        if (m_label_name != "" || m_label_color != Qt::transparent)
-        {
-            QString uri = item->m_info->uri();
-            if (m_label_name != "")
-            {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                if (! names.contains(m_label_name))
-                    return false;
-            }
+void FileItemProxyFilterSortModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (m_sort_watcher && !parent.isValid()) {
+        //the rows appended to the snapshot are placed after the sort finished.
+        if (first < int(m_sort_snapshot->touched.size()))
+            onSourceChanged();
+        return;
+    }
 
-            if (m_label_color != Qt::transparent)
-            {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                if (! colors.contains(m_label_color))
-                    return false;
-            }
-        }
+    if (!m_source_ordered || isSourceRangeOrdered(parent, first, last))
+        return;
 
-        //check multiple label filter conditions, file has any one of these label is accepted
-        if(m_show_label_names.size() >0 || m_show_label_colors.size() >0)
-        {
-            bool bfind = false;
-            QString uri = item->m_info->uri();
-            if (m_show_label_names.size() >0 )
-            {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                for(auto temp : m_show_label_names)
-                {
-                    if(names.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
-                }
-            }
+    auto model = sourceModel();
+    for (int row = first; row <= last; row++) {
+        m_misplaced_indexes<<QPersistentModelIndex(model->index(row, 0, parent));
+    }
+    schedulePlaceMisplacedRows();
+}
 
-            if (! bfind && m_show_label_colors.size() >0)
-            {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                for(auto temp : m_show_label_colors)
-                {
-                    if (colors.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
-                }
-            }
+void FileItemProxyFilterSortModel::onSourceLayoutChanged()
+{
+    //the permutations applied by the proxy keep the columns and the order.
+    if (m_applying_permutation)
+        return;
 
-            if (! bfind)
-                return false;
-        }
+    dropColumns();
+    onSourceChanged();
+    if (m_source_ordered)
+        scheduleSort();
+}
 
-        //check the blur name, can use as search color labels
-        if (m_blur_name != "")
-        {
-            QString uri = item->m_info->uri();
-            auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-            bool find = false;
-            for(auto temp : names)
-            {
-                if ((m_case_sensitive && temp.indexOf(m_blur_name) >= 0) ||
-                        (! m_case_sensitive && temp.toLower().indexOf(m_blur_name.toLower()) >= 0))
-                {
-                    find = true;
-                    break;
-                }
-            }
-            if (! find)
-                return false;
+void FileItemProxyFilterSortModel::leaveSourceOrder()
+{
+    m_misplaced_indexes.clear();
+    if (!m_source_ordered)
+        return;
+
+    //the rows are sorted again, in worker threads for a large directory.
+    m_source_ordered = false;
+    if (m_requested_sort_column >= 0)
+        startSort();
+}
+
+void FileItemProxyFilterSortModel::applyPermutation(const QModelIndex &sourceParent, const std::vector<int> &rows)
+{
+    if (!sourceParent.isValid() && !m_source_ordered) {
+        //QSortFilterProxyModel only keeps the source order from now on, it does not
+        //compare the rows any more.
+        m_source_ordered = true;
+        QSortFilterProxyModel::sort(-1, Qt::AscendingOrder);
+    }
+
+    bool moved = false;
+    for (int row = 0; row < int(rows.size()); row++) {
+        if (rows[row] != row) {
+            moved = true;
+            break;
         }
     }
+    if (!moved)
+        return;
+
+    m_applying_permutation = true;
+    if (!sourceParent.isValid() && m_columns)
+        writableColumns()->permute(rows);
+    static_cast<FileItemModel*>(sourceModel())->permuteChildren(sourceParent, rows);
+    m_applying_permutation = false;
+}
+
+void FileItemProxyFilterSortModel::sortExpandedChildren(const QModelIndex &sourceParent)
+{
+    auto model = sourceModel();
+    int count = model->rowCount(sourceParent);
+    for (int row = 0; row < count; row++) {
+        auto index = model->index(row, 0, sourceParent);
+        auto item = static_cast<FileItem*>(index.internalPointer());
+        if (item->m_children.isEmpty())
+            continue;
+
+        std::vector<int> rows(item->m_children.count());
+        std::iota(rows.begin(), rows.end(), 0);
+        std::stable_sort(rows.begin(), rows.end(), [=](int left, int right) {
+            return sourceRowBefore(index, left, right);
+        });
+        applyPermutation(index, rows);
+        sortExpandedChildren(index);
+    }
+}
+
+bool FileItemProxyFilterSortModel::sourceRowBefore(const QModelIndex &sourceParent, int left, int right) const
+{
+    //the same as parallelSort(), a descending sort compares the rows reversed.
+    if (m_requested_sort_order == Qt::DescendingOrder)
+        std::swap(left, right);
+
+    auto table = sourceParent.isValid()? nullptr: columns();
+    if (table) {
+        return table->lessThan(left, right, m_requested_sort_column, m_requested_sort_order,
+                               m_folder_first, m_use_default_name_sort_order);
+    }
+
+    auto model = sourceModel();
+    return FileItemSortKey::lessThan(sortKey(model->index(left, 0, sourceParent)),
+                                     sortKey(model->index(right, 0, sourceParent)),
+                                     m_requested_sort_column, m_requested_sort_order,
+                                     m_folder_first, m_use_default_name_sort_order);
+}
+
+bool FileItemProxyFilterSortModel::isSourceRangeOrdered(const QModelIndex &sourceParent, int first, int last) const
+{
+    int count = sourceModel()->rowCount(sourceParent);
+    for (int row = qMax(first, 1); row <= qMin(last + 1, count - 1); row++) {
+        if (sourceRowBefore(sourceParent, row, row - 1))
+            return false;
+    }
     return true;
 }
 
-bool FileItemProxyFilterSortModel::checkFileTypeFilter(QString type) const
+void FileItemProxyFilterSortModel::schedulePlaceMisplacedRows()
 {
-    //qDebug()<<"m_show_file_type: "<<m_show_file_type<<" "<<type;
-    //multiple condition, advance search and default search
-    if (m_show_file_type == ALL_FILE && m_file_type_list.count() == 0
-        || m_file_type_list.contains(ALL_FILE))
-        return true;
+    if (m_place_misplaced_scheduled)
+        return;
 
-    //support multiple file type choose
-    QList<int> totalTypeList;
-    if (m_file_type_list.count() > 0)
-        totalTypeList.append(m_file_type_list);
-    if (! totalTypeList.contains(m_show_file_type) && m_show_file_type != ALL_FILE)
-        totalTypeList.append(m_show_file_type);
+    m_place_misplaced_scheduled = true;
+    //the rows are placed after the other slots of the source signals are done.
+    QTimer::singleShot(0, this, [=]() {
+        m_place_misplaced_scheduled = false;
+        placeMisplacedRows();
+    });
+}
 
-    for(int i=0; i<totalTypeList.count(); i++)
-    {
-        auto cur = totalTypeList[i];
-        switch (cur)
-        {
-        case FILE_FOLDER:
-        {
-            if (type == Folder_Type)
-                return true;
-            break;
-        }
-        case PICTURE:
-        {
-            if (type.contains(Image_Type))
-                return true;
-            break;
-        }
-        case VIDEO:
-        {
-            if (type.contains(Video_Type))
-                return true;
-            break;
+void FileItemProxyFilterSortModel::placeMisplacedRows()
+{
+    QList<QPersistentModelIndex> indexes;
+    indexes.swap(m_misplaced_indexes);
+    //a running sort places the changed rows by itself.
+    if (!m_source_ordered || m_sort_watcher)
+        return;
+
+    QHash<QModelIndex, QVector<int>> rowsOfParents;
+    for (auto index : indexes) {
+        if (index.isValid())
+            rowsOfParents[index.parent()]<<index.row();
+    }
+
+    auto model = sourceModel();
+    for (auto it = rowsOfParents.begin(); it != rowsOfParents.end(); it++) {
+        auto parent = it.key();
+        QVector<int> rows = it.value();
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+        int count = model->rowCount(parent);
+        if (!parent.isValid() && rows.count() > count / PEONY_MISPLACED_ROW_RATIO) {
+            scheduleSort();
+            continue;
         }
-        case TXT_FILE:
-        {
-            if (type.contains(Text_Type))
-                return true;
-            break;
+
+        //the other rows are still in order, every misplaced row is inserted
+        //among them by binary search.
+        std::vector<char> misplaced(count, 0);
+        for (int row : rows) {
+            misplaced[row] = 1;
         }
-        case WPS_FILE:
-        {
-            if (type.contains(Wps_Type))
-                return true;
-            break;
+        std::vector<int> placed;
+        placed.reserve(count - rows.count());
+        for (int row = 0; row < count; row++) {
+            if (!misplaced[row])
+                placed.push_back(row);
         }
-        case AUDIO:
-        {
-            if (type.contains(Audio_Type))
-                return true;
-            break;
+
+        auto before = [=](int left, int right) {
+            return sourceRowBefore(parent, left, right);
+        };
+        std::stable_sort(rows.begin(), rows.end(), before);
+
+        std::vector<int> order;
+        order.reserve(count);
+        auto first = placed.begin();
+        for (int row : rows) {
+            auto position = std::upper_bound(first, placed.end(), row, before);
+            order.insert(order.end(), first, position);
+            order.push_back(row);
+            first = position;
         }
-        case OTHERS:
-        {
-            //exclude classfied types, show the rest other types
-            if (type != Folder_Type && ! type.contains(Image_Type) && ! type.contains(Video_Type)
-                    && ! type.contains(Text_Type) && !type.contains(Wps_Type) && ! type.contains(Audio_Type))
-                return true;
-            break;
+        order.insert(order.end(), first, placed.end());
+        applyPermutation(parent, order);
+    }
+}
+
+FileItem *FileItemProxyFilterSortModel::itemFromIndex(const QModelIndex &proxyIndex)
+{
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    QModelIndex index = mapToSource(proxyIndex);
+    return model->itemFromIndex(index);
+}
+
+QModelIndex FileItemProxyFilterSortModel::getSourceIndex(const QModelIndex &proxyIndex)
+{
+    return mapToSource(proxyIndex);
+}
+
+const QModelIndex FileItemProxyFilterSortModel::indexFromUri(const QString &uri)
+{
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    const QModelIndex sourceIndex = model->indexFromUri(uri);
+    return mapFromSource(sourceIndex);
+}
+
+std::shared_ptr<FileItemSortKey> FileItemProxyFilterSortModel::rawSortKey(FileItem *item) const
+{
+    auto info = item->m_info;
+    return std::make_shared<FileItemSortKey>(info->displayName(),
+                                             FileItemSortKey::sharedTypeOrdinal(info->fileType()),
+                                             info->size(),
+                                             info->modifiedTime(),
+                                             item->hasChildren());
+}
+
+FileItemKeys *FileItemProxyFilterSortModel::itemKeys(FileItem *item) const
+{
+    if (!item->m_keys)
+        item->m_keys.reset(new FileItemKeys);
+    return item->m_keys.get();
+}
+
+const FileItemSortKey &FileItemProxyFilterSortModel::sortKey(const QModelIndex &sourceIndex) const
+{
+    auto item = static_cast<FileItem*>(sourceIndex.internalPointer());
+    auto keys = itemKeys(item);
+    if (!keys->sort_key) {
+        auto info = item->m_info;
+        keys->sort_key = std::make_shared<FileItemSortKey>(info->displayName(),
+                                                           info->fileType(),
+                                                           info->size(),
+                                                           info->modifiedTime(),
+                                                           item->hasChildren());
+    }
+    return *keys->sort_key;
+}
+
+void FileItemProxyFilterSortModel::dropItemKeys(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    //the thumbnails only change the decoration, the keys are still valid.
+    bool changesKeys = roles.isEmpty();
+    for (int role : roles) {
+        if (role != Qt::DecorationRole)
+            changesKeys = true;
+    }
+    if (!changesKeys)
+        return;
+
+    auto model = sourceModel();
+    auto parent = topLeft.parent();
+    bool topLevel = !parent.isValid();
+    bool updateColumns = m_columns && topLevel;
+    bool sortChanged = false;
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        auto index = model->index(row, 0, parent);
+        if (!index.isValid())
+            continue;
+        auto item = static_cast<FileItem*>(index.internalPointer());
+        if (m_sort_snapshot && topLevel) {
+            if (!sortChanged && !keepsSortPosition(row, item))
+                sortChanged = true;
+            if (row < int(m_sort_snapshot->touched.size()))
+                m_sort_snapshot->touched[row] = 1;
         }
-        default:
-            break;
+        item->m_keys.reset();
+        if (updateColumns) {
+            //do not copy the columns shared with the running sort for nothing.
+            auto values = columnRow(item);
+            if (!m_columns->hasValues(row, values))
+                writableColumns()->update(row, values);
         }
     }
 
-    return false;
+    if (sortChanged)
+        onSourceChanged();
+
+    //QSortFilterProxyModel does not move the rows kept in source order.
+    if (m_source_ordered && !m_sort_watcher && !isSourceRangeOrdered(parent, topLeft.row(), bottomRight.row())) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+            m_misplaced_indexes<<QPersistentModelIndex(model->index(row, 0, parent));
+        }
+        schedulePlaceMisplacedRows();
+    }
 }
 
-bool FileItemProxyFilterSortModel::checkFileModifyTimeFilter(quint64 modifiedTime) const
+bool FileItemProxyFilterSortModel::keepsSortPosition(int row, FileItem *item) const
 {
-    //qDebug()<<"checkFileModifyTimeFilter";
-    //have no date filter
-    if (m_modify_time_list.count() == 0 || m_modify_time_list.contains(ALL_FILE))
+    auto snapshot = m_sort_snapshot;
+    //appended while sorting, it is placed after the sort finished.
+    if (row >= int(snapshot->touched.size()))
         return true;
+    if (snapshot->columns)
+        return snapshot->columns->sameSortValues(row, columnRow(item), snapshot->column, snapshot->folder_first);
+    return snapshot->keys[row]->sameSortValues(*rawSortKey(item), snapshot->column, snapshot->folder_first);
+}
 
-    auto time = QDateTime::currentMSecsSinceEpoch();
-    auto dateTime = QDateTime::fromMSecsSinceEpoch(time);
-    //qDebug() << "cur QDateTime:" <<dateTime.toString(Qt::SystemLocaleShortDate);
-    QDate date = dateTime.date();
-    int year = date.year();
-    int month = date.month();
-    int day = date.day();
-    QDate md_date =  QDateTime::fromMSecsSinceEpoch(modifiedTime * 1000).date();
-    //qDebug() << "modify time:" <<QDateTime::fromMSecsSinceEpoch(modifiedTime *1000).toString(Qt::SystemLocaleShortDate);
-    int md_year= md_date.year();
-    int md_month = md_date.month();
-    int md_day = md_date.day();
-
-    for(int i=0; i<m_modify_time_list.size(); i++)
-    {
-        auto cur = m_modify_time_list[i];
-        switch(cur)
-        {
-        case TODAY:
-        {
-            if (year == md_year && month == md_month && day == md_day)
-                return true;
-            break;
-        }
-        case THIS_WEEK:
-        {
-            QDate md_date(md_year, md_month, md_day);
-            int week, md_week,week_year, md_week_year;
-            week = date.weekNumber(&week_year);
-            md_week = md_date.weekNumber(&md_week_year);
-            if (week == md_week && week_year == md_week_year)
-                return true;
-            break;
-        }
-        case THIS_MONTH:
-        {
-            if (year == md_year && month == md_month)
-                return true;
-            break;
+FileItemColumns *FileItemProxyFilterSortModel::columns() const
+{
+    if (m_columns)
+        return m_columns.get();
+
+    auto model = sourceModel();
+    int rowCount = model? model->rowCount(): 0;
+    if (rowCount < PEONY_COLUMNAR_ROW_THRESHOLD)
+        return nullptr;
+
+    auto table = std::make_shared<FileItemColumns>();
+    table->reserve(rowCount);
+    for (int row = 0; row < rowCount; row++) {
+        auto item = static_cast<FileItem*>(model->index(row, 0).internalPointer());
+        table->insert(row, columnRow(item));
+        //the table replaces the keys of the top level rows, do not keep both.
+        item->m_keys.reset();
+    }
+    m_columns = table;
+    return m_columns.get();
+}
+
+FileItemColumns *FileItemProxyFilterSortModel::writableColumns()
+{
+    if (m_columns.use_count() > 1)
+        m_columns = std::make_shared<FileItemColumns>(*m_columns);
+    return m_columns.get();
+}
+
+FileItemColumns::Row FileItemProxyFilterSortModel::columnRow(FileItem *item) const
+{
+    auto info = item->m_info;
+    FileItemColumns::Row row;
+    row.display_name = info->displayName();
+    row.file_type = info->fileType();
+    row.type_categories = typeCategories(info->type());
+    row.size = info->size();
+    row.modified_time = info->modifiedTime();
+    row.is_dir = item->hasChildren();
+    return row;
+}
+
+void FileItemProxyFilterSortModel::insertColumnRows(const QModelIndex &parent, int first, int last)
+{
+    if (!m_columns || parent.isValid())
+        return;
+
+    auto model = sourceModel();
+    auto table = writableColumns();
+    for (int row = first; row <= last; row++) {
+        auto item = static_cast<FileItem*>(model->index(row, 0).internalPointer());
+        table->insert(row, columnRow(item));
+    }
+}
+
+void FileItemProxyFilterSortModel::removeColumnRows(const QModelIndex &parent, int first, int last)
+{
+    if (!m_columns || parent.isValid())
+        return;
+    writableColumns()->remove(first, last - first + 1);
+}
+
+void FileItemProxyFilterSortModel::dropColumns()
+{
+    m_columns.reset();
+}
+
+bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (!left.isValid() || !right.isValid())
+        return QSortFilterProxyModel::lessThan(left, right);
+
+    //the top level rows of a very large directory are compared on the columns.
+    auto table = !left.parent().isValid() && !right.parent().isValid()? columns(): nullptr;
+    if (table) {
+        if (FileItemSortKey::hasColumnKey(sortColumn())) {
+            return table->lessThan(left.row(), right.row(), sortColumn(), sortOrder(),
+                                   m_folder_first, m_use_default_name_sort_order);
         }
-        case THIS_YEAR:
-        {
-            if (year == md_year)
-                return true;
-            break;
+        if (m_folder_first && table->isDir(left.row()) != table->isDir(right.row())) {
+            if (sortOrder() == Qt::AscendingOrder)
+                return table->isDir(left.row());
+            return !table->isDir(left.row());
         }
-        case YEAR_AGO:
-        {
-            if(year > md_year)
-                return true;
-            break;
+        return QSortFilterProxyModel::lessThan(left, right);
+    }
+
+    const FileItemSortKey &leftKey = sortKey(left);
+    const FileItemSortKey &rightKey = sortKey(right);
+    if (FileItemSortKey::hasColumnKey(sortColumn())) {
+        return FileItemSortKey::lessThan(leftKey, rightKey, sortColumn(), sortOrder(),
+                                         m_folder_first, m_use_default_name_sort_order);
+    }
+
+    //make folder always has a higher order.
+    if (m_folder_first && leftKey.isDir() != rightKey.isDir()) {
+        if (sortOrder() == Qt::AscendingOrder)
+            return leftKey.isDir();
+        return !leftKey.isDir();
+    }
+    return QSortFilterProxyModel::lessThan(left, right);
+}
+
+bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    //the labels are not in the columns, they are read into the filter key of the item.
+    if (!sourceParent.isValid() && !m_filter_predicate.needLabels()) {
+        auto table = columns();
+        if (table && sourceRow < table->count()) {
+            FileItemFilterKey key;
+            table->fillFilterKey(sourceRow, key);
+            return m_filter_predicate.accepts(key);
         }
-        default:
-            break;
+    }
+
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    auto childIndex = model->index(sourceRow, 0, sourceParent);
+    if (!childIndex.isValid())
+        return true;
+
+    auto item = static_cast<FileItem*>(childIndex.internalPointer());
+    return m_filter_predicate.accepts(filterKey(item));
+}
+
+const FileItemFilterKey &FileItemProxyFilterSortModel::filterKey(FileItem *item) const
+{
+    auto keys = itemKeys(item);
+    if (!keys->filter_key) {
+        auto key = std::make_shared<FileItemFilterKey>();
+        auto info = item->m_info;
+        QString displayName = info->displayName();
+        key->is_hidden = !displayName.isEmpty() && displayName.at(0) == '.';
+        key->type_categories = typeCategories(info->type());
+        key->modified_time = qint64(info->modifiedTime());
+        key->size = info->size();
+        keys->filter_key = key;
+    }
+
+    auto key = keys->filter_key;
+    if (m_filter_predicate.needLabels() && !key->labels_loaded) {
+        for (auto id : FileLabelModel::getGlobalModel()->getFileLabelIds(item->m_info->uri())) {
+            FileItemFilterPredicate::setLabelBit(key->label_bits, id);
         }
+        key->labels_loaded = true;
     }
+    return *key;
+}
 
-    return false;
+quint32 FileItemProxyFilterSortModel::typeCategories(const QString &type) const
+{
+    quint32 categories = 0;
+    if (type == Folder_Type)
+        categories |= 1 << FILE_FOLDER;
+    if (type.contains(Image_Type))
+        categories |= 1 << PICTURE;
+    if (type.contains(Video_Type))
+        categories |= 1 << VIDEO;
+    if (type.contains(Text_Type))
+        categories |= 1 << TXT_FILE;
+    if (type.contains(Wps_Type))
+        categories |= 1 << WPS_FILE;
+    if (type.contains(Audio_Type))
+        categories |= 1 << AUDIO;
+    //exclude classfied types, show the rest other types
+    if (categories == 0)
+        categories |= 1 << OTHERS;
+    return categories;
 }
 
-bool FileItemProxyFilterSortModel::checkFileSizeFilter(quint64 size) const
+void FileItemProxyFilterSortModel::compileFilter()
 {
-    //qDebug()<<"checkFileSizeFilter: "<<m_show_file_size<<" "<<size;
-    if (m_file_size_list.count() == 0 || m_file_size_list.contains(ALL_FILE))
-        return true;
+    FileItemFilterPredicate predicate;
+    predicate.show_hidden = m_show_hidden;
 
-    for(int i=0; i<m_file_size_list.count(); i++)
-    {
-        auto cur = m_file_size_list[i];
-        switch (cur)
-        {
-        case TINY: //[0-16K)
-        {
-            if (size < 16 * K_BASE)
-                return true;
-            break;
+    //multiple condition, advance search and default search
+    if (!(m_show_file_type == ALL_FILE && m_file_type_list.count() == 0) && !m_file_type_list.contains(ALL_FILE)) {
+        //support multiple file type choose
+        QList<int> totalTypeList = m_file_type_list;
+        if (m_show_file_type != ALL_FILE)
+            totalTypeList<<m_show_file_type;
+        for (auto type : totalTypeList) {
+            if (type > ALL_TYPE && type <= OTHERS)
+                predicate.type_mask |= 1 << type;
         }
-        case SMALL:  //[16k-1M]
-        {
-            if(size >= 16 * K_BASE && size <=K_BASE * K_BASE)
-                return true;
-            break;
+        //no valid type is chosen, accept nothing.
+        if (predicate.type_mask == 0)
+            predicate.type_mask = 1 << ALL_TYPE;
+    }
+
+    if (m_modify_time_list.count() > 0 && !m_modify_time_list.contains(ALL_FILE)) {
+        predicate.time_filter_enabled = true;
+        QDate today = QDate::currentDate();
+        auto secs = [](const QDate &date) {
+            return QDateTime(date, QTime(0, 0)).toMSecsSinceEpoch() / 1000;
+        };
+        QDate monday = today.addDays(1 - today.dayOfWeek());
+        QDate firstDayOfMonth(today.year(), today.month(), 1);
+        QDate firstDayOfYear(today.year(), 1, 1);
+        for (auto modifyTime : m_modify_time_list) {
+            switch (modifyTime) {
+            case TODAY:
+                predicate.time_ranges<<qMakePair(secs(today), secs(today.addDays(1)));
+                break;
+            case THIS_WEEK:
+                predicate.time_ranges<<qMakePair(secs(monday), secs(monday.addDays(7)));
+                break;
+            case THIS_MONTH:
+                predicate.time_ranges<<qMakePair(secs(firstDayOfMonth), secs(firstDayOfMonth.addMonths(1)));
+                break;
+            case THIS_YEAR:
+                predicate.time_ranges<<qMakePair(secs(firstDayOfYear), secs(firstDayOfYear.addYears(1)));
+                break;
+            case YEAR_AGO:
+                predicate.time_ranges<<qMakePair(std::numeric_limits<qint64>::min(), secs(firstDayOfYear));
+                break;
+            default:
+                break;
+            }
         }
-        case MEDIUM: //(1M-100M]
-        {
-            if(size > K_BASE * K_BASE && size <= 100 * K_BASE * K_BASE)
-                return true;
-            break;
+    }
+
+    if (m_file_size_list.count() > 0 && !m_file_size_list.contains(ALL_FILE)) {
+        predicate.size_filter_enabled = true;
+        for (auto fileSize : m_file_size_list) {
+            switch (fileSize) {
+            case TINY: //[0-16K)
+                predicate.size_ranges<<qMakePair(quint64(0), 16 * K_BASE - 1);
+                break;
+            case SMALL: //[16k-1M]
+                predicate.size_ranges<<qMakePair(16 * K_BASE, K_BASE * K_BASE);
+                break;
+            case MEDIUM: //(1M-100M]
+                predicate.size_ranges<<qMakePair(K_BASE * K_BASE + 1, 100 * K_BASE * K_BASE);
+                break;
+            case BIG: //(100M-1G]
+                predicate.size_ranges<<qMakePair(100 * K_BASE * K_BASE + 1, K_BASE * K_BASE * K_BASE);
+                break;
+            case LARGE: //>1G
+                predicate.size_ranges<<qMakePair(K_BASE * K_BASE * K_BASE + 1, std::numeric_limits<quint64>::max());
+                break;
+            default:
+                break;
+            }
         }
-        case BIG:  //(100M-1G]
-        {
-            if(size > 100 * K_BASE * K_BASE && size <= K_BASE * K_BASE * K_BASE)
-                return true;
-            break;
+    }
+
+    //every label condition is compiled into the ids of the matched labels.
+    auto labels = FileLabelModel::getGlobalModel()->getAllFileLabelItems();
+    if (m_label_name != "") {
+        FileLabelBits clause;
+        for (auto label : labels) {
+            if (label->name() == m_label_name)
+                FileItemFilterPredicate::setLabelBit(clause, label->id());
         }
-        case LARGE: //>1G
-        {
-            if (size > K_BASE * K_BASE * K_BASE)
-                return true;
-            break;
+        predicate.label_clauses<<clause;
+    }
+    if (m_label_color != Qt::transparent) {
+        FileLabelBits clause;
+        for (auto label : labels) {
+            if (label->color() == m_label_color)
+                FileItemFilterPredicate::setLabelBit(clause, label->id());
         }
-        default:
-            break;
+        predicate.label_clauses<<clause;
+    }
+    //file has any one of these label is accepted
+    if (m_show_label_names.size() > 0 || m_show_label_colors.size() > 0) {
+        FileLabelBits clause;
+        for (auto label : labels) {
+            if (m_show_label_names.contains(label->name()) || m_show_label_colors.contains(label->color()))
+                FileItemFilterPredicate::setLabelBit(clause, label->id());
+        }
+        predicate.label_clauses<<clause;
+    }
+    //check the blur name, can use as search color labels
+    if (m_blur_name != "") {
+        FileLabelBits clause;
+        for (auto label : labels) {
+            if (label->name().contains(m_blur_name, m_case_sensitive? Qt::CaseSensitive: Qt::CaseInsensitive))
+                FileItemFilterPredicate::setLabelBit(clause, label->id());
         }
+        predicate.label_clauses<<clause;
     }
 
-    return false;
+    m_filter_predicate = predicate;
 }
 
-
 void FileItemProxyFilterSortModel::update()
 {
+    compileFilter();
     invalidateFilter();
 }
 
@@ -458,6 +989,7 @@ void FileItemProxyFilterSortModel::setShowHidden(bool showHidden)
 {
     GlobalSettings::getInstance()->setValue("show-hidden", showHidden);
     m_show_hidden = showHidden;
+    compileFilter();
     invalidateFilter();
 }
 
@@ -465,18 +997,14 @@ void FileItemProxyFilterSortModel::setUseDefaultNameSortOrder(bool use)
 {
     GlobalSettings::getInstance()->setValue("chinese-first", use);
     m_use_default_name_sort_order = use;
-    beginResetModel();
-    sort(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
-    endResetModel();
+    resortAll();
 }
 
 void FileItemProxyFilterSortModel::setFolderFirst(bool folderFirst)
 {
     GlobalSettings::getInstance()->setValue("folder-first", folderFirst);
     m_folder_first = folderFirst;
-    beginResetModel();
-    sort(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
-    endResetModel();
+    resortAll();
 }
 
 void FileItemProxyFilterSortModel::addFilterCondition(int option, int classify, bool updateNow)
@@ -499,6 +1027,7 @@ void FileItemProxyFilterSortModel::addFilterCondition(int option, int classify,
         break;
     }
 
+    compileFilter();
     if (updateNow)
         invalidateFilter();
 }
@@ -523,6 +1052,7 @@ void FileItemProxyFilterSortModel::removeFilterCondition(int option, int classif
         break;
     }
 
+    compileFilter();
     if (updateNow)
         invalidateFilter();
 }
@@ -532,6 +1062,7 @@ void FileItemProxyFilterSortModel::clearConditions()
     m_file_type_list.clear();
     m_file_size_list.clear();
     m_modify_time_list.clear();
+    compileFilter();
 }
 
 void FileItemProxyFilterSortModel::setFilterConditions(int fileType, int modifyTime, int fileSize)
@@ -539,6 +1070,7 @@ void FileItemProxyFilterSortModel::setFilterConditions(int fileType, int modifyT
     m_show_file_type = fileType;
     m_show_file_size = fileSize;
     m_show_modify_time = modifyTime;
+    compileFilter();
     invalidateFilter();
 }
 
@@ -546,6 +1078,7 @@ void FileItemProxyFilterSortModel::setFilterLabelConditions(QString name, QColor
 {
     m_label_name = name;
     m_label_color = color;
+    compileFilter();
     invalidateFilter();
 }
 
@@ -562,6 +1095,7 @@ void FileItemProxyFilterSortModel::setMutipleLabelConditions(QStringList names,
     {
         m_show_label_colors.append(color);
     }
+    compileFilter();
     invalidateFilter();
 }
 
@@ -569,19 +1103,10 @@ void FileItemProxyFilterSortModel::setLabelBlurName(QString blurName, bool caseS
 {
     m_blur_name = blurName;
     m_case_sensitive = caseSensitive;
+    compileFilter();
     invalidateFilter();
 }
 
-bool FileItemProxyFilterSortModel::startWithChinese(const QString &displayName) const
-{
-    //NOTE: a newly created file might could not get display name soon.
-    if (displayName.isEmpty()) {
-        return false;
-    }
-    auto firstStrUnicode = displayName.at(0).unicode();
-    return (firstStrUnicode <=0x9FA5 && firstStrUnicode >= 0x4E00);
-}
-
 QModelIndexList FileItemProxyFilterSortModel::getAllFileIndexes()
 {
     //FIXME: how about the tree?
@@ -607,6 +1132,25 @@ QModelIndexList FileItemProxyFilterSortModel::getAllFileIndexes()
     return l;
 }
 
+void FileItemProxyFilterSortModel::setVisibleRows(int first, int last)
+{
+    auto model = qobject_cast<FileItemModel *>(sourceModel());
+    if (!model || first < 0 || last < first)
+        return;
+
+    int margin = last - first + 1;
+    first = qMax(0, first - margin);
+    last = qMin(rowCount() - 1, last + margin);
+
+    QStringList uris;
+    for (int row = first; row <= last; row++) {
+        auto item = itemFromIndex(index(row, 0));
+        if (item)
+            uris<<item->uri();
+    }
+    model->setVisibleUris(uris);
+}
+
 QStringList FileItemProxyFilterSortModel::getAllFileUris()
 {
     QStringList l;
@@ -27,13 +27,41 @@
 #include <QObject>
 #include <QSortFilterProxyModel>
 #include <QColor>
+#include <QFutureWatcher>
+#include <QAtomicInt>
 
 #include "peony-core_global.h"
+#include "file-item-filter-predicate.h"
+#include "file-item-columns.h"
+
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief PEONY_PARALLEL_SORT_THRESHOLD
+ * The directories with at least this number of rows are sorted in worker threads.
+ */
+#ifndef PEONY_PARALLEL_SORT_THRESHOLD
+#define PEONY_PARALLEL_SORT_THRESHOLD 50000
+#endif
+
+/*!
+ * \brief PEONY_MISPLACED_ROW_RATIO
+ * The top level rows kept in source order are placed one by one when they are
+ * inserted or changed, unless more than 1/PEONY_MISPLACED_ROW_RATIO of them are
+ * misplaced, then the directory is sorted in worker threads again.
+ */
+#ifndef PEONY_MISPLACED_ROW_RATIO
+#define PEONY_MISPLACED_ROW_RATIO 16
+#endif
 
 namespace Peony {
 
 class FileItem;
+struct FileItemKeys;
 class FileItemModel;
+class FileItemSortKey;
+struct FileItemSortSnapshot;
 
 class PEONYCORESHARED_EXPORT FileItemProxyFilterSortModel : public QSortFilterProxyModel
 {
@@ -77,6 +105,7 @@ public:
     const QString Audio_Type = "audio/";
 
     explicit FileItemProxyFilterSortModel(QObject *parent = nullptr);
+    ~FileItemProxyFilterSortModel() override;
     void setSourceModel(QAbstractItemModel *model) override;
     void setShowHidden(bool showHidden);
     void setUseDefaultNameSortOrder(bool use);
@@ -96,6 +125,48 @@ public:
     //give blur name to search color labels, can set CaseSensitive or not
     void setLabelBlurName(QString blurName = "", bool CaseSensitive = false);
 
+    /*!
+     * \brief sort
+     * \param column
+     * \param order
+     * <br>
+     * The proxy keeps its rows sorted incrementally, a new row is inserted at the
+     * position found by binary search and a changed row is moved alone. So the
+     * whole model is only sorted when the sort column or order changes, calling
+     * sort() with the current column and order does nothing.
+     * </br>
+     * <br>
+     * A directory with more than PEONY_PARALLEL_SORT_THRESHOLD rows is sorted by a
+     * parallel merge sort over a snapshot of the sort keys in worker threads, the
+     * missing keys are prepared there too. The result is applied at once by moving
+     * the source rows into the sorted order in one layout change, QSortFilterProxyModel
+     * then keeps the source order without comparing any row, see applyPermutation().
+     * If rows are removed, or a changed row might move, before the sort finished, the
+     * sort is restarted. The appended rows are placed after it finished.
+     * </br>
+     * <br>
+     * While the rows are kept in source order, sortColumn() returns -1. Until the sort
+     * finished, the old order is shown.
+     * </br>
+     * \see resortAll(), requestedSortColumn().
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /*!
+     * \brief requestedSortColumn
+     * \return the column of the latest sort() call, which might be still sorting.
+     * Views should use it instead of sortColumn() to show the sort settings.
+     */
+    int requestedSortColumn() {
+        return m_requested_sort_column;
+    }
+    Qt::SortOrder requestedSortOrder() {
+        return m_requested_sort_order;
+    }
+    bool isSorting() {
+        return m_sort_watcher != nullptr;
+    }
+
     FileItem *itemFromIndex(const QModelIndex &proxyIndex);
     QModelIndex getSourceIndex(const QModelIndex &proxyIndex);
     const QModelIndex indexFromUri(const QString &uri);
@@ -103,6 +174,18 @@ public:
     QStringList getAllFileUris();
     QModelIndexList getAllFileIndexes();
 
+    /*!
+     * \brief setVisibleRows
+     * \param first, the first row shown in a view.
+     * \param last, the last row shown in a view.
+     * <br>
+     * Tell the source model which items are in the viewport. The rows of
+     * one more viewport before and after them are reported as a prefetch margin.
+     * </br>
+     * \see FileItemModel::setVisibleUris().
+     */
+    void setVisibleRows(int first, int last);
+
 public Q_SLOTS:
     void update();
 
@@ -111,10 +194,131 @@ protected:
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
 
 private:
-    bool startWithChinese(const QString &displayName) const;
-    bool checkFileTypeFilter(QString type) const;
-    bool checkFileModifyTimeFilter(quint64 modifiedTime) const;
-    bool checkFileSizeFilter(quint64 size) const;
+    /*!
+     * \brief resortAll
+     * Sort the whole model again, it is used when the comparator itself changed,
+     * such as folder-first or chinese-first.
+     */
+    void resortAll();
+
+    /*!
+     * \brief sortKey
+     * \return the sort key of the item of source index, create it if it doesn't exist.
+     */
+    const FileItemSortKey &sortKey(const QModelIndex &sourceIndex) const;
+    /*!
+     * \brief itemKeys
+     * \return the keys of the item, they are created at the first call.
+     */
+    FileItemKeys *itemKeys(FileItem *item) const;
+    /*!
+     * \brief rawSortKey
+     * \return a new key of the item with the raw values only, see FileItemSortKey::prepare().
+     */
+    std::shared_ptr<FileItemSortKey> rawSortKey(FileItem *item) const;
+    /*!
+     * \brief dropItemKeys
+     * Drop the sort keys and filter keys of the changed rows. It is connected before
+     * QSortFilterProxyModel connects the source model, so the changed rows are resorted
+     * and filtered with new keys.
+     * <br>
+     * The changes of the decoration only, such as thumbnails, keep the keys. The running
+     * sort is restarted only if a changed row might be placed differently.
+     * </br>
+     */
+    void dropItemKeys(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    /*!
+     * \brief keepsSortPosition
+     * \return true if the values of the row compared by the running sort are the
+     * same as the ones in its snapshot.
+     */
+    bool keepsSortPosition(int row, FileItem *item) const;
+
+    /*!
+     * \brief compileFilter
+     * Compile the current filter conditions into m_filter_predicate. It must be
+     * called once the conditions changed, before filtering.
+     */
+    void compileFilter();
+    const FileItemFilterKey &filterKey(FileItem *item) const;
+    quint32 typeCategories(const QString &type) const;
+
+    /*!
+     * \brief startSort
+     * Sort the whole model with the requested column and order, in gui thread
+     * for small directories, or in worker threads for large ones.
+     */
+    void startSort();
+    void cancelSort();
+    /*!
+     * \brief applySort
+     * Let QSortFilterProxyModel sort the whole model with the requested column
+     * and order, it is only used for the directories sorted in gui thread.
+     */
+    void applySort();
+    void onSourceChanged();
+    void scheduleSort();
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceLayoutChanged();
+
+    /*!
+     * \brief applyPermutation
+     * \param sourceParent
+     * \param rows, the old source row of every new source row.
+     * <br>
+     * Apply the result of a sort by moving the source rows into the order
+     * with one layout change, see FileItemModel::permuteChildren(). The first
+     * permutation of the top level rows makes QSortFilterProxyModel stop sorting,
+     * it only filters and keeps the source order from then on, so the rows are
+     * never compared again in gui thread.
+     * </br>
+     * \see m_source_ordered.
+     */
+    void applyPermutation(const QModelIndex &sourceParent, const std::vector<int> &rows);
+    /*!
+     * \brief leaveSourceOrder
+     * Let QSortFilterProxyModel sort the rows by itself again, it is used once
+     * the source model is reset.
+     */
+    void leaveSourceOrder();
+    /*!
+     * \brief sortExpandedChildren
+     * Sort the children of the expanded rows under sourceParent in gui thread,
+     * they are usually only a few.
+     */
+    void sortExpandedChildren(const QModelIndex &sourceParent);
+    /*!
+     * \brief sourceRowBefore
+     * \return true if the left source row is shown before the right one with the
+     * requested column and order.
+     */
+    bool sourceRowBefore(const QModelIndex &sourceParent, int left, int right) const;
+    bool isSourceRangeOrdered(const QModelIndex &sourceParent, int first, int last) const;
+    /*!
+     * \brief placeMisplacedRows
+     * Move the inserted or changed rows kept in source order to their positions,
+     * found by binary search among the other rows.
+     */
+    void placeMisplacedRows();
+    void schedulePlaceMisplacedRows();
+
+    /*!
+     * \brief columns
+     * \return the columnar table of the top level source rows, or nullptr if there are
+     * less than PEONY_COLUMNAR_ROW_THRESHOLD rows. It is built at the first use and
+     * kept in sync with the source rows until the model is reset.
+     */
+    FileItemColumns *columns() const;
+    /*!
+     * \brief writableColumns
+     * \return the columnar table to modify, it is copied first if a sort still reads it.
+     */
+    FileItemColumns *writableColumns();
+    FileItemColumns::Row columnRow(FileItem *item) const;
+    void insertColumnRows(const QModelIndex &parent, int first, int last);
+    void removeColumnRows(const QModelIndex &parent, int first, int last);
+    void dropColumns();
+
 
 private:
     bool m_show_hidden;
@@ -130,6 +334,31 @@ private:
     QList<int> m_file_type_list, m_modify_time_list, m_file_size_list;
     QStringList m_show_label_names;
     QList<QColor> m_show_label_colors;
+
+    FileItemFilterPredicate m_filter_predicate;
+
+    int m_requested_sort_column = -1;
+    Qt::SortOrder m_requested_sort_order = Qt::AscendingOrder;
+
+    QFutureWatcher<std::vector<int>> *m_sort_watcher = nullptr;
+    std::shared_ptr<QAtomicInt> m_sort_cancelled;
+    bool m_sort_restart_scheduled = false;
+    /*!
+     * \brief m_source_ordered
+     * True if the source rows are kept in the requested order by applyPermutation(),
+     * and QSortFilterProxyModel does not sort them.
+     */
+    bool m_source_ordered = false;
+    bool m_applying_permutation = false;
+    QList<QPersistentModelIndex> m_misplaced_indexes;
+    bool m_place_misplaced_scheduled = false;
+    /*!
+     * \brief m_sort_snapshot
+     * The snapshot of the running parallel sort, shared with the worker threads.
+     */
+    std::shared_ptr<FileItemSortSnapshot> m_sort_snapshot;
+
+    mutable std::shared_ptr<FileItemColumns> m_columns;
 };
 
 }
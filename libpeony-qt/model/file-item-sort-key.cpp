@@ -0,0 +1,253 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "file-item-sort-key.h"
+#include "file-item-model.h"
+
+#include <QCollator>
+#include <QLocale>
+#include <QHash>
+#include <QMap>
+
+using namespace Peony;
+
+static QCollator &collator()
+{
+    static QCollator global_collator = QCollator(FileItemSortKey::collatorLocale());
+    return global_collator;
+}
+
+/*!
+ * \brief typeOrdinal
+ * \return the rank of the file type in all the types ever seen. The ranks follow
+ * the order of the type strings, and are renumbered once a new type is inserted,
+ * which is rare as there are only a few types in a system.
+ */
+static std::shared_ptr<int> typeOrdinal(const QString &fileType)
+{
+    static QMap<QString, std::shared_ptr<int>> ordinals;
+    auto it = ordinals.constFind(fileType);
+    if (it != ordinals.constEnd())
+        return *it;
+
+    auto ordinal = std::make_shared<int>(0);
+    ordinals.insert(fileType, ordinal);
+    int rank = 0;
+    for (auto value : ordinals) {
+        *value = rank;
+        rank++;
+    }
+    return ordinal;
+}
+
+/*!
+ * \brief removeDuplicatedSuffixes
+ * \return the name without all "(number)", the same as removing QRegExp("\\(\\d+\\)").
+ * number is set to the value of the last one, or 0.
+ */
+static QString removeDuplicatedSuffixes(const QString &name, int *number)
+{
+    *number = 0;
+    if (!name.contains('('))
+        return name;
+
+    QString base;
+    base.reserve(name.size());
+    int i = 0;
+    int length = name.size();
+    while (i < length) {
+        if (name.at(i) == '(') {
+            int j = i + 1;
+            while (j < length && name.at(j).isDigit())
+                j++;
+            if (j > i + 1 && j < length && name.at(j) == ')') {
+                *number = name.midRef(i + 1, j - i - 1).toInt();
+                i = j + 1;
+                continue;
+            }
+        }
+        base.append(name.at(i));
+        i++;
+    }
+    return base;
+}
+
+static bool startWithChinese(const QString &displayName)
+{
+    //NOTE: a newly created file might could not get display name soon.
+    if (displayName.isEmpty())
+        return false;
+    auto firstStrUnicode = displayName.at(0).unicode();
+    return (firstStrUnicode <=0x9FA5 && firstStrUnicode >= 0x4E00);
+}
+
+FileItemSortKey::FileItemSortKey(const QString &displayName,
+                                 const QString &fileType,
+                                 quint64 size,
+                                 quint64 modifiedTime,
+                                 bool isDir)
+    : FileItemSortKey(displayName, ::typeOrdinal(fileType), size, modifiedTime, isDir)
+{
+    prepare(collator());
+}
+
+FileItemSortKey::FileItemSortKey(const QString &displayName,
+                                 const std::shared_ptr<int> &typeOrdinal,
+                                 quint64 size,
+                                 quint64 modifiedTime,
+                                 bool isDir)
+{
+    m_display_name = displayName;
+    m_type_ordinal = typeOrdinal;
+    m_size = size;
+    m_modified_time = modifiedTime;
+    m_is_dir = isDir;
+}
+
+void FileItemSortKey::prepare(const QCollator &collator)
+{
+    m_lower_name = m_display_name.toLower();
+    m_duplicated_base = removeDuplicatedSuffixes(m_display_name, &m_duplicated_number);
+    m_duplicated_base_hash = qHash(m_duplicated_base);
+
+    m_start_with_chinese = startWithChinese(m_display_name);
+    if (m_start_with_chinese)
+        m_collator_key = std::make_shared<QCollatorSortKey>(collator.sortKey(m_display_name));
+}
+
+bool FileItemSortKey::sameSortValues(const FileItemSortKey &other, int column, bool folderFirst) const
+{
+    if (folderFirst && m_is_dir != other.m_is_dir)
+        return false;
+
+    switch (column) {
+    case FileItemModel::FileName:
+        return m_display_name == other.m_display_name;
+    case FileItemModel::FileSize:
+        return m_size == other.m_size;
+    case FileItemModel::FileType:
+        return m_type_ordinal == other.m_type_ordinal;
+    case FileItemModel::ModifiedDate:
+        return m_modified_time == other.m_modified_time;
+    default:
+        return true;
+    }
+}
+
+std::shared_ptr<int> FileItemSortKey::sharedTypeOrdinal(const QString &fileType)
+{
+    return ::typeOrdinal(fileType);
+}
+
+QString FileItemSortKey::duplicatedBase(const QString &name, int *number)
+{
+    return removeDuplicatedSuffixes(name, number);
+}
+
+bool FileItemSortKey::startsWithChinese(const QString &displayName)
+{
+    return startWithChinese(displayName);
+}
+
+QCollatorSortKey FileItemSortKey::collatorKey(const QString &displayName)
+{
+    return collator().sortKey(displayName);
+}
+
+QLocale FileItemSortKey::collatorLocale()
+{
+    return QLocale(QLocale::system().name());
+}
+
+bool FileItemSortKey::hasColumnKey(int column)
+{
+    switch (column) {
+    case FileItemModel::FileName:
+    case FileItemModel::FileSize:
+    case FileItemModel::FileType:
+    case FileItemModel::ModifiedDate:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FileItemSortKey::lessThan(const FileItemSortKey &left,
+                               const FileItemSortKey &right,
+                               int column,
+                               Qt::SortOrder order,
+                               bool folderFirst,
+                               bool chineseFirst)
+{
+    return lessThan(left, *left.m_type_ordinal, right, *right.m_type_ordinal,
+                    column, order, folderFirst, chineseFirst);
+}
+
+bool FileItemSortKey::lessThan(const FileItemSortKey &left,
+                               int leftTypeOrdinal,
+                               const FileItemSortKey &right,
+                               int rightTypeOrdinal,
+                               int column,
+                               Qt::SortOrder order,
+                               bool folderFirst,
+                               bool chineseFirst)
+{
+    //make folder always has a higher order.
+    if (folderFirst && left.m_is_dir != right.m_is_dir) {
+        if (order == Qt::AscendingOrder)
+            return left.m_is_dir;
+        return !left.m_is_dir;
+    }
+
+    switch (column) {
+    case FileItemModel::FileName:
+        return left.nameLessThan(right, order, chineseFirst);
+    case FileItemModel::FileSize:
+        return left.m_size < right.m_size;
+    case FileItemModel::FileType:
+        return leftTypeOrdinal < rightTypeOrdinal;
+    case FileItemModel::ModifiedDate:
+        return left.m_modified_time < right.m_modified_time;
+    default:
+        return false;
+    }
+}
+
+bool FileItemSortKey::nameLessThan(const FileItemSortKey &other, Qt::SortOrder order, bool chineseFirst) const
+{
+    if (m_duplicated_base_hash == other.m_duplicated_base_hash && m_duplicated_base == other.m_duplicated_base) {
+        if (m_duplicated_number == other.m_duplicated_number)
+            return m_display_name < other.m_display_name;
+        return m_duplicated_number < other.m_duplicated_number;
+    }
+
+    if (chineseFirst) {
+        //all start with Chinese, use the locale compare.
+        if (m_start_with_chinese && other.m_start_with_chinese)
+            return m_collator_key->compare(*other.m_collator_key) < 0;
+        if (m_start_with_chinese || other.m_start_with_chinese) {
+            if (order == Qt::AscendingOrder)
+                return m_start_with_chinese;
+            return other.m_start_with_chinese;
+        }
+    }
+
+    return m_lower_name < other.m_lower_name;
+}
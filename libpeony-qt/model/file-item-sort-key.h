@@ -0,0 +1,180 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILEITEMSORTKEY_H
+#define FILEITEMSORTKEY_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QCollator>
+#include <QCollatorSortKey>
+
+#include <memory>
+
+namespace Peony {
+
+/*!
+ * \brief The FileItemSortKey class
+ * <br>
+ * FileItemSortKey holds the values FileItemProxyFilterSortModel compares, computed
+ * once when the info of an item arrives. The lowercased name, the name without
+ * the duplicated suffixes such as "(1)", the number of the last suffix, the collator
+ * key of a chinese name and the ordinal of the file type are prepared here, so that
+ * a comparison is only a string or an integer comparison, without regular expressions
+ * or allocations.
+ * </br>
+ * \note the keys should be created and compared in gui thread, the type ordinals are
+ * shared in the whole process and renumbered when a new file type appears. A key
+ * created with a type ordinal can be prepared in a worker thread, see prepare().
+ */
+class PEONYCORESHARED_EXPORT FileItemSortKey
+{
+public:
+    explicit FileItemSortKey(const QString &displayName,
+                             const QString &fileType = nullptr,
+                             quint64 size = 0,
+                             quint64 modifiedTime = 0,
+                             bool isDir = false);
+    /*!
+     * \brief FileItemSortKey
+     * Create a key with the raw values only, prepare() must be called before
+     * the key is compared. The type ordinal should be taken in gui thread.
+     */
+    FileItemSortKey(const QString &displayName,
+                    const std::shared_ptr<int> &typeOrdinal,
+                    quint64 size,
+                    quint64 modifiedTime,
+                    bool isDir);
+
+    /*!
+     * \brief prepare
+     * \param collator, it should not be used by other threads at the same time.
+     * Compute the name keys from the display name. It only writes the name keys,
+     * so sameSortValues() can read the key in another thread meanwhile.
+     */
+    void prepare(const QCollator &collator);
+
+    /*!
+     * \brief sameSortValues
+     * \return true if other is placed the same as this key when sorted by column,
+     * which means a sort by column need not run again for the change from this to other.
+     */
+    bool sameSortValues(const FileItemSortKey &other, int column, bool folderFirst) const;
+
+    bool isDir() const {
+        return m_is_dir;
+    }
+
+    /*!
+     * \brief typeOrdinal
+     * \return the current rank of the file type, it might change once a new type appears.
+     */
+    int typeOrdinal() const {
+        return *m_type_ordinal;
+    }
+
+    /*!
+     * \brief hasColumnKey
+     * \param column, a FileItemModel::ColumnType.
+     * \return true if the column could be compared by lessThan().
+     */
+    static bool hasColumnKey(int column);
+
+    /*!
+     * \brief lessThan
+     * \return the same result of the old FileItemProxyFilterSortModel::lessThan().
+     * <br>
+     * Folders are placed before files if folderFirst is true, the order is the
+     * same in both sort orders, as QSortFilterProxyModel reverses the result when
+     * sorting in descending order. If chineseFirst is true, the names start with
+     * chinese are placed before the others and sorted by locale.
+     * </br>
+     */
+    static bool lessThan(const FileItemSortKey &left,
+                         const FileItemSortKey &right,
+                         int column,
+                         Qt::SortOrder order,
+                         bool folderFirst,
+                         bool chineseFirst);
+
+    /*!
+     * \brief lessThan
+     * The same as above, but compares the file types with the given ordinals.
+     * It is used in worker threads with the ordinals taken in gui thread, because
+     * the shared ordinals might be renumbered during the comparisons.
+     */
+    static bool lessThan(const FileItemSortKey &left,
+                         int leftTypeOrdinal,
+                         const FileItemSortKey &right,
+                         int rightTypeOrdinal,
+                         int column,
+                         Qt::SortOrder order,
+                         bool folderFirst,
+                         bool chineseFirst);
+
+    /*!
+     * \brief sharedTypeOrdinal
+     * \return the rank of the file type, shared by all the keys of the type.
+     * It might change once a new type appears.
+     */
+    static std::shared_ptr<int> sharedTypeOrdinal(const QString &fileType);
+    /*!
+     * \brief duplicatedBase
+     * \return the name without all "(number)", number is set to the value of the last one, or 0.
+     */
+    static QString duplicatedBase(const QString &name, int *number);
+    static bool startsWithChinese(const QString &displayName);
+    static QCollatorSortKey collatorKey(const QString &displayName);
+    /*!
+     * \brief collatorLocale
+     * \return the locale of the name collator, a worker thread creates its own
+     * collator with it, as a collator can not be shared between threads.
+     */
+    static QLocale collatorLocale();
+
+private:
+    bool nameLessThan(const FileItemSortKey &other, Qt::SortOrder order, bool chineseFirst) const;
+
+    QString m_display_name;
+    QString m_lower_name;
+
+    /*!
+     * \brief m_duplicated_base
+     * The display name with all "(number)" removed, 2 names with the same base
+     * are sorted by m_duplicated_number.
+     */
+    QString m_duplicated_base;
+    uint m_duplicated_base_hash = 0;
+    int m_duplicated_number = 0;
+
+    bool m_start_with_chinese = false;
+    std::shared_ptr<QCollatorSortKey> m_collator_key;
+
+    std::shared_ptr<int> m_type_ordinal;
+
+    quint64 m_size = 0;
+    quint64 m_modified_time = 0;
+    bool m_is_dir = false;
+};
+
+}
+
+#endif // FILEITEMSORTKEY_H
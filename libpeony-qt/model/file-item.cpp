@@ -23,11 +23,14 @@
 #include "file-item.h"
 #include "file-enumerator.h"
 #include "file-info-job.h"
+#include "file-info-batch-job.h"
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-utils.h"
 
 #include "file-item-model.h"
+#include "directory-snapshot-cache.h"
+#include "persistent-listing-cache.h"
 
 #include "thumbnail-manager.h"
 
@@ -38,6 +41,11 @@
 
 #include <QMessageBox>
 #include <QUrl>
+#include <QTimer>
+#include <QSet>
+
+#include <algorithm>
+#include <functional>
 
 using namespace Peony;
 
@@ -45,12 +53,9 @@ FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem,
 {
     m_parent = parentItem;
     m_info = info;
-    m_children = new QVector<FileItem*>();
 
     m_model = model;
 
-    m_backend_enumerator = new FileEnumerator(this);
-
     // avoid call any method when model is deleted.
     setParent(m_model);
 }
@@ -61,21 +66,24 @@ FileItem::~FileItem()
     Q_EMIT cancelFindChildren();
     //disconnect();
 
-    if (m_info.use_count() <= 2) {
-        auto info = FileInfoManager::getInstance()->findFileInfoByUri(m_info->uri()).get();
-        if (info == m_info.get()) {
-            Peony::FileInfoManager::getInstance()->lock();
-            Peony::FileInfoManager::getInstance()->remove(m_info);
-            Peony::FileInfoManager::getInstance()->unlock();
-        }
-    }
-
-    for (auto child : *m_children) {
+    for (auto child : m_children) {
         delete child;
     }
-    m_children->clear();
+    m_children.clear();
+}
 
-    delete m_children;
+FileItemDirectoryState *FileItem::directoryState()
+{
+    if (!m_directory)
+        m_directory.reset(new FileItemDirectoryState);
+    return m_directory.get();
+}
+
+std::shared_ptr<FileWatcher> FileItem::childrenWatcher() const
+{
+    if (!m_directory)
+        return nullptr;
+    return m_directory->watcher;
 }
 
 bool FileItem::operator==(const FileItem &item)
@@ -94,17 +102,16 @@ QVector<FileItem*> *FileItem::findChildrenSync()
     Q_EMIT m_model->findChildrenStarted();
     std::shared_ptr<Peony::FileEnumerator> enumerator = std::make_shared<Peony::FileEnumerator>();
     enumerator->setEnumerateDirectory(m_info->uri());
+    //children infos are filled while enumerating, no need to query them again.
+    enumerator->setQueryFullInfo();
     enumerator->enumerateSync();
     auto infos = enumerator->getChildren(true);
     for (auto info : infos) {
         FileItem *child = new FileItem(info, this, m_model);
-        m_children->append(child);
-        FileInfoJob *job = new FileInfoJob(info);
-        job->setAutoDelete();
-        job->querySync();
+        appendChild(child);
     }
     Q_EMIT m_model->findChildrenFinished();
-    return m_children;
+    return &m_children;
 }
 
 void FileItem::findChildrenAsync()
@@ -116,6 +123,11 @@ void FileItem::findChildrenAsync()
     m_expanded = true;
     Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
     enumerator->setEnumerateDirectory(m_info->uri());
+    //query the children's full info in enumeration, so that we don't need
+    //start an extra info job for each child.
+    enumerator->setQueryFullInfo();
+    //the enumeration is dropped at once when the view navigates away.
+    enumerator->setCancellationGroup(m_model->ioCancellationGroup());
     //NOTE: entry a new root might destroyed the current enumeration work.
     //the root item will be delete, so we should cancel the previous enumeration.
     enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
@@ -172,47 +184,20 @@ void FileItem::findChildrenAsync()
     });
 
     if (!m_model->isPositiveResponse()) {
+        //stream the found children into model, the first screen is shown
+        //before the deadline, and the following ones are merged every frame.
+        auto state = directoryState();
+        state->first_children_flushed = false;
+        state->find_children_timer.start();
+        enumerator->connect(enumerator, &Peony::FileEnumerator::childrenUpdated, this, [=](const QStringList &uris) {
+            directoryState()->pending_children_uris<<uris;
+            scheduleFlushPendingChildren();
+        });
         enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed) {
+            flushPendingChildren();
             if (successed) {
-                auto infos = enumerator->getChildren(true);
-                m_async_count = infos.count();
-                if (infos.count() == 0) {
-                    Q_EMIT m_model->findChildrenFinished();
-                }
-
-                for (auto info : infos) {
-                    FileItem *child = new FileItem(info, this, m_model);
-                    m_children->prepend(child);
-                    FileInfoJob *job = new FileInfoJob(info);
-                    job->setAutoDelete();
-                    /*
-                    FileInfo *shared_info = info.get();
-                    int row = infos.indexOf(info);
-                    //qDebug()<<info->uri()<<row;
-                    job->connect(job, &FileInfoJob::infoUpdated, this, [=](){
-                        qDebug()<<shared_info->iconName()<<row;
-                    });
-                    */
-                    connect(job, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        //the query job is finished and will be deleted soon,
-                        //whatever info was updated, we need decrease the async count.
-                        m_async_count--;
-                        if (m_async_count == 0) {
-                            m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
-                            Q_EMIT this->m_model->findChildrenFinished();
-                            Q_EMIT m_model->updated();
-                            for (auto info : infos) {
-                                ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_watcher);
-                            }
-                        }
-                    });
-
-                    connect(job, &FileInfoJob::infoUpdated, this, [=](){
-                        m_model->dataChanged(child->firstColumnIndex(), child->lastColumnIndex());
-                    });
-
-                    job->queryAsync();
-                }
+                Q_EMIT this->m_model->findChildrenFinished();
+                m_model->requestUpdate();
             } else {
                 Q_EMIT m_model->findChildrenFinished();
                 return;
@@ -221,58 +206,9 @@ void FileItem::findChildrenAsync()
             enumerator->cancel();
             delete enumerator;
 
-            m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
-            m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
-                //add new item to m_children
-                //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
-                //remove the crosponding child
-                //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
-            connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
-                //clean all the children, if item index is root index, cd up.
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->deleted(uri);
-                this->onDeleted(uri);
-            });
-
-            connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri) {
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->renamed(oldUri, newUri);
-                this->onRenamed(oldUri, newUri);
-            });
-
-            connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
-                m_model->setRootUri("computer:///");
-            });
-            //qDebug()<<"startMonitor";
-
-            connect(m_watcher.get(), &FileWatcher::requestUpdateDirectory, this, &FileItem::onUpdateDirectoryRequest);
-            m_watcher->startMonitor();
+            directoryState()->children_loaded = true;
+            saveChildrenListing();
+            startChildrenWatcher();
         });
     } else {
         enumerator->connect(enumerator, &Peony::FileEnumerator::childrenUpdated, this, [=](const QStringList &uris) {
@@ -280,94 +216,181 @@ void FileItem::findChildrenAsync()
                 Q_EMIT m_model->findChildrenFinished();
             }
 
-            if (!m_children) {
-                enumerator->disconnect();
-                delete enumerator;
-                return ;
-            }
+            if (uris.isEmpty())
+                return;
 
+            //the infos have been filled by enumerator, insert the batch at once.
+            int row = m_children.count();
+            m_model->beginInsertRows(firstColumnIndex(), row, row + uris.count() - 1);
             for (auto uri : uris) {
-                auto info = FileInfo::fromUri(uri);
-                auto item = new FileItem(info, this, m_model);
-                m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-                m_children->append(item);
-                m_model->endInsertRows();
-                auto infoJob = new FileInfoJob(info);
-                infoJob->setAutoDelete();
-                infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-                    Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                    //Q_EMIT m_model->updated();
-                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_watcher);
-                });
-                infoJob->queryAsync();
+                appendChild(new FileItem(FileInfo::fromUri(uri), this, m_model));
             }
+            m_model->endInsertRows();
+            requestChildrenThumbnails(uris);
         });
 
-        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=]() {
+        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed) {
             delete enumerator;
-            if (!m_model||!m_children||!m_info)
+            if (!m_model||!m_info)
                 return;
 
+            directoryState()->children_loaded = successed;
+            saveChildrenListing();
             Q_EMIT m_model->findChildrenFinished();
-            Q_EMIT m_model->updated();
-
-            m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
-            m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
-                //add new item to m_children
-                //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-                ThumbnailManager::getInstance()->createThumbnail(uri, m_watcher);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
-                //remove the crosponding child
-                //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
-            connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
-                //clean all the children, if item index is root index, cd up.
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->deleted(uri);
-                this->onDeleted(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri) {
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->renamed(oldUri, newUri);
-                this->onRenamed(oldUri, newUri);
-            });
-
-            connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
-                m_model->setRootUri("computer:///");
-            });
-            //qDebug()<<"startMonitor";
-            connect(m_watcher.get(), &FileWatcher::requestUpdateDirectory, this, &FileItem::onUpdateDirectoryRequest);
-            m_watcher->startMonitor();
+            m_model->requestUpdate();
+
+            startChildrenWatcher();
         });
     }
 
     enumerator->prepare();
 }
 
+void FileItem::startChildrenWatcher()
+{
+    auto watcher = std::make_shared<FileWatcher>(this->m_info->uri());
+    directoryState()->watcher = watcher;
+    watcher->setMonitorChildrenChange(true);
+    connect(watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
+        //add new item to m_children
+        //tell the model update
+        //the thumbnail is created after the info is queried, see flushChildEvents().
+        this->onChildAdded(uri);
+        Q_EMIT this->childAdded(uri);
+    });
+    connect(watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
+        //remove the crosponding child
+        //tell the model update
+        this->onChildRemoved(uri);
+        Q_EMIT this->childRemoved(uri);
+    });
+    connect(watcher.get(), &FileWatcher::fileChanged, this, &FileItem::onChildChanged);
+    //a thumbnail only changes the decoration, the info is not queried again.
+    connect(watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
+        auto index = m_model->indexFromUri(uri);
+        m_model->dataChanged(index, index, QVector<int>()<<Qt::DecorationRole);
+    });
+    connect(watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
+        //clean all the children, if item index is root index, cd up.
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->deleted(uri);
+        this->onDeleted(uri);
+    });
+    connect(watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri) {
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->renamed(oldUri, newUri);
+        this->onRenamed(oldUri, newUri);
+    });
+
+    connect(watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
+        m_model->setRootUri("computer:///");
+    });
+    connect(watcher.get(), &FileWatcher::requestUpdateDirectory, this, &FileItem::onUpdateDirectoryRequest);
+    watcher->startMonitor();
+
+    //the pending thumbnails can be notified now.
+    if (m_model->m_root_item == this)
+        m_model->startVisibleThumbnails();
+}
+
+void FileItem::requestChildrenThumbnails(const QStringList &uris)
+{
+    if (m_model->m_root_item == this) {
+        m_model->requestThumbnails(uris);
+        return;
+    }
+
+    auto watcher = childrenWatcher();
+    for (auto uri : uris) {
+        ThumbnailManager::getInstance()->createThumbnail(uri, watcher, false, m_model->ioCancellationGroup()->token());
+    }
+}
+
+void FileItem::saveChildrenSnapshot()
+{
+    if (!m_directory || !m_directory->children_loaded || !m_info)
+        return;
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto child : m_children) {
+        infos<<child->m_info;
+    }
+    DirectorySnapshotCache::getInstance()->insert(m_info->uri(), infos);
+}
+
+void FileItem::restoreChildren(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    Q_EMIT m_model->findChildrenStarted();
+    m_expanded = true;
+    for (auto info : infos) {
+        appendChild(new FileItem(info, this, m_model));
+    }
+    directoryState()->children_loaded = true;
+}
+
+void FileItem::reconcileRestoredChildren(const std::shared_ptr<DirectorySnapshot> &snapshot)
+{
+    Q_EMIT m_model->findChildrenFinished();
+    m_model->requestUpdate();
+
+    startChildrenWatcher();
+    QStringList uris;
+    for (auto child : m_children) {
+        uris<<child->uri();
+    }
+    requestChildrenThumbnails(uris);
+
+    //only the changes happened while the snapshot was cached need
+    //to be refreshed, if they were recorded.
+    if (snapshot->isMonitored()) {
+        updateChildrenInfosAsync(snapshot->changedUris());
+    } else {
+        onUpdateDirectoryRequest();
+    }
+}
+
+void FileItem::scheduleFlushPendingChildren()
+{
+    auto state = directoryState();
+    if (state->flush_children_scheduled || state->pending_children_uris.isEmpty())
+        return;
+
+    int delay = PEONY_FILE_ITEM_FRAME_INTERVAL;
+    if (!state->first_children_flushed) {
+        if (state->pending_children_uris.count() >= PEONY_FILE_ITEM_FIRST_PAINT_COUNT) {
+            delay = 0;
+        } else {
+            delay = qMax(qint64(0), PEONY_FILE_ITEM_FIRST_PAINT_DEADLINE - state->find_children_timer.elapsed());
+        }
+    }
+
+    state->flush_children_scheduled = true;
+    QTimer::singleShot(delay, this, &FileItem::flushPendingChildren);
+}
+
+void FileItem::flushPendingChildren()
+{
+    auto state = directoryState();
+    state->flush_children_scheduled = false;
+    if (state->pending_children_uris.isEmpty())
+        return;
+
+    QStringList uris;
+    uris.swap(state->pending_children_uris);
+
+    //the infos have been filled by enumerator.
+    int row = m_children.count();
+    m_model->beginInsertRows(firstColumnIndex(), row, row + uris.count() - 1);
+    for (auto uri : uris) {
+        appendChild(new FileItem(FileInfo::fromUri(uri), this, m_model));
+    }
+    m_model->endInsertRows();
+    state->first_children_flushed = true;
+
+    m_model->requestUpdate();
+    requestChildrenThumbnails(uris);
+}
+
 QModelIndex FileItem::firstColumnIndex()
 {
     return m_model->firstColumnIndex(this);
@@ -380,52 +403,227 @@ QModelIndex FileItem::lastColumnIndex()
 
 bool FileItem::hasChildren()
 {
-    //qDebug()<<"has children"<<m_info->uri()<<(m_info->isDir() || m_info->isVolume() || m_children->count() > 0);
-    return m_info->isDir() || m_info->isVolume() || m_children->count() > 0;
+    //qDebug()<<"has children"<<m_info->uri()<<(m_info->isDir() || m_info->isVolume() || m_children.count() > 0);
+    return m_info->isDir() || m_info->isVolume() || m_children.count() > 0;
 }
 
 FileItem *FileItem::getChildFromUri(QString uri)
 {
-    for (auto item : *m_children) {
-        QUrl url = uri;
-        QString decodedUri = url.toDisplayString();
-        if (decodedUri == item->uri())
-            return item;
+    QUrl url = uri;
+    QString decodedUri = url.toDisplayString();
+    if (!m_directory)
+        return nullptr;
+    auto item = m_directory->children_hash.value(decodedUri);
+    if (!item)
+        item = m_directory->children_hash.value(uri);
+    return item;
+}
+
+void FileItem::appendChild(FileItem *child)
+{
+    auto state = directoryState();
+    child->m_row = m_children.count();
+    if (state->first_dirty_row == child->m_row)
+        state->first_dirty_row++;
+    m_children.append(child);
+    state->children_hash.insert(child->uri(), child);
+}
+
+void FileItem::removeChild(FileItem *child)
+{
+    int row = rowOfChild(child);
+    if (row < 0)
+        return;
+
+    //a found row means the state has been created by appendChild().
+    auto state = m_directory.get();
+    m_children.remove(row);
+    auto it = state->children_hash.find(child->uri());
+    if (it != state->children_hash.end() && it.value() == child)
+        state->children_hash.erase(it);
+    child->m_row = -1;
+    state->first_dirty_row = qMin(state->first_dirty_row, row);
+}
+
+int FileItem::rowOfChild(FileItem *child)
+{
+    if (!child || child->m_parent != this || !m_directory)
+        return -1;
+
+    auto state = m_directory.get();
+    int row = child->m_row;
+    if (row < 0 || row >= state->first_dirty_row) {
+        for (int i = state->first_dirty_row; i < m_children.count(); i++) {
+            m_children.at(i)->m_row = i;
+        }
+        state->first_dirty_row = m_children.count();
+        row = child->m_row;
     }
-    return nullptr;
+
+    if (row < 0 || row >= m_children.count() || m_children.at(row) != child)
+        return -1;
+    return row;
 }
 
 void FileItem::onChildAdded(const QString &uri)
 {
-    qDebug()<<"add child:" << uri;
-    FileItem *child = getChildFromUri(uri);
-    if (child) {
-        qDebug()<<"has added";
-        //child info maybe changed, so need sync update again
-        child->updateInfoSync();
-        m_model->updated();
+    auto state = directoryState();
+    if (!state->child_event_added.contains(uri))
+        state->child_event_uris<<uri;
+    state->child_event_added.insert(uri, true);
+    scheduleFlushChildEvents();
+}
+
+void FileItem::onChildRemoved(const QString &uri)
+{
+    auto state = directoryState();
+    if (!state->child_event_added.contains(uri))
+        state->child_event_uris<<uri;
+    state->child_event_added.insert(uri, false);
+    scheduleFlushChildEvents();
+}
+
+void FileItem::scheduleFlushChildEvents()
+{
+    auto state = directoryState();
+    if (state->flush_child_events_scheduled)
         return;
+
+    state->flush_child_events_scheduled = true;
+    QTimer::singleShot(PEONY_FILE_ITEM_FRAME_INTERVAL, this, &FileItem::flushChildEvents);
+}
+
+void FileItem::flushChildEvents()
+{
+    auto state = directoryState();
+    state->flush_child_events_scheduled = false;
+
+    QStringList uris;
+    uris.swap(state->child_event_uris);
+    QHash<QString, bool> added;
+    added.swap(state->child_event_added);
+
+    QStringList addedUris;
+    QStringList changedUris;
+    QList<FileItem *> removedChildren;
+    for (auto uri : uris) {
+        FileItem *child = getChildFromUri(uri);
+        if (added.value(uri)) {
+            //child info maybe changed, so need update again.
+            if (child) {
+                changedUris<<child->uri();
+            } else {
+                addedUris<<uri;
+            }
+        } else {
+            state->adding_uris.remove(uri);
+            if (child)
+                removedChildren<<child;
+        }
     }
-    FileItem *newChild = new FileItem(FileInfo::fromUri(uri), this, m_model);
-    m_model->beginInsertRows(this->firstColumnIndex(), m_children->count(), m_children->count());
-    m_children->append(newChild);
-    m_model->endInsertRows();
-    //use sync update here.
-    newChild->updateInfoSync();
-    m_model->updated();
+
+    if (!removedChildren.isEmpty()) {
+        removeChildrenItems(removedChildren);
+        m_model->requestUpdate();
+    }
+    if (!changedUris.isEmpty()) {
+        updateChildrenInfosAsync(changedUris);
+        requestChildrenThumbnails(changedUris);
+    }
+    if (!addedUris.isEmpty())
+        insertChildrenAsync(addedUris);
 }
 
-void FileItem::onChildRemoved(const QString &uri)
+void FileItem::insertChildrenAsync(const QStringList &uris)
 {
-    FileItem *child = getChildFromUri(uri);
-    if (child) {
-        int index = m_children->indexOf(child);
-        m_model->beginRemoveRows(this->firstColumnIndex(), index, index);
-        m_children->removeOne(child);
-        delete child;
+    auto state = directoryState();
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto uri : uris) {
+        if (state->adding_uris.contains(uri))
+            continue;
+        state->adding_uris<<uri;
+        infos<<FileInfo::fromUri(uri);
+    }
+    if (infos.isEmpty())
+        return;
+
+    auto job = new FileInfoBatchJob(infos, this);
+    job->setAutoDelete();
+    connect(job, &FileInfoBatchJob::infosUpdated, this, [=](const QVector<std::shared_ptr<FileInfo>> &updatedInfos) {
+        QList<FileItem *> items;
+        for (auto info : updatedInfos) {
+            //removed while querying.
+            if (!directoryState()->adding_uris.remove(info->uri()))
+                continue;
+            if (getChildFromUri(info->uri()))
+                continue;
+            items<<new FileItem(info, this, m_model);
+        }
+        if (items.isEmpty())
+            return;
+
+        int row = m_children.count();
+        m_model->beginInsertRows(firstColumnIndex(), row, row + items.count() - 1);
+        for (auto item : items) {
+            appendChild(item);
+        }
+        m_model->endInsertRows();
+        m_model->requestUpdate();
+
+        QStringList uris;
+        for (auto item : items) {
+            uris<<item->uri();
+        }
+        requestChildrenThumbnails(uris);
+    });
+    connect(job, &FileInfoBatchJob::queryAsyncFinished, this, [=]() {
+        //the files failed to query are not existed any more.
+        for (auto info : infos) {
+            directoryState()->adding_uris.remove(info->uri());
+        }
+    });
+    job->queryAsync();
+}
+
+void FileItem::removeChildrenItems(const QList<FileItem *> &children)
+{
+    QList<int> rows;
+    for (auto child : children) {
+        int row = rowOfChild(child);
+        if (row >= 0)
+            rows<<row;
+    }
+    if (rows.isEmpty())
+        return;
+
+    //remove from the last range, so that the rows before it are not moved.
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    auto state = directoryState();
+    auto parentIndex = firstColumnIndex();
+    int i = 0;
+    while (i < rows.count()) {
+        int last = rows.at(i);
+        int first = last;
+        i++;
+        while (i < rows.count() && rows.at(i) == first - 1) {
+            first = rows.at(i);
+            i++;
+        }
+
+        m_model->beginRemoveRows(parentIndex, first, last);
+        QVector<FileItem *> removedItems = m_children.mid(first, last - first + 1);
+        m_children.remove(first, last - first + 1);
+        for (auto item : removedItems) {
+            auto it = state->children_hash.find(item->uri());
+            if (it != state->children_hash.end() && it.value() == item)
+                state->children_hash.erase(it);
+            delete item;
+        }
+        state->first_dirty_row = qMin(state->first_dirty_row, first);
         m_model->endRemoveRows();
     }
-    m_model->updated();
 }
 
 void FileItem::onDeleted(const QString &thisUri)
@@ -440,13 +638,13 @@ void FileItem::onDeleted(const QString &thisUri)
     //doublue clicked twice it will be expanded. a qt's bug?
     if (m_parent) {
         if (m_parent->m_info->uri() == thisUri) {
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_parent->rowOfChild(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
         } else {
             //if just clear children, there will be a small problem.
             clearChildren();
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_parent->rowOfChild(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
             m_parent->onChildAdded(m_info->uri());
         }
         this->deleteLater();
@@ -464,7 +662,7 @@ void FileItem::onDeleted(const QString &thisUri)
             m_model->setRootUri("file:///");
         }
     }
-    m_model->updated();
+    m_model->requestUpdate();
 }
 
 void FileItem::onRenamed(const QString &oldUri, const QString &newUri)
@@ -479,37 +677,198 @@ void FileItem::onRenamed(const QString &oldUri, const QString &newUri)
 
 void FileItem::onUpdateDirectoryRequest()
 {
-    m_backend_enumerator->disconnect();
-    m_backend_enumerator->cancel();
-
-    m_backend_enumerator->setEnumerateDirectory(m_model->getRootUri());
-    m_backend_enumerator->connect(m_backend_enumerator, &FileEnumerator::enumerateFinished, this, [=](){
-        auto currentUris = m_backend_enumerator->getChildrenUris();
-        QStringList rawUris;
-        QStringList removedUris;
-        QStringList addedUris;
-        for (auto child : *m_model->m_root_item->m_children) {
-            if (!currentUris.contains(child->uri())) {
-                removedUris<<child->uri();
-                m_model->m_root_item->onChildRemoved(child->uri());
-            }
-            rawUris<<child->uri();
+    //only the directories not support monitoring need it.
+    auto state = directoryState();
+    if (!state->backend_enumerator) {
+        state->backend_enumerator = new FileEnumerator(this);
+    }
+    auto enumerator = state->backend_enumerator;
+    enumerator->disconnect();
+    enumerator->cancel();
+
+    enumerator->setEnumerateDirectory(m_model->getRootUri());
+    enumerator->setQueryFullInfo();
+    enumerator->connect(enumerator, &FileEnumerator::enumerateFinished, this, [=](){
+        m_model->m_root_item->applyChildrenListing(enumerator->getChildren());
+    });
+
+    enumerator->enumerateAsync();
+}
+
+void FileItem::applyChildrenListing(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    QSet<QString> currentUris;
+    for (auto info : infos) {
+        currentUris<<info->uri();
+    }
+
+    QSet<QString> rawUris;
+    QStringList removedUris;
+    for (auto child : m_children) {
+        if (!currentUris.contains(child->uri())) {
+            removedUris<<child->uri();
         }
+        rawUris<<child->uri();
+    }
+    QList<FileItem *> removedChildren;
+    for (auto uri : removedUris) {
+        auto child = getChildFromUri(uri);
+        if (child)
+            removedChildren<<child;
+    }
+    removeChildrenItems(removedChildren);
 
-        for (auto uri : currentUris) {
-            if (!rawUris.contains(uri)) {
-                addedUris<<uri;
-                m_model->m_root_item->onChildAdded(uri);
-            }
+    //the infos have been filled by enumerator, insert the new children
+    //at once and refresh the existed children with one dataChanged().
+    QList<FileItem *> addedItems;
+    QStringList existedUris;
+    for (auto info : infos) {
+        if (!rawUris.contains(info->uri())) {
+            addedItems<<new FileItem(info, this, m_model);
+        } else {
+            existedUris<<info->uri();
+        }
+    }
+
+    if (!addedItems.isEmpty()) {
+        int row = m_children.count();
+        m_model->beginInsertRows(firstColumnIndex(), row, row + addedItems.count() - 1);
+        for (auto item : addedItems) {
+            appendChild(item);
         }
+        m_model->endInsertRows();
+    }
 
-        for (auto uri : currentUris) {
-            if (!addedUris.contains(uri) && !removedUris.contains(uri))
-                m_model->m_root_item->getChildFromUri(uri)->updateInfoAsync();
+    notifyChildrenDataChanged(existedUris);
+    m_model->requestUpdate();
+}
+
+void FileItem::revalidateStaleChildren()
+{
+    auto enumerator = new FileEnumerator;
+    enumerator->setEnumerateDirectory(m_info->uri());
+    enumerator->setQueryFullInfo();
+    enumerator->setCancellationGroup(m_model->ioCancellationGroup());
+    enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
+    enumerator->connect(enumerator, &FileEnumerator::prepared, this, [=](std::shared_ptr<GErrorWrapper> err, const QString &targetUri, bool critical) {
+        if (critical || (err && targetUri.isNull())) {
+            //the location is not reachable now, keep the stale listing.
+            qDebug()<<"revalidate failed"<<(err? err->message(): QString());
+            enumerator->cancel();
+            return;
+        }
+        if (!targetUri.isNull() && targetUri != this->uri())
+            enumerator->setEnumerateDirectory(targetUri);
+        enumerator->enumerateAsync();
+    });
+    enumerator->connect(enumerator, &FileEnumerator::enumerateFinished, this, [=](bool successed) {
+        if (successed) {
+            //clear the stale mark before refreshing the children.
+            m_model->m_is_stale = false;
+            applyChildrenListing(enumerator->getChildren());
+            Q_EMIT m_model->listingStaleChanged(false);
+            saveChildrenListing();
+            startChildrenWatcher();
         }
+        Q_EMIT m_model->findChildrenFinished();
+        enumerator->deleteLater();
     });
 
-    m_backend_enumerator->enumerateAsync();
+    //let the stale listing be painted before preparing.
+    QTimer::singleShot(0, enumerator, [=]() {
+        enumerator->prepare();
+    });
+}
+
+void FileItem::saveChildrenListing()
+{
+    if (!m_directory || !m_directory->children_loaded || !m_info)
+        return;
+
+    auto cache = PersistentListingCache::getInstance();
+    if (!cache->isEnabledForUri(m_info->uri()))
+        return;
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto child : m_children) {
+        infos<<child->m_info;
+    }
+    cache->save(m_info->uri(), infos);
+}
+
+void FileItem::onChildChanged(const QString &uri)
+{
+    auto state = directoryState();
+    if (state->changed_children_uris.contains(uri))
+        return;
+
+    state->changed_children_uris<<uri;
+    if (state->changed_children_uris.count() > 1)
+        return;
+
+    QTimer::singleShot(0, this, [=]() {
+        QStringList uris;
+        uris.swap(directoryState()->changed_children_uris);
+        updateChildrenInfosAsync(uris);
+    });
+}
+
+void FileItem::updateChildrenInfosAsync(const QStringList &uris)
+{
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto uri : uris) {
+        auto child = getChildFromUri(uri);
+        if (child)
+            infos<<child->info();
+    }
+    if (infos.isEmpty())
+        return;
+
+    auto job = new FileInfoBatchJob(infos, this);
+    job->setAutoDelete();
+    connect(job, &FileInfoBatchJob::infosUpdated, this, [=](const QVector<std::shared_ptr<FileInfo>> &updatedInfos) {
+        QStringList updatedUris;
+        for (auto info : updatedInfos) {
+            updatedUris<<info->uri();
+            if (info->isDesktopFile()) {
+                ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), childrenWatcher());
+            }
+        }
+        notifyChildrenDataChanged(updatedUris);
+    });
+    job->queryAsync();
+}
+
+void FileItem::notifyChildrenDataChanged(const QStringList &uris)
+{
+    QList<int> rows;
+    for (auto uri : uris) {
+        auto child = getChildFromUri(uri);
+        if (!child)
+            continue;
+        int row = rowOfChild(child);
+        if (row >= 0)
+            rows<<row;
+    }
+    if (rows.isEmpty())
+        return;
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    //a range over sparse rows would make the views refresh the unchanged rows
+    //between them, so send one dataChanged() for every run of adjacent rows.
+    int i = 0;
+    while (i < rows.count()) {
+        int first = rows.at(i);
+        int last = first;
+        i++;
+        while (i < rows.count() && rows.at(i) == last + 1) {
+            last = rows.at(i);
+            i++;
+        }
+        m_model->dataChanged(m_children.at(first)->firstColumnIndex(), m_children.at(last)->lastColumnIndex());
+    }
 }
 
 void FileItem::updateInfoSync()
@@ -535,11 +894,19 @@ void FileItem::clearChildren()
 {
     auto parent = firstColumnIndex();
     m_model->removeRows(0, m_model->rowCount(parent), parent);
-    for (auto child : *m_children) {
+    for (auto child : m_children) {
         delete child;
     }
-    m_children->clear();
+    m_children.clear();
     m_expanded = false;
-    m_watcher.reset();
-    m_watcher = nullptr;
+    //the scheduled flushes and the backend enumerator still use the state.
+    if (m_directory) {
+        m_directory->children_hash.clear();
+        m_directory->first_dirty_row = 0;
+        m_directory->child_event_uris.clear();
+        m_directory->child_event_added.clear();
+        m_directory->adding_uris.clear();
+        m_directory->children_loaded = false;
+        m_directory->watcher.reset();
+    }
 }
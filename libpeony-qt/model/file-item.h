@@ -28,15 +28,135 @@
 
 #include <QObject>
 #include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QElapsedTimer>
+
+/*!
+ * \brief PEONY_FILE_ITEM_FIRST_PAINT_DEADLINE
+ * The max time in milliseconds from starting finding children to showing
+ * the first found children in the view.
+ */
+#ifndef PEONY_FILE_ITEM_FIRST_PAINT_DEADLINE
+#define PEONY_FILE_ITEM_FIRST_PAINT_DEADLINE 100
+#endif
+
+/*!
+ * \brief PEONY_FILE_ITEM_FIRST_PAINT_COUNT
+ * Show the first found children immediately once there are enough of them
+ * to fill a screen.
+ */
+#ifndef PEONY_FILE_ITEM_FIRST_PAINT_COUNT
+#define PEONY_FILE_ITEM_FIRST_PAINT_COUNT 100
+#endif
+
+/*!
+ * \brief PEONY_FILE_ITEM_FRAME_INTERVAL
+ * After the first paint, the found children are merged into model at most
+ * once in this interval.
+ */
+#ifndef PEONY_FILE_ITEM_FRAME_INTERVAL
+#define PEONY_FILE_ITEM_FRAME_INTERVAL 16
+#endif
 
 namespace Peony {
 
 class FileInfo;
+class FileItemSortKey;
+struct FileItemFilterKey;
 class FileInfoManager;
 class FileItemModel;
 class FileWatcher;
 class FileItemProxyFilterSortModel;
 class FileEnumerator;
+class DirectorySnapshot;
+class FileItem;
+
+/*!
+ * \brief The FileItemDirectoryState struct
+ * <br>
+ * The children index, the monitor and the pending child events of a FileItem.
+ * Only the items whose children were found need them.
+ * </br>
+ */
+struct FileItemDirectoryState
+{
+    /*!
+     * \brief children_hash
+     * The children indexed by their uris.
+     */
+    QHash<QString, FileItem*> children_hash;
+    /*!
+     * \brief first_dirty_row
+     * The rows from this one should be renumbered before lookups.
+     */
+    int first_dirty_row = 0;
+    /*!
+     * \brief children_loaded
+     * True if all the children have been found.
+     */
+    bool children_loaded = false;
+
+    std::shared_ptr<FileWatcher> watcher;
+
+    /*!
+     * \brief backend_enumerator
+     * \note
+     * only used in directory not support monitor, it is created
+     * at the first onUpdateDirectoryRequest().
+     */
+    FileEnumerator *backend_enumerator = nullptr;
+
+    /*!
+     * \brief changed_children_uris
+     * The changed children waiting for refreshing.
+     * \see FileItem::onChildChanged().
+     */
+    QStringList changed_children_uris;
+
+    /*!
+     * \brief pending_children_uris
+     * The found children waiting for inserting into model.
+     * \see FileItem::scheduleFlushPendingChildren().
+     */
+    QStringList pending_children_uris;
+    QElapsedTimer find_children_timer;
+    bool first_children_flushed = false;
+    bool flush_children_scheduled = false;
+
+    /*!
+     * \brief child_event_uris
+     * The uris of the collected child events, in the order they first happened.
+     * \see FileItem::onChildAdded().
+     */
+    QStringList child_event_uris;
+    /*!
+     * \brief child_event_added
+     * The last event of every collected uri, true for an addition.
+     */
+    QHash<QString, bool> child_event_added;
+    bool flush_child_events_scheduled = false;
+    /*!
+     * \brief adding_uris
+     * The new children whose infos are being queried. A removal happened
+     * before the query finished cancels the insertion.
+     */
+    QSet<QString> adding_uris;
+};
+
+/*!
+ * \brief The FileItemKeys struct
+ * <br>
+ * The keys FileItemProxyFilterSortModel computed from the info of an item,
+ * they are dropped when the data of the item changed.
+ * </br>
+ */
+struct FileItemKeys
+{
+    std::shared_ptr<FileItemSortKey> sort_key;
+    std::shared_ptr<FileItemFilterKey> filter_key;
+};
 
 /*!
  * \brief The FileItem class
@@ -100,12 +220,32 @@ Q_SIGNALS:
     void renamed(const QString &oldUri, const QString &newUri);
 
 public Q_SLOTS:
+    /*!
+     * \brief onChildAdded
+     * \param uri
+     * <br>
+     * The additions and removals of children are not applied at once. They are
+     * collected and applied once a frame, the removals in contiguous row ranges,
+     * and the additions in one insertion after their infos are queried.
+     * </br>
+     * \see flushChildEvents().
+     */
     void onChildAdded(const QString &uri);
     void onChildRemoved(const QString &uri);
     void onDeleted(const QString &thisUri);
     void onRenamed(const QString &oldUri, const QString &newUri);
 
     void onUpdateDirectoryRequest();
+    /*!
+     * \brief onChildChanged
+     * \param uri
+     * <br>
+     * The changes of children happened in a same event loop iteration are
+     * collected and refreshed by one FileInfoBatchJob.
+     * </br>
+     * \see updateChildrenInfosAsync().
+     */
+    void onChildChanged(const QString &uri);
 
     void clearChildren();
 
@@ -117,9 +257,42 @@ protected:
      * \note
      * This is ususally used when fileCreated() and fileDeleted() happend,
      * and item must has parent item.
+     * <br>
+     * The children are indexed by their uris, so this is a hash lookup.
+     * </br>
      */
     FileItem *getChildFromUri(QString uri);
 
+    /*!
+     * \brief appendChild
+     * \param child
+     * <br>
+     * Append the child to m_children and index it. This doesn't tell the model,
+     * the callers should send the row signals themselves.
+     * </br>
+     * \note All the changes of m_children should go through appendChild()
+     * and removeChild(), otherwise the indexes will be broken.
+     */
+    void appendChild(FileItem *child);
+    /*!
+     * \brief removeChild
+     * \param child
+     * <br>
+     * Remove the child from m_children and the indexes, the child is not deleted.
+     * </br>
+     */
+    void removeChild(FileItem *child);
+    /*!
+     * \brief rowOfChild
+     * \param child
+     * \return the row of child in m_children, or -1 if it is not a child of this item.
+     * <br>
+     * The row is kept in the child. A removal only marks the rows after it as dirty,
+     * they are renumbered at the next lookup, so a batch of removals costs one pass.
+     * </br>
+     */
+    int rowOfChild(FileItem *child);
+
     /*!
      * \brief updateInfoSync
      * <br>
@@ -140,33 +313,188 @@ protected:
      */
     void updateInfoAsync();
 
-private:
-    FileItem *m_parent = nullptr;
-    std::shared_ptr<Peony::FileInfo> m_info;
-    QVector<FileItem*> *m_children = nullptr;
+    /*!
+     * \brief updateChildrenInfosAsync
+     * \param uris
+     * <br>
+     * Query the children infos in a FileInfoBatchJob, and tell the model
+     * once for every updated chunk.
+     * </br>
+     */
+    void updateChildrenInfosAsync(const QStringList &uris);
+    /*!
+     * \brief notifyChildrenDataChanged
+     * \param uris
+     * <br>
+     * Send one dataChanged() for every run of adjacent rows of the children.
+     * </br>
+     */
+    void notifyChildrenDataChanged(const QStringList &uris);
 
-    FileItemModel *m_model = nullptr;
+    /*!
+     * \brief scheduleFlushPendingChildren
+     * <br>
+     * Schedule a flush of the found children. The first flush happens when
+     * there are a screen of children or the first paint deadline reached,
+     * the following ones happen once a frame.
+     * </br>
+     * \see PEONY_FILE_ITEM_FIRST_PAINT_DEADLINE, PEONY_FILE_ITEM_FRAME_INTERVAL.
+     */
+    void scheduleFlushPendingChildren();
+    /*!
+     * \brief flushPendingChildren
+     * <br>
+     * Insert all the pending children into model with a single insertion.
+     * </br>
+     */
+    void flushPendingChildren();
 
-    bool m_expanded = false;
+    /*!
+     * \brief scheduleFlushChildEvents
+     * Schedule a flush of the collected child events in next frame.
+     */
+    void scheduleFlushChildEvents();
+    /*!
+     * \brief flushChildEvents
+     * <br>
+     * Apply the last event of every collected uri. The removed children are
+     * removed at once, the existed ones are refreshed in a FileInfoBatchJob,
+     * and the new ones are inserted by insertChildrenAsync().
+     * </br>
+     */
+    void flushChildEvents();
+    /*!
+     * \brief insertChildrenAsync
+     * \param uris
+     * <br>
+     * Query the infos of the new children in a FileInfoBatchJob, and insert
+     * every updated chunk into model with a single insertion.
+     * </br>
+     */
+    void insertChildrenAsync(const QStringList &uris);
+    /*!
+     * \brief removeChildrenItems
+     * \param children
+     * <br>
+     * Remove and delete the children, with one removal for every contiguous row range.
+     * </br>
+     */
+    void removeChildrenItems(const QList<FileItem *> &children);
 
-    std::shared_ptr<FileWatcher> m_watcher = nullptr;
+    /*!
+     * \brief startChildrenWatcher
+     * <br>
+     * Monitor the changes of the children after they were found.
+     * </br>
+     */
+    void startChildrenWatcher();
 
     /*!
-     * \brief m_async_count
+     * \brief requestChildrenThumbnails
      * <br>
-     * when enumerate children finished, we start a async job for update children info.
-     * this count is record the current last un-updated children count.
-     * while all job finished, the count will clear, and we can insert the rows to model.
+     * The thumbnails of the root's children are created by the views' visible
+     * window first, see FileItemModel::setVisibleUris(). The ones of the expanded
+     * children are created at once.
      * </br>
      */
-    int m_async_count = 0;
+    void requestChildrenThumbnails(const QStringList &uris);
 
     /*!
-     * \brief m_backend_enumerator
-     * \note
-     * only used in directory not support monitor.
+     * \brief saveChildrenSnapshot
+     * <br>
+     * Put the loaded children into DirectorySnapshotCache, it is called
+     * when the model leaves this directory.
+     * </br>
+     */
+    void saveChildrenSnapshot();
+    /*!
+     * \brief restoreChildren
+     * \param infos
+     * <br>
+     * Fill the children with the cached infos without sending any row
+     * signal. This should be called during a model reset.
+     * </br>
+     * \see FileItemModel::setRootItem().
+     */
+    void restoreChildren(const QList<std::shared_ptr<FileInfo>> &infos);
+    /*!
+     * \brief reconcileRestoredChildren
+     * \param snapshot
+     * <br>
+     * Finish the restoring after model reset. Start monitoring and refresh
+     * the children changed while the snapshot was cached. If the changes
+     * were not recorded, the directory is re-enumerated for the differences.
+     * </br>
+     */
+    void reconcileRestoredChildren(const std::shared_ptr<DirectorySnapshot> &snapshot);
+
+    /*!
+     * \brief revalidateStaleChildren
+     * <br>
+     * The children were restored from PersistentListingCache and might be
+     * out of date. Enumerate the directory in background, apply the
+     * differences, and then clear the stale state.
+     * </br>
+     * \see FileItemModel::isListingStale().
      */
-    FileEnumerator *m_backend_enumerator;
+    void revalidateStaleChildren();
+    /*!
+     * \brief applyChildrenListing
+     * \param infos, the current children found by an enumerator.
+     * <br>
+     * Remove the children not existed any more, insert the new ones at once,
+     * and refresh the existed ones with a single dataChanged().
+     * </br>
+     */
+    void applyChildrenListing(const QList<std::shared_ptr<FileInfo>> &infos);
+    /*!
+     * \brief saveChildrenListing
+     * <br>
+     * Save the loaded children into PersistentListingCache, if the cache
+     * is enabled for this location.
+     * </br>
+     */
+    void saveChildrenListing();
+
+private:
+    /*!
+     * \brief directoryState
+     * \return the children state of this item, it is created at the first call.
+     */
+    FileItemDirectoryState *directoryState();
+    /*!
+     * \brief childrenWatcher
+     * \return the monitor of the children, or nullptr if they are not monitored.
+     */
+    std::shared_ptr<FileWatcher> childrenWatcher() const;
+
+    FileItem *m_parent = nullptr;
+    std::shared_ptr<Peony::FileInfo> m_info;
+    QVector<FileItem*> m_children;
+
+    /*!
+     * \brief m_directory
+     * The state only a directory with children needs. Most items in a large
+     * directory are plain files, so it is allocated at the first use.
+     * \see directoryState().
+     */
+    std::unique_ptr<FileItemDirectoryState> m_directory;
+    /*!
+     * \brief m_keys
+     * Created by FileItemProxyFilterSortModel at first comparison or filtering.
+     */
+    std::unique_ptr<FileItemKeys> m_keys;
+
+    FileItemModel *m_model = nullptr;
+
+    /*!
+     * \brief m_row
+     * The row of this item in its parent's m_children.
+     * \see rowOfChild().
+     */
+    int m_row = -1;
+
+    bool m_expanded = false;
 };
 
 }
@@ -4,8 +4,13 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     $$PWD/file-item.h \
+    $$PWD/directory-snapshot-cache.h \
+    $$PWD/persistent-listing-cache.h \
     $$PWD/file-item-model.h \
     $$PWD/file-item-proxy-filter-sort-model.h \
+    $$PWD/file-item-sort-key.h \
+    $$PWD/file-item-columns.h \
+    $$PWD/file-item-filter-predicate.h \
     $$PWD/file-label-model.h \
     $$PWD/side-bar-abstract-item.h \
     $$PWD/side-bar-model.h \
@@ -19,8 +24,13 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/file-item.cpp \
+    $$PWD/directory-snapshot-cache.cpp \
+    $$PWD/persistent-listing-cache.cpp \
     $$PWD/file-item-model.cpp \
     $$PWD/file-item-proxy-filter-sort-model.cpp \
+    $$PWD/file-item-sort-key.cpp \
+    $$PWD/file-item-columns.cpp \
+    $$PWD/file-item-filter-predicate.cpp \
     $$PWD/file-label-model.cpp \
     $$PWD/side-bar-abstract-item.cpp \
     $$PWD/side-bar-model.cpp \
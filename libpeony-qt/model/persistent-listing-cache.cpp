@@ -0,0 +1,378 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "persistent-listing-cache.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "global-settings.h"
+#include "io-executor.h"
+
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+#include <QHash>
+
+#include <QDebug>
+
+#include <gio/gio.h>
+
+#define PEONY_LISTING_CACHE_MAGIC "PLC1"
+#define PEONY_LISTING_CACHE_VERSION 1
+
+using namespace Peony;
+
+static PersistentListingCache *global_instance = nullptr;
+
+namespace {
+
+enum ListingString {
+    ChildUri,
+    DisplayName,
+    ContentType,
+    IconName,
+    SymbolicIconName,
+    ListingStringCount
+};
+
+enum ListingFlag {
+    IsSymbolLink = 1 << 0,
+    IsVirtual = 1 << 1,
+    CanRead = 1 << 2,
+    CanWrite = 1 << 3,
+    CanExecute = 1 << 4,
+    CanDelete = 1 << 5,
+    CanTrash = 1 << 6,
+    CanRename = 1 << 7,
+    CanMount = 1 << 8,
+    CanUnmount = 1 << 9,
+    CanEject = 1 << 10,
+    CanStart = 1 << 11,
+    CanStop = 1 << 12
+};
+
+/*!
+ * \brief The ListingHeader struct
+ * The header at the beginning of a cache file. Offsets of strings are
+ * relative to the string table.
+ */
+struct ListingHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 count;
+    quint32 strings_offset;
+    quint32 strings_size;
+    quint32 uri_offset;
+    quint32 uri_length;
+    quint32 reserved;
+    qint64 saved_time;
+};
+
+/*!
+ * \brief The ListingEntry struct
+ * A fixed size entry of a child, the entry table follows the header.
+ */
+struct ListingEntry
+{
+    quint64 size;
+    quint64 modified_time;
+    quint64 access_time;
+    quint32 file_type;
+    quint32 flags;
+    quint32 string_offsets[ListingStringCount];
+    quint32 string_lengths[ListingStringCount];
+};
+
+/*!
+ * \brief The StringTableWriter class
+ * Append strings into a table, the same string is stored only once.
+ */
+class StringTableWriter
+{
+public:
+    void append(const QString &string, quint32 &offset, quint32 &length) {
+        QByteArray utf8 = string.toUtf8();
+        length = quint32(utf8.size());
+        auto it = m_offsets.constFind(utf8);
+        if (it != m_offsets.constEnd()) {
+            offset = it.value();
+            return;
+        }
+        offset = quint32(m_table.size());
+        m_offsets.insert(utf8, offset);
+        m_table.append(utf8);
+    }
+    const QByteArray &table() {
+        return m_table;
+    }
+
+private:
+    QByteArray m_table;
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+}
+
+static void set_boolean(GFileInfo *info, const char *attribute, quint32 flags, quint32 flag)
+{
+    g_file_info_set_attribute_boolean(info, attribute, (flags & flag)? TRUE: FALSE);
+}
+
+PersistentListingCache *PersistentListingCache::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new PersistentListingCache;
+    }
+    return global_instance;
+}
+
+PersistentListingCache::PersistentListingCache(QObject *parent) : QObject(parent)
+{
+    m_cache_dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/peony-qt/listing";
+}
+
+PersistentListingCache::~PersistentListingCache()
+{
+
+}
+
+bool PersistentListingCache::isEnabledForUri(const QString &uri)
+{
+    auto schemes = GlobalSettings::getInstance()->getValue(PERSISTENT_LISTING_CACHE_SCHEMES).toStringList();
+    if (schemes.isEmpty())
+        return false;
+
+    return schemes.contains(QUrl(uri).scheme());
+}
+
+const QString PersistentListingCache::cacheFilePath(const QString &uri)
+{
+    auto hash = QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_cache_dir + "/" + hash + ".listing";
+}
+
+const QList<std::shared_ptr<FileInfo>> PersistentListingCache::load(const QString &uri)
+{
+    QList<std::shared_ptr<FileInfo>> infos;
+
+    QFile file(cacheFilePath(uri));
+    if (!file.open(QIODevice::ReadOnly))
+        return infos;
+
+    qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(ListingHeader)))
+        return infos;
+
+    uchar *data = file.map(0, fileSize);
+    if (!data)
+        return infos;
+
+    auto header = reinterpret_cast<const ListingHeader *>(data);
+    bool valid = memcmp(header->magic, PEONY_LISTING_CACHE_MAGIC, 4) == 0 &&
+            header->version == PEONY_LISTING_CACHE_VERSION &&
+            qint64(sizeof(ListingHeader)) + qint64(header->count)*qint64(sizeof(ListingEntry)) <= qint64(header->strings_offset) &&
+            qint64(header->strings_offset) + qint64(header->strings_size) <= fileSize &&
+            qint64(header->uri_offset) + qint64(header->uri_length) <= qint64(header->strings_size);
+
+    qint64 age = QDateTime::currentSecsSinceEpoch() - header->saved_time;
+    if (!valid || age > PEONY_LISTING_CACHE_MAX_AGE) {
+        file.unmap(data);
+        file.close();
+        file.remove();
+        return infos;
+    }
+
+    auto strings = reinterpret_cast<const char *>(data + header->strings_offset);
+    //the hash of uri might collide, check the uri itself.
+    if (QString::fromUtf8(strings + header->uri_offset, int(header->uri_length)) != uri) {
+        file.unmap(data);
+        return infos;
+    }
+
+    auto entries = reinterpret_cast<const ListingEntry *>(data + sizeof(ListingHeader));
+    for (quint32 i = 0; i < header->count; i++) {
+        const ListingEntry &entry = entries[i];
+        QString values[ListingStringCount];
+        bool entryValid = true;
+        for (int j = 0; j < ListingStringCount; j++) {
+            if (qint64(entry.string_offsets[j]) + qint64(entry.string_lengths[j]) > qint64(header->strings_size)) {
+                entryValid = false;
+                break;
+            }
+            values[j] = QString::fromUtf8(strings + entry.string_offsets[j], int(entry.string_lengths[j]));
+        }
+        if (!entryValid || values[ChildUri].isEmpty())
+            continue;
+
+        auto info = FileInfo::fromUri(values[ChildUri]);
+        infos<<info;
+        //do not overwrite the infos which have been loaded by others.
+        if (info->isLoaded())
+            continue;
+
+        GFileInfo *gInfo = g_file_info_new();
+        g_file_info_set_file_type(gInfo, GFileType(entry.file_type));
+        g_file_info_set_display_name(gInfo, values[DisplayName].toUtf8().constData());
+        if (!values[ContentType].isEmpty())
+            g_file_info_set_content_type(gInfo, values[ContentType].toUtf8().constData());
+        if (!values[IconName].isEmpty()) {
+            GIcon *icon = g_themed_icon_new(values[IconName].toUtf8().constData());
+            g_file_info_set_icon(gInfo, icon);
+            g_object_unref(icon);
+        }
+        if (!values[SymbolicIconName].isEmpty()) {
+            GIcon *icon = g_themed_icon_new(values[SymbolicIconName].toUtf8().constData());
+            g_file_info_set_symbolic_icon(gInfo, icon);
+            g_object_unref(icon);
+        }
+        g_file_info_set_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_STANDARD_SIZE, entry.size);
+        g_file_info_set_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED, entry.modified_time);
+        g_file_info_set_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_TIME_ACCESS, entry.access_time);
+
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK, entry.flags, IsSymbolLink);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL, entry.flags, IsVirtual);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, entry.flags, CanRead);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, entry.flags, CanWrite);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, entry.flags, CanExecute);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE, entry.flags, CanDelete);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH, entry.flags, CanTrash);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME, entry.flags, CanRename);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT, entry.flags, CanMount);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT, entry.flags, CanUnmount);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_EJECT, entry.flags, CanEject);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_START, entry.flags, CanStart);
+        set_boolean(gInfo, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_STOP, entry.flags, CanStop);
+
+        FileInfoJob::refreshInfoContents(info, gInfo);
+        g_object_unref(gInfo);
+    }
+
+    file.unmap(data);
+    return infos;
+}
+
+void PersistentListingCache::save(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children)
+{
+    QByteArray entryTable;
+    StringTableWriter strings;
+
+    ListingHeader header;
+    memset(&header, 0, sizeof(ListingHeader));
+    memcpy(header.magic, PEONY_LISTING_CACHE_MAGIC, 4);
+    header.version = PEONY_LISTING_CACHE_VERSION;
+    header.saved_time = QDateTime::currentSecsSinceEpoch();
+    strings.append(uri, header.uri_offset, header.uri_length);
+
+    for (auto info : children) {
+        if (!info->isLoaded())
+            continue;
+
+        ListingEntry entry;
+        memset(&entry, 0, sizeof(ListingEntry));
+        entry.size = info->size();
+        entry.modified_time = info->modifiedTime();
+        entry.access_time = info->accessTime();
+        entry.file_type = info->isDir()? G_FILE_TYPE_DIRECTORY: info->isVolume()? G_FILE_TYPE_MOUNTABLE: G_FILE_TYPE_REGULAR;
+
+        quint32 flags = 0;
+        flags |= info->isSymbolLink()? IsSymbolLink: 0;
+        flags |= info->isVirtual()? IsVirtual: 0;
+        flags |= info->canRead()? CanRead: 0;
+        flags |= info->canWrite()? CanWrite: 0;
+        flags |= info->canExecute()? CanExecute: 0;
+        flags |= info->canDelete()? CanDelete: 0;
+        flags |= info->canTrash()? CanTrash: 0;
+        flags |= info->canRename()? CanRename: 0;
+        flags |= info->canMount()? CanMount: 0;
+        flags |= info->canUnmount()? CanUnmount: 0;
+        flags |= info->canEject()? CanEject: 0;
+        flags |= info->canStart()? CanStart: 0;
+        flags |= info->canStop()? CanStop: 0;
+        entry.flags = flags;
+
+        strings.append(info->uri(), entry.string_offsets[ChildUri], entry.string_lengths[ChildUri]);
+        strings.append(info->displayName(), entry.string_offsets[DisplayName], entry.string_lengths[DisplayName]);
+        strings.append(info->type(), entry.string_offsets[ContentType], entry.string_lengths[ContentType]);
+        strings.append(info->iconName(), entry.string_offsets[IconName], entry.string_lengths[IconName]);
+        strings.append(info->symbolicIconName(), entry.string_offsets[SymbolicIconName], entry.string_lengths[SymbolicIconName]);
+
+        entryTable.append(reinterpret_cast<const char *>(&entry), sizeof(ListingEntry));
+        header.count++;
+    }
+
+    header.strings_offset = quint32(sizeof(ListingHeader) + entryTable.size());
+    header.strings_size = quint32(strings.table().size());
+
+    QByteArray data;
+    data.reserve(int(header.strings_offset + header.strings_size));
+    data.append(reinterpret_cast<const char *>(&header), sizeof(ListingHeader));
+    data.append(entryTable);
+    data.append(strings.table());
+
+    QString path = cacheFilePath(uri);
+    IoExecutor::getInstance()->submit(IoExecutor::Background, [=]() {
+        QMutexLocker locker(&m_mutex);
+        QDir().mkpath(m_cache_dir);
+        QSaveFile file(path);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(data);
+            file.commit();
+        }
+        locker.unlock();
+        evict();
+    });
+}
+
+void PersistentListingCache::remove(const QString &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    QFile::remove(cacheFilePath(uri));
+}
+
+void PersistentListingCache::evict()
+{
+    QMutexLocker locker(&m_mutex);
+    QDir dir(m_cache_dir);
+    //the least recently used ones are at the end.
+    auto files = dir.entryInfoList(QStringList()<<"*.listing", QDir::Files, QDir::Time);
+
+    auto now = QDateTime::currentDateTime();
+    qint64 totalSize = 0;
+    QFileInfoList kept;
+    for (auto file : files) {
+        if (file.lastModified().secsTo(now) > PEONY_LISTING_CACHE_MAX_AGE) {
+            QFile::remove(file.absoluteFilePath());
+            continue;
+        }
+        totalSize += file.size();
+        kept<<file;
+    }
+
+    while (totalSize > PEONY_LISTING_CACHE_MAX_SIZE && !kept.isEmpty()) {
+        auto file = kept.takeLast();
+        totalSize -= file.size();
+        QFile::remove(file.absoluteFilePath());
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PERSISTENTLISTINGCACHE_H
+#define PERSISTENTLISTINGCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QMutex>
+
+#include <memory>
+
+/*!
+ * \brief PEONY_LISTING_CACHE_MAX_AGE
+ * The max age in seconds of a cached listing, the older ones are evicted.
+ */
+#ifndef PEONY_LISTING_CACHE_MAX_AGE
+#define PEONY_LISTING_CACHE_MAX_AGE 7*24*60*60
+#endif
+
+/*!
+ * \brief PEONY_LISTING_CACHE_MAX_SIZE
+ * The max total size in bytes of the cache directory, the least recently
+ * used listings are evicted when exceeded.
+ */
+#ifndef PEONY_LISTING_CACHE_MAX_SIZE
+#define PEONY_LISTING_CACHE_MAX_SIZE 32*1024*1024
+#endif
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The PersistentListingCache class
+ * <br>
+ * PersistentListingCache saves the listings of directories on slow remote
+ * locations, such as smb://, sftp:// or mtp://, into the user's cache
+ * directory. When one of these directories is opened again, the model shows
+ * the last known listing immediately and marks it as stale, then enumerates
+ * the directory in background and applies the differences.
+ * </br>
+ * <br>
+ * Every listing is stored in its own file named by the hash of the uri.
+ * The file is a header, a fixed size entry table and a string table, it is
+ * read through a memory map without any parsing pass. Strings shared by many
+ * entries, such as content types and icon names, are stored only once.
+ * </br>
+ * <br>
+ * The cache is opt-in, it is only used for the schemes listed in the
+ * PERSISTENT_LISTING_CACHE_SCHEMES global setting.
+ * </br>
+ * \see FileItemModel::setRootItem(), FileItem::revalidateStaleChildren().
+ */
+class PEONYCORESHARED_EXPORT PersistentListingCache : public QObject
+{
+    Q_OBJECT
+public:
+    static PersistentListingCache *getInstance();
+
+    /*!
+     * \brief isEnabledForUri
+     * \param uri
+     * \return true if the scheme of the uri is enabled in global settings.
+     */
+    bool isEnabledForUri(const QString &uri);
+
+    /*!
+     * \brief load
+     * \param uri
+     * \return the cached children infos of the directory, or an empty list.
+     * \note The infos which have been loaded by others are kept as they are,
+     * the others are filled with the cached data.
+     */
+    const QList<std::shared_ptr<FileInfo>> load(const QString &uri);
+    /*!
+     * \brief save
+     * \param uri
+     * \param children
+     * <br>
+     * Serialize the loaded children infos, and write them into the cache
+     * file in a worker thread. The eviction is done after writing.
+     * </br>
+     */
+    void save(const QString &uri, const QList<std::shared_ptr<FileInfo>> &children);
+    void remove(const QString &uri);
+
+    const QString cacheDirectory() {
+        return m_cache_dir;
+    }
+
+public Q_SLOTS:
+    /*!
+     * \brief evict
+     * <br>
+     * Remove the listings older than PEONY_LISTING_CACHE_MAX_AGE, then remove
+     * the least recently used ones until the total size is less than
+     * PEONY_LISTING_CACHE_MAX_SIZE.
+     * </br>
+     */
+    void evict();
+
+protected:
+    const QString cacheFilePath(const QString &uri);
+
+private:
+    explicit PersistentListingCache(QObject *parent = nullptr);
+    ~PersistentListingCache();
+
+    QString m_cache_dir;
+    QMutex m_mutex;
+};
+
+}
+
+#endif // PERSISTENTLISTINGCACHE_H
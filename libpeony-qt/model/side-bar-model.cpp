@@ -269,6 +269,10 @@ void SideBarModel::onIndexUpdated(const QModelIndex &index)
     bool isEmpty = true;
     for (auto child : *item->m_children) {
         auto info = FileInfo::fromUri(child->uri());
+        if (!info->isFileTypeResolved()) {
+            FileInfoJob j(info);
+            j.querySync();
+        }
         if (!info->displayName().startsWith(".") && (info->isDir() || info->isVolume()))
             isEmpty = false;
         if (child->type() == SideBarAbstractItem::SeparatorItem) {
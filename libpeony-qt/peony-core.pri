@@ -3,8 +3,10 @@ INCLUDEPATH += $$PWD
 HEADERS += $$PWD/peony-core_global.h \
            $$PWD/file-info.h \
            $$PWD/file-info-job.h \
+           $$PWD/file-info-batch-job.h \
            $$PWD/file-info-manager.h \
            $$PWD/file-enumerator.h \
+           $$PWD/local-directory-reader.h \
            $$PWD/mount-operation.h \
            $$PWD/file-watcher.h \
            $$PWD/connect-server-dialog.h \
@@ -13,14 +15,20 @@ HEADERS += $$PWD/peony-core_global.h \
     $$PWD/gobject-template.h \
     $$PWD/file-utils.h \
     $$PWD/thumbnail-manager.h \
+    $$PWD/theme-icon-cache.h \
+    $$PWD/icon-pixmap-cache.h \
+    $$PWD/desktop-entry-cache.h \
+    $$PWD/io-executor.h \
     $$PWD/linux-pwd-helper.h \
     $$PWD/file-meta-info.h \
     $$PWD/bookmark-manager.h
 
 SOURCES += $$PWD/file-info.cpp \
            $$PWD/file-info-job.cpp \
+           $$PWD/file-info-batch-job.cpp \
            $$PWD/file-info-manager.cpp \
            $$PWD/file-enumerator.cpp \
+           $$PWD/local-directory-reader.cpp \
            $$PWD/mount-operation.cpp \
            $$PWD/file-watcher.cpp \
            $$PWD/connect-server-dialog.cpp \
@@ -29,6 +37,10 @@ SOURCES += $$PWD/file-info.cpp \
     $$PWD/gobject-template.cpp \
     $$PWD/file-utils.cpp \
     $$PWD/thumbnail-manager.cpp \
+    $$PWD/theme-icon-cache.cpp \
+    $$PWD/icon-pixmap-cache.cpp \
+    $$PWD/desktop-entry-cache.cpp \
+    $$PWD/io-executor.cpp \
     $$PWD/linux-pwd-helper.cpp \
     $$PWD/file-meta-info.cpp \
     $$PWD/bookmark-manager.cpp
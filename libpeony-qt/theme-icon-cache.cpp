@@ -0,0 +1,159 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "theme-icon-cache.h"
+
+#include <QMutexLocker>
+
+using namespace Peony;
+
+static ThemeIconCache *global_instance = nullptr;
+
+/*!
+ * \brief firstThemedName
+ * \return the first name of icon which exists in current theme.
+ */
+static QString firstThemedName(GIcon *icon)
+{
+    if (!G_IS_THEMED_ICON(icon))
+        return nullptr;
+
+    const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON(icon));
+    if (!icon_names)
+        return nullptr;
+
+    for (auto p = icon_names; *p; p++) {
+        if (QIcon::hasThemeIcon(*p))
+            return *p;
+    }
+    return nullptr;
+}
+
+ThemeIconCache *ThemeIconCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new ThemeIconCache;
+    return global_instance;
+}
+
+ThemeIconCache::ThemeIconCache(QObject *parent) : QObject(parent)
+{
+    m_theme_name = QIcon::themeName();
+}
+
+void ThemeIconCache::checkTheme()
+{
+    QString themeName = QIcon::themeName();
+    if (themeName == m_theme_name)
+        return;
+
+    m_theme_name = themeName;
+    m_name_chains.clear();
+    m_content_types.clear();
+    m_symbolic_content_types.clear();
+    m_icons.clear();
+}
+
+void ThemeIconCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_name_chains.clear();
+    m_content_types.clear();
+    m_symbolic_content_types.clear();
+    m_icons.clear();
+}
+
+QString ThemeIconCache::themedIconName(GIcon *icon)
+{
+    if (!G_IS_THEMED_ICON(icon))
+        return nullptr;
+
+    const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON(icon));
+    if (!icon_names)
+        return nullptr;
+
+    QString key;
+    for (auto p = icon_names; *p; p++) {
+        key.append(*p);
+        key.append('\n');
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        checkTheme();
+        auto it = m_name_chains.constFind(key);
+        if (it != m_name_chains.constEnd())
+            return *it;
+    }
+
+    QString iconName = firstThemedName(icon);
+
+    QMutexLocker locker(&m_mutex);
+    m_name_chains.insert(key, iconName);
+    return iconName;
+}
+
+QString ThemeIconCache::contentTypeIconName(const QString &contentType, bool symbolic)
+{
+    if (contentType.isEmpty())
+        return nullptr;
+
+    auto &hash = symbolic? m_symbolic_content_types: m_content_types;
+    {
+        QMutexLocker locker(&m_mutex);
+        checkTheme();
+        auto it = hash.constFind(contentType);
+        if (it != hash.constEnd())
+            return *it;
+    }
+
+    QString iconName;
+    QByteArray type = contentType.toUtf8();
+    if (symbolic) {
+        GIcon *icon = g_content_type_get_symbolic_icon(type.constData());
+        if (G_IS_THEMED_ICON(icon)) {
+            const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON(icon));
+            if (icon_names && *icon_names)
+                iconName = *icon_names;
+        }
+        g_object_unref(icon);
+    } else {
+        GIcon *icon = g_content_type_get_icon(type.constData());
+        iconName = themedIconName(icon);
+        g_object_unref(icon);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    hash.insert(contentType, iconName);
+    return iconName;
+}
+
+const QIcon ThemeIconCache::icon(const QString &iconName)
+{
+    QMutexLocker locker(&m_mutex);
+    checkTheme();
+    auto it = m_icons.constFind(iconName);
+    if (it != m_icons.constEnd())
+        return *it;
+
+    QIcon icon = QIcon::fromTheme(iconName, QIcon::fromTheme("text-x-generic"));
+    m_icons.insert(iconName, icon);
+    return icon;
+}
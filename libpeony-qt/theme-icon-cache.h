@@ -0,0 +1,108 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef THEMEICONCACHE_H
+#define THEMEICONCACHE_H
+
+#include <QObject>
+#include "peony-core_global.h"
+
+#include <QHash>
+#include <QIcon>
+#include <QMutex>
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The ThemeIconCache class
+ * <br>
+ * ThemeIconCache resolves the icon names of files against the current icon
+ * theme once, and shares the result in the whole process. Most of the files
+ * in a directory share a few content types, so a listing only does one theme
+ * lookup for every distinct type (or GIcon name chain), instead of one for
+ * every file.
+ * </br>
+ * <br>
+ * The cache is keyed by the theme name, it is dropped when QIcon::themeName()
+ * changes, so a theme switching never returns the icons of the old theme.
+ * </br>
+ * \note The cache is thread safe, but QIcon should be only used in gui thread.
+ */
+class PEONYCORESHARED_EXPORT ThemeIconCache : public QObject
+{
+    Q_OBJECT
+public:
+    static ThemeIconCache *getInstance();
+
+    /*!
+     * \brief themedIconName
+     * \param icon, a GThemedIcon.
+     * \return the first name of icon which exists in current theme, or a null string.
+     */
+    QString themedIconName(GIcon *icon);
+    /*!
+     * \brief contentTypeIconName
+     * \param contentType
+     * \param symbolic
+     * \return the icon name of the content type, the same as themedIconName()
+     * of g_content_type_get_icon(). If symbolic is true, return the first name of
+     * g_content_type_get_symbolic_icon() without checking the theme.
+     */
+    QString contentTypeIconName(const QString &contentType, bool symbolic = false);
+
+    /*!
+     * \brief icon
+     * \param iconName
+     * \return the shared QIcon::fromTheme(iconName, QIcon::fromTheme("text-x-generic")).
+     * <br>
+     * QIcon caches the pixmaps it rendered, so sharing one QIcon in all the
+     * items with a same icon also shares the rendered pixmaps.
+     * </br>
+     */
+    const QIcon icon(const QString &iconName);
+
+public Q_SLOTS:
+    void clear();
+
+protected:
+    /*!
+     * \brief checkTheme
+     * Drop the cache if the icon theme changed. It must be called with m_mutex locked.
+     */
+    void checkTheme();
+
+private:
+    explicit ThemeIconCache(QObject *parent = nullptr);
+
+    QString m_theme_name;
+
+    QHash<QString, QString> m_name_chains;
+    QHash<QString, QString> m_content_types;
+    QHash<QString, QString> m_symbolic_content_types;
+    QHash<QString, QIcon> m_icons;
+
+    QMutex m_mutex;
+};
+
+}
+
+#endif // THEMEICONCACHE_H
@@ -34,15 +34,14 @@
 #include "thumbnail-job.h"
 
 #include "global-settings.h"
+#include "desktop-entry-cache.h"
 
-#include <QtConcurrent>
 #include <QIcon>
 #include <QUrl>
 
-#include <QThreadPool>
 #include <QSemaphore>
 
-#include <gio/gdesktopappinfo.h>
+#include <gio/gio.h>
 
 using namespace Peony;
 
@@ -63,9 +62,6 @@ ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
 {
     GlobalSettings::getInstance();
 
-    m_thumbnail_thread_pool = new QThreadPool(this);
-    m_thumbnail_thread_pool->setMaxThreadCount(1);
-
     m_semaphore = new QSemaphore(1);
 }
 
@@ -101,6 +97,8 @@ void ThumbnailManager::setForbidThumbnailInView(bool forbid)
 
 void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
 {
+    QMutexLocker locker(&m_thumbnailer_mutex);
+
     auto settings = GlobalSettings::getInstance();
     if (settings->isExist("do-not-thumbnail")) {
         bool do_not_thumbnail = settings->getValue("do-not-thumbnail").toBool();
@@ -130,7 +128,7 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
                 if (watcher) {
-                    watcher->fileChanged(uri);
+                    watcher->thumbnailUpdated(uri);
                 }
                 //info->setThumbnail(thumbnail);
                 //m_mutex.unlock();
@@ -157,7 +155,7 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
                 if (watcher) {
-                    watcher->fileChanged(uri);
+                    watcher->thumbnailUpdated(uri);
                 }
                 //info->setThumbnail(thumbnail);
                 //m_mutex.unlock();
@@ -175,21 +173,18 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 qDebug()<<url;
             }
 
-            auto _desktop_file = g_desktop_app_info_new_from_filename(url.path().toUtf8().constData());
-            if (!_desktop_file) {
+            auto _desktop_entry = DesktopEntryCache::getInstance()->entry(url.path());
+            if (!_desktop_entry || !_desktop_entry->is_valid) {
                 return;
             }
-            auto _icon_string = g_desktop_app_info_get_string(_desktop_file, "Icon");
-            thumbnail = QIcon::fromTheme(_icon_string);
-            qDebug()<<_icon_string;
-            QString string = _icon_string;
+            QString string = _desktop_entry->icon;
+            thumbnail = QIcon::fromTheme(string);
+            qDebug()<<string;
             if (thumbnail.isNull() && string.startsWith("/")) {
                 qDebug()<<"add file";
-                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+                QIcon thumbnail = GenericThumbnailer::generateThumbnail(string, true);
                 //thumbnail.addFile(_icon_string);
             }
-            g_free(_icon_string);
-            g_object_unref(_desktop_file);
 
             if (!thumbnail.isNull()) {
                 //add lock
@@ -200,7 +195,7 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
                 if (watcher) {
-                    watcher->fileChanged(uri);
+                    watcher->thumbnailUpdated(uri);
                 }
                 //info->setThumbnail(thumbnail);
                 //m_mutex.unlock();
@@ -209,10 +204,11 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
     }
 }
 
-void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
+void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force,
+                                       const IoCancellationToken &token, IoExecutor::Priority priority)
 {
     auto thumbnailJob = new ThumbnailJob(uri, watcher, this);
-    m_thumbnail_thread_pool->start(thumbnailJob);
+    IoExecutor::getInstance()->start(thumbnailJob, priority, token);
 }
 
 void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
@@ -223,7 +219,8 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
         //get desktop file icon.
         //async
         qDebug()<<"desktop file"<<uri;
-        QtConcurrent::run([=]() {
+        IoExecutor::getInstance()->submit(IoExecutor::VisibleThumbnail, [=]() {
+            QMutexLocker locker(&m_thumbnailer_mutex);
             QIcon thumbnail;
             QUrl url = uri;
             qDebug()<<url;
@@ -232,18 +229,18 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
                 qDebug()<<url;
             }
 
-            auto _desktop_file = g_desktop_app_info_new_from_filename(url.path().toUtf8().constData());
-            auto _icon_string = g_desktop_app_info_get_string(_desktop_file, "Icon");
-            thumbnail = QIcon::fromTheme(_icon_string);
-            qDebug()<<_icon_string;
-            QString string = _icon_string;
+            auto _desktop_entry = DesktopEntryCache::getInstance()->entry(url.path());
+            if (!_desktop_entry || !_desktop_entry->is_valid) {
+                return;
+            }
+            QString string = _desktop_entry->icon;
+            thumbnail = QIcon::fromTheme(string);
+            qDebug()<<string;
             if (thumbnail.isNull() && string.startsWith("/")) {
                 qDebug()<<"add file";
-                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+                QIcon thumbnail = GenericThumbnailer::generateThumbnail(string, true);
                 //thumbnail.addFile(_icon_string);
             }
-            g_free(_icon_string);
-            g_object_unref(_desktop_file);
 
             if (!thumbnail.isNull()) {
                 //add lock
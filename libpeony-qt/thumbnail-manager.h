@@ -26,12 +26,12 @@
 #include <QObject>
 #include "peony-core_global.h"
 #include "file-info.h"
+#include "io-executor.h"
 
 #include <QHash>
 #include <QIcon>
 #include <QMutex>
 
-class QThreadPool;
 class QSemaphore;
 
 namespace Peony {
@@ -51,7 +51,23 @@ public:
         return !m_hash.values(uri).isEmpty();
     }
 
-    void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
+    /*!
+     * \brief createThumbnail
+     * \param uri
+     * \param watcher
+     * \param force
+     * \param token, the thumbnail is dropped if the token is cancelled before it started,
+     * such as the view navigated away.
+     * \param priority
+     * <br>
+     * The thumbnails are created by IoExecutor in the IoExecutor::VisibleThumbnail class
+     * by default, the ones out of the views' visible window use IoExecutor::Prefetch.
+     * Only one thumbnail is created at a time, see m_thumbnailer_mutex.
+     * </br>
+     */
+    void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false,
+                         const IoCancellationToken &token = IoCancellationToken(),
+                         IoExecutor::Priority priority = IoExecutor::VisibleThumbnail);
     void releaseThumbnail(const QString &uri);
     void updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr);
     const QIcon tryGetThumbnail(const QString &uri);
@@ -72,7 +88,14 @@ private:
     QHash<QString, QIcon> m_hash;
     //QMutex m_mutex;
 
-    QThreadPool *m_thumbnail_thread_pool;
+    /*!
+     * \brief m_thumbnailer_mutex
+     * The thumbnailers build QPixmap and QIcon in worker threads, which Qt does not
+     * support concurrently. The visible and the prefetch thumbnails are created one
+     * at a time, until the thumbnailers produce QImage instead.
+     */
+    QMutex m_thumbnailer_mutex;
+
     QSemaphore *m_semaphore;
 };
 
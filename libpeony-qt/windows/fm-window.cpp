@@ -43,6 +43,7 @@
 #include "file-utils.h"
 #include "file-operation-utils.h"
 #include "file-info.h"
+#include "file-info-job.h"
 
 #include "file-operation-manager.h"
 
@@ -844,6 +845,10 @@ void FMWindow::keyPressEvent(QKeyEvent *e)
                 QStringList dirs;
                 for (auto uri : selections) {
                     auto info = FileInfo::fromUri(uri);
+                    if (!info->isFileTypeResolved()) {
+                        FileInfoJob j(info);
+                        j.querySync();
+                    }
                     if (info->isDir() || info->isVolume()) {
                         dirs<<uri;
                     } else {
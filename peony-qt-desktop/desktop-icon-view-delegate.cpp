@@ -29,6 +29,7 @@
 #include "file-rename-operation.h"
 
 #include "icon-view-delegate.h"
+#include "icon-pixmap-cache.h"
 
 #include <QPushButton>
 #include <QWidget>
@@ -121,7 +122,13 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
     auto text = opt.text;
     opt.text = nullptr;
 
+    //the decoration is blitted from IconPixmapCache instead of being rasterized by the style.
+    QIcon decoration = opt.icon;
+    opt.icon = QIcon();
     style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+    auto decorationRect = style->subElementRect(QStyle::SE_ItemViewItemDecoration, &opt, opt.widget);
+    Peony::IconPixmapCache::getInstance()->paintDecoration(painter, decoration, decorationRect, opt);
+    opt.icon = decoration;
 
     opt.text = text;
 
@@ -193,8 +200,7 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
         topRight.setX(topRight.x() - offset - symbolicIconSize.width());
         topRight.setY(topRight.y() + offset);
         auto linkRect = QRect(topRight, symbolicIconSize);
-        QIcon symbolicLinkIcon = QIcon::fromTheme("emblem-symbolic-link");
-        symbolicLinkIcon.paint(painter, linkRect, Qt::AlignCenter);
+        Peony::IconPixmapCache::getInstance()->paintEmblem(painter, "emblem-symbolic-link", linkRect);
     }
 
     /*
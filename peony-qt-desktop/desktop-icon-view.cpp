@@ -25,6 +25,8 @@
 
 #include "icon-view-style.h"
 #include "desktop-icon-view-delegate.h"
+#include "icon-view-delegate.h"
+#include "icon-pixmap-cache.h"
 
 #include "desktop-item-model.h"
 #include "desktop-item-proxy-model.h"
@@ -910,6 +912,10 @@ void DesktopIconView::setDefaultZoomLevel(ZoomLevel level)
 {
     //qDebug()<<"set default zoom level:"<<level;
     m_zoom_level = level;
+    //the labels are wrapped with new width and font.
+    Peony::DirectoryView::IconViewTextHelper::clearCache();
+    //the decorations are rasterized with new size.
+    Peony::IconPixmapCache::getInstance()->clear();
     switch (level) {
     case Small:
         setIconSize(QSize(24, 24));
@@ -1086,6 +1092,10 @@ void DesktopIconView::dropEvent(QDropEvent *e)
         auto index = indexAt(e->pos());
         if (index.isValid()) {
             auto info = FileInfo::fromUri(index.data(Qt::UserRole).toString());
+            if (!info->isFileTypeResolved()) {
+                FileInfoJob j(info);
+                j.querySync();
+            }
             if (!info->isDir())
                 return;
         }
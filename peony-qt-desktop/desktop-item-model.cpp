@@ -25,6 +25,7 @@
 #include "file-enumerator.h"
 #include "file-info.h"
 #include "file-info-job.h"
+#include "file-info-batch-job.h"
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-operation-manager.h"
@@ -33,6 +34,7 @@
 #include "file-copy-operation.h"
 
 #include "thumbnail-manager.h"
+#include "theme-icon-cache.h"
 
 #include "file-meta-info.h"
 
@@ -56,11 +58,11 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
 {
     m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///, this");
 
-    connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
+    connect(m_thumbnail_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
         for (auto info : m_files) {
             if (info->uri() == uri) {
                 auto index = indexFromUri(uri);
-                Q_EMIT this->dataChanged(index, index);
+                Q_EMIT this->dataChanged(index, index, QVector<int>()<<Qt::DecorationRole);
             }
         }
     });
@@ -276,24 +278,45 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
     });
 
     this->connect(m_desktop_watcher.get(), &FileWatcher::fileChanged, [=](const QString &uri) {
-        auto view = PeonyDesktopApplication::getIconView();
-        auto itemRectHash = view->getCurrentItemRects();
+        if (!indexFromUri(uri).isValid() || m_changed_uris.contains(uri))
+            return;
 
-        for (auto info : m_files) {
-            if (info->uri() == uri) {
-                auto job = new FileInfoJob(info);
-                job->setAutoDelete();
-                connect(job, &FileInfoJob::infoUpdated, this, [=]() {
-                    ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
-                    this->dataChanged(indexFromUri(uri), indexFromUri(uri));
-                    Q_EMIT this->requestClearIndexWidget();
+        //refresh the changes happened in a same event loop iteration together.
+        m_changed_uris<<uri;
+        if (m_changed_uris.count() > 1)
+            return;
 
-                });
-                job->queryAsync();
-                this->dataChanged(indexFromUri(uri), indexFromUri(uri));
-                return;
+        QTimer::singleShot(0, this, [=]() {
+            QList<std::shared_ptr<FileInfo>> infos;
+            for (auto info : m_files) {
+                if (m_changed_uris.contains(info->uri()))
+                    infos<<info;
             }
-        }
+            m_changed_uris.clear();
+
+            auto job = new FileInfoBatchJob(infos, this);
+            //the desktop is small and always visible, don't defer the sniffing.
+            job->setSniffContentType();
+            job->setAutoDelete();
+            connect(job, &FileInfoBatchJob::infosUpdated, this, [=](const QVector<std::shared_ptr<FileInfo>> &updatedInfos) {
+                int firstRow = -1;
+                int lastRow = -1;
+                for (auto info : updatedInfos) {
+                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+                    int row = m_files.indexOf(info);
+                    if (row < 0)
+                        continue;
+                    if (firstRow < 0 || row < firstRow)
+                        firstRow = row;
+                    if (row > lastRow)
+                        lastRow = row;
+                }
+                if (firstRow >= 0)
+                    this->dataChanged(index(firstRow), index(lastRow));
+                Q_EMIT this->requestClearIndexWidget();
+            });
+            job->queryAsync();
+        });
     });
 
     //when system app uninstalled, delete link in desktop if exist
@@ -361,6 +384,10 @@ DesktopItemModel::~DesktopItemModel()
 void DesktopItemModel::refresh()
 {
     ThumbnailManager::getInstance()->syncThumbnailPreferences();
+    if (m_enumerated_infos_job) {
+        m_enumerated_infos_job->cancel();
+        m_enumerated_infos_job = nullptr;
+    }
     beginResetModel();
     //removeRows(0, m_files.count());
     FileInfoManager::getInstance()->clear();
@@ -406,11 +433,11 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
         auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(info->uri());
         if (!thumbnail.isNull()) {
             if (info->uri().endsWith(".desktop") && !info->canExecute()) {
-                return QIcon::fromTheme(info->iconName(), QIcon::fromTheme("text-x-generic"));
+                return ThemeIconCache::getInstance()->icon(info->iconName());
             }
             return thumbnail;
         }
-        return QIcon::fromTheme(info->iconName(), QIcon::fromTheme("text-x-generic"));
+        return ThemeIconCache::getInstance()->icon(info->iconName());
     }
     case UriRole:
         return info->uri();
@@ -424,9 +451,11 @@ void DesktopItemModel::onEnumerateFinished()
 {
     //beginResetModel();
     FileInfoManager::getInstance()->clear();
-    beginRemoveRows(QModelIndex(), 0, m_files.count() - 1);
-    m_files.clear();
-    endRemoveRows();
+    if (!m_files.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, m_files.count() - 1);
+        m_files.clear();
+        endRemoveRows();
+    }
 
     auto computer = FileInfo::fromUri("computer:///", true);
     auto personal = FileInfo::fromPath(QStandardPaths::writableLocation(QStandardPaths::HomeLocation), true);
@@ -442,34 +471,47 @@ void DesktopItemModel::onEnumerateFinished()
 
     //qDebug()<<m_files.count();
     //this->endResetModel();
+    //query all the infos in one batch job, and insert them at once when it finished.
+    if (m_enumerated_infos_job)
+        m_enumerated_infos_job->cancel();
+    auto job = new FileInfoBatchJob(infos, this);
+    job->setSniffContentType();
+    job->setAutoDelete();
+    m_enumerated_infos_job = job;
+    connect(job, &FileInfoBatchJob::queryAsyncFinished, this, [=]() {
+        //a refresh started after this job, the infos are out of date.
+        if (m_enumerated_infos_job != job)
+            return;
+        m_enumerated_infos_job = nullptr;
+        this->onEnumeratedInfosQueried(infos);
+    });
+    job->queryAsync();
+}
+
+void DesktopItemModel::onEnumeratedInfosQueried(const QList<std::shared_ptr<FileInfo>> &infos)
+{
     for (auto info : infos) {
         m_info_query_queue<<info->uri();
-        beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
-        auto syncJob = new FileInfoJob(info);
-        syncJob->querySync();
-        syncJob->deleteLater();
-        m_files<<info;
+    }
+    if (!infos.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_files.count(), m_files.count() + infos.count() - 1);
+        m_files<<infos;
         endInsertRows();
-        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-
-        if (m_files.last() == info) {
-
-            for (auto info : m_files) {
-                auto uri = info->uri();
-                auto view = PeonyDesktopApplication::getIconView();
-                auto pos = view->getFileMetaInfoPos(info->uri());
-                if (pos.x() >= 0) {
-                    view->updateItemPosByUri(info->uri(), pos);
-                } else {
-                    view->ensureItemPosByUri(uri);
-                }
-            }
+    }
 
-            Q_EMIT refreshed();
+    auto view = PeonyDesktopApplication::getIconView();
+    for (auto info : m_files) {
+        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        auto pos = view->getFileMetaInfoPos(info->uri());
+        if (pos.x() >= 0) {
+            view->updateItemPosByUri(info->uri(), pos);
+        } else {
+            view->ensureItemPosByUri(info->uri());
         }
-        continue;
     }
 
+    Q_EMIT refreshed();
+
     //qDebug()<<"startMornitor";
     m_trash_watcher->startMonitor();
     m_desktop_watcher->startMonitor();
@@ -571,6 +613,11 @@ bool DesktopItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action
     }
 
     auto info = FileInfo::fromUri(destDirUri);
+    if (!info->isFileTypeResolved()) {
+        //the desktop directory itself is not an item of this model.
+        FileInfoJob j(info);
+        j.querySync();
+    }
     if (!info->isDir()) {
         return false;
     }
@@ -25,12 +25,15 @@
 
 #include <QAbstractListModel>
 #include <QQueue>
+#include <QStringList>
+#include <QPointer>
 #include <memory>
 
 namespace Peony {
 
 class FileEnumerator;
 class FileInfo;
+class FileInfoBatchJob;
 class FileWatcher;
 
 class DesktopItemModel : public QAbstractListModel
@@ -86,7 +89,10 @@ protected Q_SLOTS:
     void onEnumerateFinished();
 
 private:
+    void onEnumeratedInfosQueried(const QList<std::shared_ptr<FileInfo>> &infos);
+
     FileEnumerator *m_enumerator;
+    QPointer<FileInfoBatchJob> m_enumerated_infos_job;
     QList<std::shared_ptr<FileInfo>> m_files;
     std::shared_ptr<FileWatcher> m_trash_watcher;
     std::shared_ptr<FileWatcher> m_desktop_watcher;
@@ -97,6 +103,8 @@ private:
 
     QQueue<QString> m_info_query_queue;
     QQueue<QString> m_new_file_info_query_queue;
+
+    QStringList m_changed_uris;
 };
 
 }
@@ -25,6 +25,7 @@
 #include "directory-view-plugin-iface.h"
 
 #include "file-info.h"
+#include "file-info-job.h"
 #include "file-utils.h"
 #include "file-launch-action.h"
 #include "file-launch-manager.h"
@@ -190,6 +191,10 @@ const QList<QAction *> DesktopMenu::constructOpenOpActions()
                 QStringList files;
                 for (auto uri : m_selections) {
                     auto info = FileInfo::fromUri(uri);
+                    if (!info->isFileTypeResolved()) {
+                        FileInfoJob j(info);
+                        j.querySync();
+                    }
                     if (info->isDir() || info->isVolume()) {
                         dirs<<uri;
                     } else {
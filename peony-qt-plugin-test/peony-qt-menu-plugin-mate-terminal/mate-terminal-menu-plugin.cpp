@@ -22,6 +22,7 @@
 
 #include "mate-terminal-menu-plugin.h"
 #include "file-info.h"
+#include "file-info-job.h"
 #include <gio/gio.h>
 
 #include <QAction>
@@ -78,6 +79,10 @@ QList<QAction *> MateTerminalMenuPlugin::menuActions(Types types, const QString
         }
         if (selectionUris.count() == 1) {
             auto info = FileInfo::fromUri(selectionUris.first(), false);
+            if (!info->isFileTypeResolved()) {
+                FileInfoJob j(info);
+                j.querySync();
+            }
             if (info->isDir()) {
                 QAction *dirAction = new QAction(QIcon::fromTheme("utilities-terminal-symbolic"), tr("Open Directory in Terminal"));
                 dirAction->connect(dirAction, &QAction::triggered, [=]() {
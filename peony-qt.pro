@@ -1,6 +1,10 @@
 TEMPLATE = subdirs
 SUBDIRS = src libpeony-qt \ # plugin #libpeony-qt/test \ #plugin-iface
     #libpeony-qt/model/model-test \
+    #libpeony-qt/benchmark/file-info-memory \
+    #libpeony-qt/benchmark/file-item-memory \
+    #libpeony-qt/benchmark/local-enumeration \
+    #libpeony-qt/benchmark/sort-keys \
     #libpeony-qt/file-operation/file-operation-test \
     #peony-qt-plugin-test \
     peony-qt-desktop
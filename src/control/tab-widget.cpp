@@ -28,6 +28,7 @@
 #include "directory-view-widget.h"
 
 #include "file-info.h"
+#include "file-info-job.h"
 #include "file-launch-manager.h"
 #include "search-vfs-uri-parser.h"
 #include "properties-window.h"
@@ -764,7 +765,19 @@ void TabWidget::setPreviewPage(Peony::PreviewPageIface *previewPage)
 
 void TabWidget::addPage(const QString &uri, bool jumpTo)
 {
-    auto info = Peony::FileInfo::fromUri(uri, false);
+    auto info = Peony::FileInfo::fromUri(uri);
+    if (!info->isFileTypeResolved()) {
+        //do not block ui for querying the file type.
+        auto job = new Peony::FileInfoJob(info);
+        job->setAutoDelete();
+        //a directory always has a resolved type, so this never queries again.
+        connect(job, &Peony::FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+            if (successed && info->isDir())
+                this->addPage(uri, jumpTo);
+        });
+        job->queryFileTypeAsync();
+        return;
+    }
     qDebug() << "addPage:" <<uri <<info->isDir();
     if (! info->isDir())
         return;
@@ -956,17 +969,26 @@ void TabWidget::editUris(const QStringList &uris)
 void TabWidget::onViewDoubleClicked(const QString &uri)
 {
     qDebug()<<"tab widget double clicked"<<uri;
-    auto info = Peony::FileInfo::fromUri(uri, false);
+    auto info = Peony::FileInfo::fromUri(uri);
     if (info->uri().startsWith("trash://")) {
         auto w = new Peony::PropertiesWindow(QStringList()<<uri);
         w->show();
         return;
     }
-    if (info->isDir() || info->isVolume() || info->isVirtual()) {
-        Q_EMIT this->updateWindowLocationRequest(uri, true);
-    } else {
-        Peony::FileLaunchManager::openAsync(uri, false, false);
-    }
+    //the type is usually known by the view's model, otherwise resolve it
+    //asynchronously. check the type in callback, an unknown type stays unresolved.
+    auto job = new Peony::FileInfoJob(info);
+    job->setAutoDelete();
+    connect(job, &Peony::FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+        if (!successed)
+            return;
+        if (info->isDir() || info->isVolume() || info->isVirtual()) {
+            Q_EMIT this->updateWindowLocationRequest(uri, true);
+        } else {
+            Peony::FileLaunchManager::openAsync(uri, false, false);
+        }
+    });
+    job->queryFileTypeAsync();
 }
 
 void TabWidget::changeCurrentIndex(int index)
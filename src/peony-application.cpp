@@ -301,10 +301,15 @@ PeonyApplication::PeonyApplication(int &argc, char *argv[], const char *applicat
         connect(proxy, &Peony::DirectoryViewProxyIface::viewDoubleClicked, [=](const QString &uri) {
             qDebug()<<"app double clicked"<<uri;
             auto info = Peony::FileInfo::fromUri(uri);
-            if (info->isDir() || info->isVolume() || uri.startsWith("network:")) {
-                proxy->setDirectoryUri(uri);
-                proxy->beginLocationChange();
-            }
+            auto job = new Peony::FileInfoJob(info);
+            job->setAutoDelete();
+            job->connect(job, &Peony::FileInfoJob::queryAsyncFinished, [=]() {
+                if (info->isDir() || info->isVolume() || uri.startsWith("network:")) {
+                    proxy->setDirectoryUri(uri);
+                    proxy->beginLocationChange();
+                }
+            });
+            job->queryFileTypeAsync();
         });
 
         auto widget = dynamic_cast<QWidget*>(view);
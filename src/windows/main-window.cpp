@@ -56,6 +56,7 @@
 #include "file-operation-manager.h"
 #include "file-operation-utils.h"
 #include "file-utils.h"
+#include "file-info-job.h"
 #include "create-template-operation.h"
 #include "file-operation-error-dialog.h"
 #include "clipboard-utils.h"
@@ -585,6 +586,10 @@ void MainWindow::keyPressEvent(QKeyEvent *e)
             QStringList dirs;
             for (auto uri : selections) {
                 auto info = Peony::FileInfo::fromUri(uri);
+                if (!info->isFileTypeResolved()) {
+                    Peony::FileInfoJob j(info);
+                    j.querySync();
+                }
                 if (info->isDir() || info->isVolume()) {
                     dirs<<uri;
                 } else {